@@ -9,13 +9,15 @@
 #include "mem.h"
 #include "windows.h"
 
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 
 #if defined(CONF_FAMILY_WINDOWS)
 #include <io.h> // _get_osfhandle
-#include <windows.h> // FlushFileBuffers
+#include <windows.h> // FlushFileBuffers, MapViewOfFile
 #else
+#include <sys/mman.h> // mmap
 #include <unistd.h> // fsync
 #endif
 
@@ -246,6 +248,46 @@ int io_sync(IOHANDLE io)
 #endif
 }
 
+void *io_map(IOHANDLE io, int64_t *size)
+{
+	const int64_t length = io_length(io);
+	if(length <= 0 || (uint64_t)length > SIZE_MAX)
+	{
+		return nullptr;
+	}
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE mapping = CreateFileMappingW((HANDLE)_get_osfhandle(_fileno((FILE *)io)), nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		return nullptr;
+	}
+	void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	// the view keeps the mapping object alive
+	CloseHandle(mapping);
+	if(data == nullptr)
+	{
+		return nullptr;
+	}
+#else
+	void *data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno((FILE *)io), 0);
+	if(data == MAP_FAILED)
+	{
+		return nullptr;
+	}
+#endif
+	*size = length;
+	return data;
+}
+
+void io_unmap(void *data, int64_t size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
 int io_error(IOHANDLE io)
 {
 	return ferror((FILE *)io);
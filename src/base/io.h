@@ -235,6 +235,36 @@ int io_flush(IOHANDLE io);
  */
 int io_sync(IOHANDLE io);
 
+/**
+ * Maps the contents of a file into memory. The pages are shared with other
+ * processes mapping the same file until they are written to, writes are
+ * private to the process and never change the file.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file, may be closed after mapping.
+ * @param size Receives the size of the mapping.
+ *
+ * @return Pointer to the mapped memory, or `nullptr` on failure or if the
+ * file is empty.
+ *
+ * @remark The file must not be truncated while it is mapped, replace it by
+ * renaming a new file instead.
+ *
+ * @see io_unmap
+ */
+void *io_map(IOHANDLE io, int64_t *size);
+
+/**
+ * Unmaps memory returned by @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param data Pointer to the mapped memory.
+ * @param size Size of the mapping.
+ */
+void io_unmap(void *data, int64_t size);
+
 /**
  * Checks whether an error occurred during I/O with the file.
  *
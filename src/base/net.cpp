@@ -57,6 +57,15 @@ typedef struct
 	struct iovec iovecs[VLEN];
 	char bufs[VLEN][PACKETSIZE];
 	char sockaddrs[VLEN][128];
+
+	// packets queued by net_udp_send while a send batch is open
+	bool send_batch;
+	int send_size;
+	int send_fds[VLEN];
+	struct mmsghdr send_msgs[VLEN];
+	struct iovec send_iovecs[VLEN];
+	char send_bufs[VLEN][PACKETSIZE];
+	char send_sockaddrs[VLEN][128];
 #else
 	char buf[PACKETSIZE];
 #endif
@@ -79,6 +88,18 @@ static void net_buffer_init(NETSOCKET_BUFFER *buffer)
 		buffer->msgs[i].msg_hdr.msg_name = &(buffer->sockaddrs[i]);
 		buffer->msgs[i].msg_hdr.msg_namelen = sizeof(buffer->sockaddrs[i]);
 	}
+
+	buffer->send_batch = false;
+	buffer->send_size = 0;
+	mem_zero(buffer->send_msgs, sizeof(buffer->send_msgs));
+	mem_zero(buffer->send_iovecs, sizeof(buffer->send_iovecs));
+	for(size_t i = 0; i < VLEN; ++i)
+	{
+		buffer->send_iovecs[i].iov_base = buffer->send_bufs[i];
+		buffer->send_msgs[i].msg_hdr.msg_iov = &(buffer->send_iovecs[i]);
+		buffer->send_msgs[i].msg_hdr.msg_iovlen = 1;
+		buffer->send_msgs[i].msg_hdr.msg_name = &(buffer->send_sockaddrs[i]);
+	}
 #endif
 }
 
@@ -1007,6 +1028,76 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+static void net_udp_send_queued(NETSOCKET sock)
+{
+	NETSOCKET_BUFFER *buffer = &sock->buffer;
+	// sendmmsg can only send to one socket, the queue can contain packets
+	// for both the IPv4 and the IPv6 socket, send them one socket after the
+	// other while keeping the order per socket
+	for(int fd : {sock->ipv4sock, sock->ipv6sock})
+	{
+		if(fd < 0)
+			continue;
+
+		struct mmsghdr msgs[VLEN];
+		int num = 0;
+		for(int i = 0; i < buffer->send_size; i++)
+		{
+			if(buffer->send_fds[i] == fd)
+				msgs[num++] = buffer->send_msgs[i];
+		}
+
+		int pos = 0;
+		while(pos < num)
+		{
+			const int sent = sendmmsg(fd, &msgs[pos], num - pos, 0);
+			network_stats.sent_syscalls++;
+			// skip a packet that failed to send, like a failed sendto
+			pos += sent > 0 ? sent : 1;
+		}
+	}
+	buffer->send_size = 0;
+}
+#endif
+
+static int net_udp_sendto(NETSOCKET sock, int fd, const sockaddr *sa, socklen_t sa_len, const void *data, int size)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_BUFFER *buffer = &sock->buffer;
+	if(buffer->send_batch && size <= (int)PACKETSIZE && sa_len <= (socklen_t)sizeof(buffer->send_sockaddrs[0]))
+	{
+		if(buffer->send_size == (int)VLEN)
+			net_udp_send_queued(sock);
+
+		const int i = buffer->send_size++;
+		buffer->send_fds[i] = fd;
+		mem_copy(buffer->send_bufs[i], data, size);
+		buffer->send_iovecs[i].iov_len = size;
+		mem_copy(buffer->send_sockaddrs[i], sa, sa_len);
+		buffer->send_msgs[i].msg_hdr.msg_namelen = sa_len;
+		return size;
+	}
+#endif
+	network_stats.sent_syscalls++;
+	return sendto(fd, (const char *)data, size, 0, sa, sa_len);
+}
+
+void net_udp_send_batch_begin(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	sock->buffer.send_batch = true;
+#endif
+}
+
+void net_udp_send_batch_end(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	net_udp_send_queued(sock);
+	sock->buffer.send_batch = false;
+#endif
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
@@ -1028,7 +1119,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in(addr, &sa);
 			}
 
-			d = sendto(sock->ipv4sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			d = net_udp_sendto(sock, sock->ipv4sock, (sockaddr *)&sa, sizeof(sa), data, size);
 		}
 		else
 		{
@@ -1076,7 +1167,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in6(addr, &sa);
 			}
 
-			d = sendto(sock->ipv6sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			d = net_udp_sendto(sock, sock->ipv6sock, (sockaddr *)&sa, sizeof(sa), data, size);
 		}
 		else
 		{
@@ -1223,6 +1314,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 
 void net_udp_close(NETSOCKET sock)
 {
+	net_udp_send_batch_end(sock);
 	priv_net_close_all_sockets(sock);
 }
 
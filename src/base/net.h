@@ -274,6 +274,30 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
  */
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
+/**
+ * Starts queueing the packets sent over an UDP socket instead of sending
+ * each of them with its own system call. The queued packets are sent when
+ * the queue is full and by @link net_udp_send_batch_end @endlink.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ *
+ * @remark Only has an effect on Linux, where the packets are sent with `sendmmsg`.
+ * @remark Broadcasts and websocket packets are always sent immediately.
+ */
+void net_udp_send_batch_begin(NETSOCKET sock);
+
+/**
+ * Sends all packets queued since @link net_udp_send_batch_begin @endlink and
+ * goes back to sending packets immediately.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ */
+void net_udp_send_batch_end(NETSOCKET sock);
+
 /**
  * Receives a packet over an UDP socket.
  *
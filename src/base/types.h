@@ -193,6 +193,9 @@ typedef struct NETSTATS
 	uint64_t sent_bytes;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
+	// system calls used to send the packets, less than `sent_packets`
+	// when packets are sent in batches
+	uint64_t sent_syscalls;
 } NETSTATS;
 
 #if defined(CONF_FAMILY_WINDOWS)
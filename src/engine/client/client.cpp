@@ -277,6 +277,11 @@ void CClient::SendMapRequest()
 		CMsgPacker MsgP(protocol7::NETMSG_REQUEST_MAP_DATA, true, true);
 		SendMsg(CONN_MAIN, &MsgP, MSGFLAG_VITAL | MSGFLAG_FLUSH);
 	}
+	else if(m_ServerCapabilities.m_MapDownloadWindow)
+	{
+		m_MapdownloadRequestedChunks = m_MapdownloadChunk;
+		RequestMapChunks(g_Config.m_ClMapDownloadWindow);
+	}
 	else
 	{
 		CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA, true);
@@ -285,6 +290,29 @@ void CClient::SendMapRequest()
 	}
 }
 
+void CClient::RequestMapChunks(int NumChunks)
+{
+	// the server sends chunks of this size, except for the last one
+	const int ChunkSize = NET_MAX_CHUNK_SIZE - 128;
+	const int NumMapChunks = (m_MapdownloadTotalsize + ChunkSize - 1) / ChunkSize;
+	NumChunks = std::min(NumChunks, NumMapChunks - m_MapdownloadRequestedChunks);
+	if(NumChunks <= 0)
+		return;
+
+	CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA, true);
+	Msg.AddInt(m_MapdownloadRequestedChunks);
+	Msg.AddInt(NumChunks);
+	SendMsg(CONN_MAIN, &Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	m_MapdownloadRequestedChunks += NumChunks;
+
+	if(g_Config.m_Debug)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "requested chunks %d to %d", m_MapdownloadRequestedChunks - NumChunks, m_MapdownloadRequestedChunks - 1);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "client/network", aBuf);
+	}
+}
+
 void CClient::RconAuth(const char *pName, const char *pPassword, bool Dummy)
 {
 	if(m_aRconAuthed[Dummy] != 0)
@@ -1566,6 +1594,7 @@ static CServerCapabilities GetServerCapabilities(int Version, int Flags, bool Si
 	Result.m_PingEx = false;
 	Result.m_AllowDummy = true;
 	Result.m_SyncWeaponInput = false;
+	Result.m_MapDownloadWindow = false;
 	if(Version >= 1)
 	{
 		Result.m_ChatTimeoutCode = Flags & SERVERCAPFLAG_CHATTIMEOUTCODE;
@@ -1586,6 +1615,10 @@ static CServerCapabilities GetServerCapabilities(int Version, int Flags, bool Si
 	{
 		Result.m_SyncWeaponInput = Flags & SERVERCAPFLAG_SYNCWEAPONINPUT;
 	}
+	if(Version >= 6)
+	{
+		Result.m_MapDownloadWindow = Flags & SERVERCAPFLAG_MAPDOWNLOADWINDOW;
+	}
 	return Result;
 }
 
@@ -1819,6 +1852,12 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 					CMsgPacker MsgP(protocol7::NETMSG_REQUEST_MAP_DATA, true, true);
 					SendMsg(CONN_MAIN, &MsgP, MSGFLAG_VITAL | MSGFLAG_FLUSH);
 				}
+				else if(!IsSixup() && m_ServerCapabilities.m_MapDownloadWindow)
+				{
+					// keep the window filled, one new chunk for every received one
+					RequestMapChunks(m_MapdownloadChunk + g_Config.m_ClMapDownloadWindow - m_MapdownloadRequestedChunks);
+					return;
+				}
 				else
 				{
 					CMsgPacker MsgP(NETMSG_REQUEST_MAP_DATA, true);
@@ -2446,6 +2485,7 @@ void CClient::ResetMapDownload(bool ResetActive)
 	if(ResetActive)
 	{
 		m_MapdownloadChunk = 0;
+		m_MapdownloadRequestedChunks = 0;
 		m_MapdownloadSha256 = std::nullopt;
 		m_MapdownloadCrc = 0;
 		m_MapdownloadTotalsize = -1;
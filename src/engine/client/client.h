@@ -54,6 +54,7 @@ public:
 	bool m_PingEx = false;
 	bool m_AllowDummy = false;
 	bool m_SyncWeaponInput = false;
+	bool m_MapDownloadWindow = false;
 };
 
 class CClient : public IClient, public CDemoPlayer::IListener
@@ -147,6 +148,7 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	char m_aMapdownloadName[256] = "";
 	IOHANDLE m_MapdownloadFileTemp = nullptr;
 	int m_MapdownloadChunk = 0;
+	int m_MapdownloadRequestedChunks = 0;
 	int m_MapdownloadCrc = 0;
 	int m_MapdownloadAmount = -1;
 	int m_MapdownloadTotalsize = -1;
@@ -303,6 +305,7 @@ public:
 	void SendEnterGame(int Conn);
 	void SendReady(int Conn);
 	void SendMapRequest();
+	void RequestMapChunks(int NumChunks);
 
 	bool RconAuthed() const override { return m_aRconAuthed[g_Config.m_ClDummy] != 0; }
 	bool UseTempRconCommands() const override { return m_UseTempRconCommands != 0; }
@@ -2,6 +2,8 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "sound.h"
 
+#include "sound_mix.h"
+
 #include <base/bytes.h>
 #include <base/dbg.h>
 #include <base/log.h>
@@ -27,29 +29,29 @@ extern "C" {
 
 static constexpr int SAMPLE_INDEX_USED = -2;
 static constexpr int SAMPLE_INDEX_FULL = -1;
+static constexpr int OPUS_RATE = 48000;
 
 void CSound::Mix(short *pFinalOut, unsigned Frames)
 {
 	Frames = std::min(Frames, m_MaxFrames);
 	mem_zero(m_pMixBuffer, Frames * 2 * sizeof(int));
 
-	// acquire lock while we are mixing
+	// acquire lock while we are mixing, the game only takes it to change
+	// samples or to query the voices
 	m_SoundLock.lock();
+	ProcessCommands();
 
 	const int MasterVol = m_SoundVolume.load(std::memory_order_relaxed);
 
 	for(auto &Voice : m_aVoices)
 	{
+		CVoiceStream &Stream = m_aVoiceStreams[&Voice - m_aVoices];
+		if(Stream.m_pSample && Stream.m_pSample != Voice.m_pSample)
+			CloseStream(Stream);
+
 		if(!Voice.m_pSample)
 			continue;
 
-		// mix voice
-		int *pOut = m_pMixBuffer;
-
-		const int Step = Voice.m_pSample->m_Channels; // setup input sources
-		short *pInL = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
-		short *pInR = &Voice.m_pSample->m_pData[Voice.m_Tick * Step + 1];
-
 		unsigned End = Voice.m_pSample->m_NumFrames - Voice.m_Tick;
 
 		int VolumeR = round_truncate(Voice.m_pChannel->m_Vol * (Voice.m_Vol / 255.0f));
@@ -59,10 +61,6 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 		if(Frames < End)
 			End = Frames;
 
-		// check if we have a mono sound
-		if(Voice.m_pSample->m_Channels == 1)
-			pInR = pInL;
-
 		// volume calculation
 		if(Voice.m_Flags & ISound::FLAG_POS && Voice.m_pChannel->m_Pan)
 		{
@@ -136,14 +134,19 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 		}
 
 		// process all frames
-		for(unsigned s = 0; s < End; s++)
+		const int Channels = Voice.m_pSample->m_Channels;
+		if(!Voice.m_pSample->IsStreamed())
 		{
-			*pOut++ += (*pInL) * VolumeL;
-			*pOut++ += (*pInR) * VolumeR;
-			pInL += Step;
-			pInR += Step;
-			Voice.m_Tick++;
+			MixVoice(m_pMixBuffer, &Voice.m_pSample->m_pData[Voice.m_Tick * Channels], Channels, End, VolumeL, VolumeR);
 		}
+		else if(VolumeL != 0 || VolumeR != 0)
+		{
+			// inaudible voices are not decoded, the stream seeks when they can be heard again
+			const short *pData = StreamFrames(Stream, *Voice.m_pSample, Voice.m_Tick, End);
+			if(pData)
+				MixVoice(m_pMixBuffer, pData, Channels, End, VolumeL, VolumeR);
+		}
+		Voice.m_Tick += End;
 
 		// free voice if not used any more
 		if(Voice.m_Tick == Voice.m_pSample->m_NumFrames)
@@ -155,7 +158,7 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 			else
 			{
 				Voice.m_pSample = nullptr;
-				Voice.m_Age++;
+				m_aVoiceEndedAges[&Voice - m_aVoices].store(Voice.m_Age, std::memory_order_release);
 			}
 		}
 	}
@@ -163,8 +166,7 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 	m_SoundLock.unlock();
 
 	// clamp accumulated values
-	for(unsigned i = 0; i < Frames * 2; i++)
-		pFinalOut[i] = std::clamp<int>(((m_pMixBuffer[i] * MasterVol) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+	MixToOutput(pFinalOut, m_pMixBuffer, Frames * 2, MasterVol);
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
@@ -204,6 +206,8 @@ int CSound::Init()
 		m_aSamples[i].m_Index = i;
 		m_aSamples[i].m_NextFreeSampleIndex = i + 1;
 		m_aSamples[i].m_pData = nullptr;
+		m_aSamples[i].m_pStreamData = nullptr;
+		m_aSamples[i].m_pStreamDecoder = nullptr;
 	}
 	m_aSamples[std::size(m_aSamples) - 1].m_Index = std::size(m_aSamples) - 1;
 	m_aSamples[std::size(m_aSamples) - 1].m_NextFreeSampleIndex = SAMPLE_INDEX_FULL;
@@ -275,10 +279,19 @@ void CSound::Shutdown()
 	m_Device = 0;
 
 	const CLockScope LockScope(m_SoundLock);
+	for(auto &Stream : m_aVoiceStreams)
+	{
+		if(Stream.m_pSample)
+			CloseStream(Stream);
+	}
 	for(auto &Sample : m_aSamples)
 	{
 		free(Sample.m_pData);
 		Sample.m_pData = nullptr;
+		free(Sample.m_pStreamData);
+		Sample.m_pStreamData = nullptr;
+		op_free(Sample.m_pStreamDecoder);
+		Sample.m_pStreamDecoder = nullptr;
 	}
 
 	free(m_pMixBuffer);
@@ -294,7 +307,7 @@ CSample *CSound::AllocSample()
 
 	CSample *pSample = &m_aSamples[m_FirstFreeSampleIndex];
 	dbg_assert(
-		pSample->m_pData == nullptr && pSample->m_NextFreeSampleIndex != SAMPLE_INDEX_USED,
+		!pSample->IsLoaded() && pSample->m_NextFreeSampleIndex != SAMPLE_INDEX_USED,
 		"Sample was not unloaded (index=%d, next=%d, duration=%f, data=%p)",
 		pSample->m_Index, pSample->m_NextFreeSampleIndex, pSample->TotalTime(), pSample->m_pData);
 	m_FirstFreeSampleIndex = pSample->m_NextFreeSampleIndex;
@@ -309,35 +322,41 @@ void CSound::RateConvert(CSample &Sample) const
 	if(Sample.m_Rate == m_MixingRate)
 		return;
 
-	// allocate new data
 	const int NumFrames = (int)((Sample.m_NumFrames / (float)Sample.m_Rate) * m_MixingRate);
-	short *pNewData = (short *)calloc((size_t)NumFrames * Sample.m_Channels, sizeof(short));
 
-	for(int i = 0; i < NumFrames; i++)
+	// streamed samples are converted while decoding
+	if(!Sample.IsStreamed())
 	{
-		// resample TODO: this should be done better, like linear at least
-		float a = i / (float)NumFrames;
-		int f = (int)(a * Sample.m_NumFrames);
-		if(f >= Sample.m_NumFrames)
-			f = Sample.m_NumFrames - 1;
-
-		// set new data
-		if(Sample.m_Channels == 1)
-			pNewData[i] = Sample.m_pData[f];
-		else if(Sample.m_Channels == 2)
+		// allocate new data
+		short *pNewData = (short *)calloc((size_t)NumFrames * Sample.m_Channels, sizeof(short));
+
+		for(int i = 0; i < NumFrames; i++)
 		{
-			pNewData[i * 2] = Sample.m_pData[f * 2];
-			pNewData[i * 2 + 1] = Sample.m_pData[f * 2 + 1];
+			// resample TODO: this should be done better, like linear at least
+			float a = i / (float)NumFrames;
+			int f = (int)(a * Sample.m_NumFrames);
+			if(f >= Sample.m_NumFrames)
+				f = Sample.m_NumFrames - 1;
+
+			// set new data
+			if(Sample.m_Channels == 1)
+				pNewData[i] = Sample.m_pData[f];
+			else if(Sample.m_Channels == 2)
+			{
+				pNewData[i * 2] = Sample.m_pData[f * 2];
+				pNewData[i * 2 + 1] = Sample.m_pData[f * 2 + 1];
+			}
 		}
+
+		// free old data and apply new
+		free(Sample.m_pData);
+		Sample.m_pData = pNewData;
 	}
 
 	// adjust looping position, note that this is not precise
 	const double Factor = (double)m_MixingRate / (double)Sample.m_Rate;
 	Sample.m_LoopStart = std::round(Sample.m_LoopStart * Factor);
 
-	// free old data and apply new
-	free(Sample.m_pData);
-	Sample.m_pData = pNewData;
 	Sample.m_NumFrames = NumFrames;
 	Sample.m_Rate = m_MixingRate;
 }
@@ -364,27 +383,41 @@ bool CSound::DecodeOpus(CSample &Sample, const void *pData, unsigned DataSize, c
 			return false;
 		}
 
-		short *pSampleData = (short *)calloc((size_t)NumSamples * NumChannels, sizeof(short));
-
-		int Pos = 0;
-		while(Pos < NumSamples)
+		if(g_Config.m_SndStreamThreshold > 0 && NumSamples > (int64_t)g_Config.m_SndStreamThreshold * OPUS_RATE)
 		{
-			const int Read = op_read(pOpusFile, pSampleData + Pos * NumChannels, (NumSamples - Pos) * NumChannels, nullptr);
-			if(Read < 0)
+			// long samples are decoded while playing, only keep the encoded file
+			Sample.m_pStreamData = (unsigned char *)malloc(DataSize);
+			mem_copy(Sample.m_pStreamData, pData, DataSize);
+			Sample.m_StreamDataSize = DataSize;
+			Sample.m_pStreamDecoder = op_open_memory(Sample.m_pStreamData, DataSize, &OpusError);
+			Sample.m_NumFrames = NumSamples;
+			if(g_Config.m_Debug)
+				log_trace("sound/opus", "Streaming sample, keeping %u bytes instead of %" PRIzu " decoded. Filename='%s'", DataSize, (size_t)NumSamples * NumChannels * sizeof(short), pContextName);
+		}
+		else
+		{
+			short *pSampleData = (short *)calloc((size_t)NumSamples * NumChannels, sizeof(short));
+
+			int Pos = 0;
+			while(Pos < NumSamples)
 			{
-				free(pSampleData);
-				op_free(pOpusFile);
-				log_error("sound/opus", "op_read error %d at %d. Filename='%s'", Read, Pos, pContextName);
-				return false;
+				const int Read = op_read(pOpusFile, pSampleData + Pos * NumChannels, (NumSamples - Pos) * NumChannels, nullptr);
+				if(Read < 0)
+				{
+					free(pSampleData);
+					op_free(pOpusFile);
+					log_error("sound/opus", "op_read error %d at %d. Filename='%s'", Read, Pos, pContextName);
+					return false;
+				}
+				else if(Read == 0) // EOF
+					break;
+				Pos += Read;
 			}
-			else if(Read == 0) // EOF
-				break;
-			Pos += Read;
-		}
 
-		Sample.m_pData = pSampleData;
-		Sample.m_NumFrames = Pos;
-		Sample.m_Rate = 48000;
+			Sample.m_pData = pSampleData;
+			Sample.m_NumFrames = Pos;
+		}
+		Sample.m_Rate = OPUS_RATE;
 		Sample.m_Channels = NumChannels;
 		Sample.m_LoopStart = 0;
 		Sample.m_PausedAt = 0;
@@ -426,6 +459,59 @@ bool CSound::DecodeOpus(CSample &Sample, const void *pData, unsigned DataSize, c
 	return true;
 }
 
+bool COpusStreamDecoder::Seek(int Frame)
+{
+	return op_pcm_seek(m_pOpusFile, Frame) == 0;
+}
+
+int COpusStreamDecoder::Read(short *pBuffer, int MaxFrames)
+{
+	return op_read(m_pOpusFile, pBuffer, MaxFrames * m_Channels, nullptr);
+}
+
+const short *CSound::StreamFrames(CVoiceStream &Stream, CSample &Sample, int Tick, unsigned Frames)
+{
+	if(Stream.m_pSample != &Sample)
+	{
+		Stream.m_pSample = &Sample;
+		if(Sample.m_pStreamDecoder)
+		{
+			Stream.m_Decoder.m_pOpusFile = Sample.m_pStreamDecoder;
+			Sample.m_pStreamDecoder = nullptr;
+		}
+		else
+		{
+			// more voices play this sample at the same time
+			int OpusError = 0;
+			Stream.m_Decoder.m_pOpusFile = op_open_memory(Sample.m_pStreamData, Sample.m_StreamDataSize, &OpusError);
+			if(!Stream.m_Decoder.m_pOpusFile)
+				return nullptr;
+		}
+		Stream.m_Decoder.m_Channels = Sample.m_Channels;
+		// a decoder of a stopped voice stays where that voice stopped
+		const int64_t DecoderFrame = op_pcm_tell(Stream.m_Decoder.m_pOpusFile);
+		// an Opus packet has up to 120 ms
+		Stream.m_Buffer.Init(Sample.m_Channels, OPUS_RATE, m_MixingRate, op_pcm_total(Stream.m_Decoder.m_pOpusFile, -1), m_MaxFrames, OPUS_RATE * 120 / 1000, DecoderFrame < 0 ? -1 : (int)DecoderFrame);
+	}
+
+	// opening the decoder failed, don't retry it in every mix
+	if(!Stream.m_Decoder.m_pOpusFile)
+		return nullptr;
+
+	return Stream.m_Buffer.Frames(Stream.m_Decoder, Tick, Frames);
+}
+
+void CSound::CloseStream(CVoiceStream &Stream)
+{
+	// keep a decoder for the next voice that plays the sample
+	if(Stream.m_pSample->m_pStreamDecoder == nullptr && Stream.m_Decoder.m_pOpusFile != nullptr)
+		Stream.m_pSample->m_pStreamDecoder = Stream.m_Decoder.m_pOpusFile;
+	else
+		op_free(Stream.m_Decoder.m_pOpusFile);
+	Stream.m_Decoder.m_pOpusFile = nullptr;
+	Stream.m_pSample = nullptr;
+}
+
 // TODO: Update WavPack to get rid of these global variables
 static const void *s_pWVBuffer = nullptr;
 static int s_WVBufferPosition = 0;
@@ -675,7 +761,9 @@ void CSound::UnloadSample(int SampleId)
 		return;
 
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
+	const CLockScope CommandLockScope(m_CommandLock);
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	CSample &Sample = m_aSamples[SampleId];
 
 	if(Sample.IsLoaded())
@@ -685,13 +773,24 @@ void CSound::UnloadSample(int SampleId)
 		{
 			if(Voice.m_pSample == &Sample)
 			{
-				Voice.m_pSample = nullptr;
+				ReleaseVoice(Voice);
+			}
+		}
+		for(auto &Stream : m_aVoiceStreams)
+		{
+			if(Stream.m_pSample == &Sample)
+			{
+				CloseStream(Stream);
 			}
 		}
 
 		// Free data
 		free(Sample.m_pData);
 		Sample.m_pData = nullptr;
+		free(Sample.m_pStreamData);
+		Sample.m_pStreamData = nullptr;
+		op_free(Sample.m_pStreamDecoder);
+		Sample.m_pStreamDecoder = nullptr;
 	}
 
 	// Free slot
@@ -716,6 +815,7 @@ float CSound::GetSampleCurrentTime(int SampleId)
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
 
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	CSample *pSample = &m_aSamples[SampleId];
 	for(auto &Voice : m_aVoices)
@@ -734,6 +834,7 @@ void CSound::SetSampleCurrentTime(int SampleId, float Time)
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
 
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	CSample *pSample = &m_aSamples[SampleId];
 	for(auto &Voice : m_aVoices)
@@ -763,71 +864,157 @@ void CSound::SetListenerPosition(vec2 Position)
 	m_ListenerPositionY.store(Position.y, std::memory_order_relaxed);
 }
 
-void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
+void CSound::PushCommand(const CVoiceCommand &Command)
+{
+	const unsigned Write = m_CommandsWrite.load(std::memory_order_relaxed);
+	if(Write - m_CommandsRead.load(std::memory_order_acquire) == NUM_COMMANDS)
+	{
+		// the audio callback is not running, e.g. while the device is paused
+		const CLockScope LockScope(m_SoundLock);
+		ProcessCommands();
+	}
+	m_aCommands[Write % NUM_COMMANDS] = Command;
+	m_CommandsWrite.store(Write + 1, std::memory_order_release);
+}
+
+void CSound::PushVoiceCommand(CVoiceHandle Voice, CVoiceCommand &Command)
 {
 	if(!Voice.IsValid())
 		return;
 
 	int VoiceId = Voice.Id();
 
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
+	const CLockScope LockScope(m_CommandLock);
+	if(!m_aVoiceUsed[VoiceId] || m_aVoiceAges[VoiceId] != Voice.Age())
 		return;
 
-	Volume = std::clamp(Volume, 0.0f, 1.0f);
-	m_aVoices[VoiceId].m_Vol = (int)(Volume * 255.0f);
+	Command.m_VoiceId = VoiceId;
+	Command.m_Age = Voice.Age();
+	PushCommand(Command);
 }
 
-void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
+void CSound::ProcessCommands()
 {
-	if(!Voice.IsValid())
-		return;
+	const unsigned Write = m_CommandsWrite.load(std::memory_order_acquire);
+	unsigned Read = m_CommandsRead.load(std::memory_order_relaxed);
+	for(; Read != Write; Read++)
+		ProcessCommand(m_aCommands[Read % NUM_COMMANDS]);
+	m_CommandsRead.store(Read, std::memory_order_release);
+}
 
-	int VoiceId = Voice.Id();
+void CSound::ProcessCommand(const CVoiceCommand &Command)
+{
+	CVoice &Voice = m_aVoices[Command.m_VoiceId];
+	if(Command.m_Type == CVoiceCommand::PLAY)
+	{
+		CSample &Sample = m_aSamples[Command.m_SampleId];
+		Voice.m_pSample = &Sample;
+		Voice.m_pChannel = &m_aChannels[Command.m_ChannelId];
+		if(Command.m_Flags & FLAG_LOOP)
+		{
+			Voice.m_Tick = Sample.m_PausedAt;
+		}
+		else if(Command.m_Flags & FLAG_PREVIEW)
+		{
+			Voice.m_Tick = Sample.m_PausedAt;
+			Sample.m_PausedAt = 0;
+		}
+		else
+		{
+			Voice.m_Tick = 0;
+		}
+		Voice.m_Age = Command.m_Age;
+		Voice.m_Vol = Command.m_Vol;
+		Voice.m_Flags = Command.m_Flags;
+		Voice.m_Position = Command.m_Position;
+		Voice.m_Falloff = 0.0f;
+		Voice.m_Shape = ISound::SHAPE_CIRCLE;
+		Voice.m_Circle.m_Radius = 1500;
+		return;
+	}
 
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
+	// the voice was stopped or finished playing in the meantime
+	if(!Voice.m_pSample || Voice.m_Age != Command.m_Age)
 		return;
 
-	Falloff = std::clamp(Falloff, 0.0f, 1.0f);
-	m_aVoices[VoiceId].m_Falloff = Falloff;
+	switch(Command.m_Type)
+	{
+	case CVoiceCommand::STOP:
+		Voice.m_pSample = nullptr;
+		break;
+	case CVoiceCommand::SET_VOLUME:
+		Voice.m_Vol = Command.m_Vol;
+		break;
+	case CVoiceCommand::SET_FALLOFF:
+		Voice.m_Falloff = Command.m_Value;
+		break;
+	case CVoiceCommand::SET_POSITION:
+		Voice.m_Position = Command.m_Position;
+		break;
+	case CVoiceCommand::SET_TIME_OFFSET:
+		ApplyVoiceTimeOffset(Voice, Command.m_Value);
+		break;
+	case CVoiceCommand::SET_CIRCLE:
+		Voice.m_Shape = ISound::SHAPE_CIRCLE;
+		Voice.m_Circle.m_Radius = Command.m_Value;
+		break;
+	case CVoiceCommand::SET_RECTANGLE:
+		Voice.m_Shape = ISound::SHAPE_RECTANGLE;
+		Voice.m_Rectangle.m_Width = Command.m_Position.x;
+		Voice.m_Rectangle.m_Height = Command.m_Position.y;
+		break;
+	default:
+		dbg_assert_failed("Invalid voice command type %d", Command.m_Type);
+	}
 }
 
-void CSound::SetVoicePosition(CVoiceHandle Voice, vec2 Position)
+void CSound::ReleaseVoice(CVoice &Voice)
 {
-	if(!Voice.IsValid())
-		return;
+	Voice.m_pSample = nullptr;
+	m_aVoiceUsed[&Voice - m_aVoices] = false;
+}
 
-	int VoiceId = Voice.Id();
+void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
+{
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_VOLUME;
+	Command.m_Vol = (int)(std::clamp(Volume, 0.0f, 1.0f) * 255.0f);
+	PushVoiceCommand(Voice, Command);
+}
 
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
-		return;
+void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
+{
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_FALLOFF;
+	Command.m_Value = std::clamp(Falloff, 0.0f, 1.0f);
+	PushVoiceCommand(Voice, Command);
+}
 
-	m_aVoices[VoiceId].m_Position = Position;
+void CSound::SetVoicePosition(CVoiceHandle Voice, vec2 Position)
+{
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_POSITION;
+	Command.m_Position = Position;
+	PushVoiceCommand(Voice, Command);
 }
 
 void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceId = Voice.Id();
-
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
-		return;
-
-	if(!m_aVoices[VoiceId].m_pSample)
-		return;
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_TIME_OFFSET;
+	Command.m_Value = TimeOffset;
+	PushVoiceCommand(Voice, Command);
+}
 
+void CSound::ApplyVoiceTimeOffset(CVoice &Voice, float TimeOffset)
+{
 	int Tick = 0;
-	bool IsLooping = m_aVoices[VoiceId].m_Flags & ISound::FLAG_LOOP;
-	uint64_t TickOffset = m_aVoices[VoiceId].m_pSample->m_Rate * TimeOffset;
-	if(m_aVoices[VoiceId].m_pSample->m_NumFrames > 0 && IsLooping)
+	bool IsLooping = Voice.m_Flags & ISound::FLAG_LOOP;
+	uint64_t TickOffset = Voice.m_pSample->m_Rate * TimeOffset;
+	if(Voice.m_pSample->m_NumFrames > 0 && IsLooping)
 	{
-		const int LoopStart = m_aVoices[VoiceId].m_pSample->m_LoopStart;
-		const int NumFrames = m_aVoices[VoiceId].m_pSample->m_NumFrames;
+		const int LoopStart = Voice.m_pSample->m_LoopStart;
+		const int NumFrames = Voice.m_pSample->m_NumFrames;
 		if(TickOffset < static_cast<uint64_t>(NumFrames))
 		{
 			// Still in first playthrough
@@ -845,62 +1032,47 @@ void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset)
 	}
 	else
 	{
-		Tick = std::clamp<uint64_t>(TickOffset, 0, m_aVoices[VoiceId].m_pSample->m_NumFrames);
+		Tick = std::clamp<uint64_t>(TickOffset, 0, Voice.m_pSample->m_NumFrames);
 	}
 
 	// at least 200msec off, else depend on buffer size
-	float Threshold = std::max(0.2f * m_aVoices[VoiceId].m_pSample->m_Rate, (float)m_MaxFrames);
-	if(absolute(m_aVoices[VoiceId].m_Tick - Tick) > Threshold)
+	float Threshold = std::max(0.2f * Voice.m_pSample->m_Rate, (float)m_MaxFrames);
+	if(absolute(Voice.m_Tick - Tick) > Threshold)
 	{
 		// take care of looping (modulo!)
-		if(!(IsLooping && (std::min(m_aVoices[VoiceId].m_Tick, Tick) + m_aVoices[VoiceId].m_pSample->m_NumFrames - std::max(m_aVoices[VoiceId].m_Tick, Tick)) <= Threshold))
+		if(!(IsLooping && (std::min(Voice.m_Tick, Tick) + Voice.m_pSample->m_NumFrames - std::max(Voice.m_Tick, Tick)) <= Threshold))
 		{
-			m_aVoices[VoiceId].m_Tick = Tick;
+			Voice.m_Tick = Tick;
 		}
 	}
 }
 
 void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceId = Voice.Id();
-
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_CIRCLE;
-	m_aVoices[VoiceId].m_Circle.m_Radius = std::max(0.0f, Radius);
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_CIRCLE;
+	Command.m_Value = std::max(0.0f, Radius);
+	PushVoiceCommand(Voice, Command);
 }
 
 void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceId = Voice.Id();
-
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_RECTANGLE;
-	m_aVoices[VoiceId].m_Rectangle.m_Width = std::max(0.0f, Width);
-	m_aVoices[VoiceId].m_Rectangle.m_Height = std::max(0.0f, Height);
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::SET_RECTANGLE;
+	Command.m_Position = vec2(std::max(0.0f, Width), std::max(0.0f, Height));
+	PushVoiceCommand(Voice, Command);
 }
 
 ISound::CVoiceHandle CSound::Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position)
 {
-	const CLockScope LockScope(m_SoundLock);
+	const CLockScope LockScope(m_CommandLock);
 
 	// search for voice
 	int VoiceId = -1;
 	for(int i = 0; i < NUM_VOICES; i++)
 	{
 		int NextId = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[NextId].m_pSample)
+		if(!m_aVoiceUsed[NextId] || m_aVoiceEndedAges[NextId].load(std::memory_order_acquire) == m_aVoiceAges[NextId])
 		{
 			VoiceId = NextId;
 			m_NextVoice = NextId + 1;
@@ -913,28 +1085,20 @@ ISound::CVoiceHandle CSound::Play(int ChannelId, int SampleId, int Flags, float
 	}
 
 	// voice found, use it
-	m_aVoices[VoiceId].m_pSample = &m_aSamples[SampleId];
-	m_aVoices[VoiceId].m_pChannel = &m_aChannels[ChannelId];
-	if(Flags & FLAG_LOOP)
-	{
-		m_aVoices[VoiceId].m_Tick = m_aSamples[SampleId].m_PausedAt;
-	}
-	else if(Flags & FLAG_PREVIEW)
-	{
-		m_aVoices[VoiceId].m_Tick = m_aSamples[SampleId].m_PausedAt;
-		m_aSamples[SampleId].m_PausedAt = 0;
-	}
-	else
-	{
-		m_aVoices[VoiceId].m_Tick = 0;
-	}
-	m_aVoices[VoiceId].m_Vol = (int)(std::clamp(Volume, 0.0f, 1.0f) * 255.0f);
-	m_aVoices[VoiceId].m_Flags = Flags;
-	m_aVoices[VoiceId].m_Position = Position;
-	m_aVoices[VoiceId].m_Falloff = 0.0f;
-	m_aVoices[VoiceId].m_Shape = ISound::SHAPE_CIRCLE;
-	m_aVoices[VoiceId].m_Circle.m_Radius = 1500;
-	return CreateVoiceHandle(VoiceId, m_aVoices[VoiceId].m_Age);
+	m_aVoiceAges[VoiceId]++;
+	m_aVoiceUsed[VoiceId] = true;
+
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::PLAY;
+	Command.m_VoiceId = VoiceId;
+	Command.m_Age = m_aVoiceAges[VoiceId];
+	Command.m_SampleId = SampleId;
+	Command.m_ChannelId = ChannelId;
+	Command.m_Flags = Flags;
+	Command.m_Vol = (int)(std::clamp(Volume, 0.0f, 1.0f) * 255.0f);
+	Command.m_Position = Position;
+	PushCommand(Command);
+	return CreateVoiceHandle(VoiceId, m_aVoiceAges[VoiceId]);
 }
 
 ISound::CVoiceHandle CSound::PlayAt(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position)
@@ -952,7 +1116,9 @@ void CSound::Pause(int SampleId)
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
 
 	// TODO: a nice fade out
+	const CLockScope CommandLockScope(m_CommandLock);
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	for(auto &Voice : m_aVoices)
@@ -960,7 +1126,7 @@ void CSound::Pause(int SampleId)
 		if(Voice.m_pSample == pSample)
 		{
 			Voice.m_pSample->m_PausedAt = Voice.m_Tick;
-			Voice.m_pSample = nullptr;
+			ReleaseVoice(Voice);
 		}
 	}
 }
@@ -970,7 +1136,9 @@ void CSound::Stop(int SampleId)
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
 
 	// TODO: a nice fade out
+	const CLockScope CommandLockScope(m_CommandLock);
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	for(auto &Voice : m_aVoices)
@@ -981,7 +1149,7 @@ void CSound::Stop(int SampleId)
 				Voice.m_pSample->m_PausedAt = Voice.m_Tick;
 			else
 				Voice.m_pSample->m_PausedAt = 0;
-			Voice.m_pSample = nullptr;
+			ReleaseVoice(Voice);
 		}
 	}
 }
@@ -989,7 +1157,9 @@ void CSound::Stop(int SampleId)
 void CSound::StopAll()
 {
 	// TODO: a nice fade out
+	const CLockScope CommandLockScope(m_CommandLock);
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	for(auto &Voice : m_aVoices)
 	{
 		if(Voice.m_pSample)
@@ -999,7 +1169,7 @@ void CSound::StopAll()
 			else
 				Voice.m_pSample->m_PausedAt = 0;
 		}
-		Voice.m_pSample = nullptr;
+		ReleaseVoice(Voice);
 	}
 }
 
@@ -1010,18 +1180,23 @@ void CSound::StopVoice(CVoiceHandle Voice)
 
 	int VoiceId = Voice.Id();
 
-	const CLockScope LockScope(m_SoundLock);
-	if(m_aVoices[VoiceId].m_Age != Voice.Age())
+	const CLockScope LockScope(m_CommandLock);
+	if(!m_aVoiceUsed[VoiceId] || m_aVoiceAges[VoiceId] != Voice.Age())
 		return;
 
-	m_aVoices[VoiceId].m_pSample = nullptr;
-	m_aVoices[VoiceId].m_Age++;
+	CVoiceCommand Command;
+	Command.m_Type = CVoiceCommand::STOP;
+	Command.m_VoiceId = VoiceId;
+	Command.m_Age = Voice.Age();
+	PushCommand(Command);
+	m_aVoiceUsed[VoiceId] = false;
 }
 
 bool CSound::IsPlaying(int SampleId)
 {
 	dbg_assert(SampleId >= 0 && SampleId < NUM_SAMPLES, "SampleId invalid");
 	const CLockScope LockScope(m_SoundLock);
+	ProcessCommands();
 	const CSample *pSample = &m_aSamples[SampleId];
 	dbg_assert(m_aSamples[SampleId].IsLoaded(), "Sample not loaded");
 	return std::any_of(std::begin(m_aVoices), std::end(m_aVoices), [pSample](const auto &Voice) { return Voice.m_pSample == pSample; });
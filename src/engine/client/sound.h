@@ -3,6 +3,8 @@
 #ifndef ENGINE_CLIENT_SOUND_H
 #define ENGINE_CLIENT_SOUND_H
 
+#include "sound_stream.h"
+
 #include <base/lock.h>
 
 #include <engine/sound.h>
@@ -11,12 +13,19 @@
 
 #include <atomic>
 
+struct OggOpusFile;
+
 struct CSample
 {
 	int m_Index;
 	int m_NextFreeSampleIndex;
 
 	short *m_pData;
+	// the encoded Opus file of long samples, which are decoded while playing
+	unsigned char *m_pStreamData;
+	unsigned m_StreamDataSize;
+	// decoder opened when loading, taken by the first voice that plays the sample
+	OggOpusFile *m_pStreamDecoder;
 	int m_NumFrames;
 	int m_Rate;
 	int m_Channels;
@@ -30,7 +39,12 @@ struct CSample
 
 	bool IsLoaded() const
 	{
-		return m_pData != nullptr;
+		return m_pData != nullptr || m_pStreamData != nullptr;
+	}
+
+	bool IsStreamed() const
+	{
+		return m_pStreamData != nullptr;
 	}
 };
 
@@ -59,6 +73,50 @@ struct CVoice
 	};
 };
 
+class COpusStreamDecoder : public ISoundStreamDecoder
+{
+public:
+	OggOpusFile *m_pOpusFile = nullptr;
+	int m_Channels = 0;
+
+	bool Seek(int Frame) override;
+	int Read(short *pBuffer, int MaxFrames) override;
+};
+
+// decoder of a voice that plays a streamed sample
+struct CVoiceStream
+{
+	CSample *m_pSample = nullptr; // also set if opening the decoder failed
+	COpusStreamDecoder m_Decoder;
+	CSoundStreamBuffer m_Buffer;
+};
+
+// changes of voices, queued by the game for the mixer
+struct CVoiceCommand
+{
+	enum
+	{
+		PLAY,
+		STOP,
+		SET_VOLUME,
+		SET_FALLOFF,
+		SET_POSITION,
+		SET_TIME_OFFSET,
+		SET_CIRCLE,
+		SET_RECTANGLE,
+	};
+
+	int m_Type;
+	int m_VoiceId;
+	int m_Age;
+	int m_SampleId;
+	int m_ChannelId;
+	int m_Flags;
+	int m_Vol;
+	float m_Value; // falloff, time offset or radius
+	vec2 m_Position; // also width and height
+};
+
 class CSound : public IEngineSound
 {
 	enum
@@ -66,10 +124,13 @@ class CSound : public IEngineSound
 		NUM_SAMPLES = 512,
 		NUM_VOICES = 256,
 		NUM_CHANNELS = 16,
+		NUM_COMMANDS = 1024,
 	};
 
 	bool m_SoundEnabled = false;
 	SDL_AudioDeviceID m_Device = 0;
+	// taken by the game before m_SoundLock, never by the audio callback
+	CLock m_CommandLock ACQUIRED_BEFORE(m_SoundLock);
 	CLock m_SoundLock;
 
 	CSample m_aSamples[NUM_SAMPLES] GUARDED_BY(m_SoundLock) = {{0}};
@@ -77,9 +138,25 @@ class CSound : public IEngineSound
 
 	CVoice m_aVoices[NUM_VOICES] GUARDED_BY(m_SoundLock) = {{nullptr}};
 	CChannel m_aChannels[NUM_CHANNELS] GUARDED_BY(m_SoundLock) = {{255, 0}};
-	int m_NextVoice GUARDED_BY(m_SoundLock) = 0;
+	CVoiceStream m_aVoiceStreams[NUM_VOICES] GUARDED_BY(m_SoundLock);
 	uint32_t m_MaxFrames = 0;
 
+	// Play, StopVoice and the SetVoice functions don't wait for the mixer,
+	// they allocate the voices themselves and queue the changes in a
+	// single-producer single-consumer ring buffer. The consumer holds
+	// m_SoundLock, which is the audio callback or a function that needs the
+	// current state of the voices.
+	CVoiceCommand m_aCommands[NUM_COMMANDS];
+	std::atomic<unsigned> m_CommandsWrite = 0;
+	std::atomic<unsigned> m_CommandsRead = 0;
+
+	// the voices as seen by the game, a voice is free again when the mixer
+	// stored its age in m_aVoiceEndedAges after it finished playing
+	int m_aVoiceAges[NUM_VOICES] GUARDED_BY(m_CommandLock) = {0};
+	bool m_aVoiceUsed[NUM_VOICES] GUARDED_BY(m_CommandLock) = {false};
+	std::atomic<int> m_aVoiceEndedAges[NUM_VOICES];
+	int m_NextVoice GUARDED_BY(m_CommandLock) = 0;
+
 	// This is not an std::atomic<vec2> as this would require linking with
 	// libatomic with clang x86 as there is no native support for this.
 	std::atomic<float> m_ListenerPositionX = 0.0f;
@@ -95,6 +172,21 @@ class CSound : public IEngineSound
 	CSample *AllocSample() REQUIRES(!m_SoundLock);
 	void RateConvert(CSample &Sample) const;
 
+	void PushCommand(const CVoiceCommand &Command) REQUIRES(m_CommandLock, !m_SoundLock);
+	void PushVoiceCommand(CVoiceHandle Voice, CVoiceCommand &Command) REQUIRES(!m_CommandLock, !m_SoundLock);
+	void ProcessCommands() REQUIRES(m_SoundLock);
+	void ProcessCommand(const CVoiceCommand &Command) REQUIRES(m_SoundLock);
+	void ApplyVoiceTimeOffset(CVoice &Voice, float TimeOffset) REQUIRES(m_SoundLock);
+	// stops the voice in the mixer and frees it for the game
+	void ReleaseVoice(CVoice &Voice) REQUIRES(m_CommandLock, m_SoundLock);
+
+	// Returns the frames of a streamed sample from Tick on, decoding them if
+	// necessary. This runs in the audio callback, which only contends with
+	// the cold operations for m_SoundLock. The decoders are opened when
+	// loading and reused, so usually only seeking and decoding happen here.
+	const short *StreamFrames(CVoiceStream &Stream, CSample &Sample, int Tick, unsigned Frames) REQUIRES(m_SoundLock);
+	void CloseStream(CVoiceStream &Stream) REQUIRES(m_SoundLock);
+
 	// pContextName used for error
 	bool DecodeOpus(CSample &Sample, const void *pData, unsigned DataSize, const char *pContextName) const;
 	bool DecodeWV(CSample &Sample, const void *pData, unsigned DataSize, const char *pContextName) const;
@@ -104,7 +196,7 @@ class CSound : public IEngineSound
 public:
 	int Init() override REQUIRES(!m_SoundLock);
 	int Update() override;
-	void Shutdown() override REQUIRES(!m_SoundLock);
+	void Shutdown() override REQUIRES(!m_CommandLock, !m_SoundLock);
 
 	bool IsSoundEnabled() override { return m_SoundEnabled; }
 
@@ -112,7 +204,7 @@ public:
 	int LoadWV(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock);
 	int LoadOpusFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock);
 	int LoadWVFromMem(const void *pData, unsigned DataSize, bool ForceLoad, const char *pContextName) override REQUIRES(!m_SoundLock);
-	void UnloadSample(int SampleId) override REQUIRES(!m_SoundLock);
+	void UnloadSample(int SampleId) override REQUIRES(!m_CommandLock, !m_SoundLock);
 
 	float GetSampleTotalTime(int SampleId) override REQUIRES(!m_SoundLock); // in s
 	float GetSampleCurrentTime(int SampleId) override REQUIRES(!m_SoundLock); // in s
@@ -121,21 +213,21 @@ public:
 	void SetChannel(int ChannelId, float Vol, float Pan) override REQUIRES(!m_SoundLock);
 	void SetListenerPosition(vec2 Position) override;
 
-	void SetVoiceVolume(CVoiceHandle Voice, float Volume) override REQUIRES(!m_SoundLock);
-	void SetVoiceFalloff(CVoiceHandle Voice, float Falloff) override REQUIRES(!m_SoundLock);
-	void SetVoicePosition(CVoiceHandle Voice, vec2 Position) override REQUIRES(!m_SoundLock);
-	void SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset) override REQUIRES(!m_SoundLock); // in s
-
-	void SetVoiceCircle(CVoiceHandle Voice, float Radius) override REQUIRES(!m_SoundLock);
-	void SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height) override REQUIRES(!m_SoundLock);
-
-	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) REQUIRES(!m_SoundLock);
-	CVoiceHandle PlayAt(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) override REQUIRES(!m_SoundLock);
-	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume) override REQUIRES(!m_SoundLock);
-	void Pause(int SampleId) override REQUIRES(!m_SoundLock);
-	void Stop(int SampleId) override REQUIRES(!m_SoundLock);
-	void StopAll() override REQUIRES(!m_SoundLock);
-	void StopVoice(CVoiceHandle Voice) override REQUIRES(!m_SoundLock);
+	void SetVoiceVolume(CVoiceHandle Voice, float Volume) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void SetVoiceFalloff(CVoiceHandle Voice, float Falloff) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void SetVoicePosition(CVoiceHandle Voice, vec2 Position) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void SetVoiceTimeOffset(CVoiceHandle Voice, float TimeOffset) override REQUIRES(!m_CommandLock, !m_SoundLock); // in s
+
+	void SetVoiceCircle(CVoiceHandle Voice, float Radius) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height) override REQUIRES(!m_CommandLock, !m_SoundLock);
+
+	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) REQUIRES(!m_CommandLock, !m_SoundLock);
+	CVoiceHandle PlayAt(int ChannelId, int SampleId, int Flags, float Volume, vec2 Position) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	CVoiceHandle Play(int ChannelId, int SampleId, int Flags, float Volume) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void Pause(int SampleId) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void Stop(int SampleId) override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void StopAll() override REQUIRES(!m_CommandLock, !m_SoundLock);
+	void StopVoice(CVoiceHandle Voice) override REQUIRES(!m_CommandLock, !m_SoundLock);
 	bool IsPlaying(int SampleId) override REQUIRES(!m_SoundLock);
 
 	int MixingRate() const override { return m_MixingRate; }
@@ -0,0 +1,99 @@
+#include "sound_mix.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MIX_NEON
+#include <arm_neon.h>
+#endif
+
+void MixVoiceScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	const short *pInL = pIn;
+	const short *pInR = Channels == 1 ? pIn : pIn + 1;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		*pOut++ += (*pInL) * VolumeL;
+		*pOut++ += (*pInR) * VolumeR;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+#if defined(MIX_SSE2)
+// adds four stereo frames multiplied with the volumes, the 16-bit
+// multiplications give the exact 32-bit products when combined
+static inline void MixFourFrames(int *pOut, __m128i In, __m128i Volume)
+{
+	const __m128i Low = _mm_mullo_epi16(In, Volume);
+	const __m128i High = _mm_mulhi_epi16(In, Volume);
+	__m128i *pOut128 = (__m128i *)pOut;
+	_mm_storeu_si128(pOut128, _mm_add_epi32(_mm_loadu_si128(pOut128), _mm_unpacklo_epi16(Low, High)));
+	_mm_storeu_si128(pOut128 + 1, _mm_add_epi32(_mm_loadu_si128(pOut128 + 1), _mm_unpackhi_epi16(Low, High)));
+}
+#endif
+
+void MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	unsigned Done = 0;
+#if defined(MIX_SSE2) || defined(MIX_NEON)
+	// the volumes are multiplied as 16-bit values
+	const bool Vectorize = VolumeL >= std::numeric_limits<short>::min() && VolumeL <= std::numeric_limits<short>::max() &&
+		VolumeR >= std::numeric_limits<short>::min() && VolumeR <= std::numeric_limits<short>::max();
+	if(Vectorize)
+	{
+#if defined(MIX_SSE2)
+		const __m128i Volume = _mm_set_epi16(VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL);
+		if(Channels == 1)
+		{
+			for(; Done + 8 <= Frames; Done += 8)
+			{
+				const __m128i In = _mm_loadu_si128((const __m128i *)(pIn + Done));
+				MixFourFrames(pOut + Done * 2, _mm_unpacklo_epi16(In, In), Volume);
+				MixFourFrames(pOut + Done * 2 + 8, _mm_unpackhi_epi16(In, In), Volume);
+			}
+		}
+		else
+		{
+			for(; Done + 4 <= Frames; Done += 4)
+				MixFourFrames(pOut + Done * 2, _mm_loadu_si128((const __m128i *)(pIn + Done * 2)), Volume);
+		}
+#elif defined(MIX_NEON)
+		const int16_t aVolume[4] = {(int16_t)VolumeL, (int16_t)VolumeR, (int16_t)VolumeL, (int16_t)VolumeR};
+		const int16x4_t Volume = vld1_s16(aVolume);
+		for(; Done + 4 <= Frames; Done += 4)
+		{
+			int16x4_t InLow, InHigh;
+			if(Channels == 1)
+			{
+				const int16x4_t In = vld1_s16(pIn + Done);
+				const int16x4x2_t Zipped = vzip_s16(In, In);
+				InLow = Zipped.val[0];
+				InHigh = Zipped.val[1];
+			}
+			else
+			{
+				const int16x8_t In = vld1q_s16(pIn + Done * 2);
+				InLow = vget_low_s16(In);
+				InHigh = vget_high_s16(In);
+			}
+			int32_t *pOut32 = pOut + Done * 2;
+			vst1q_s32(pOut32, vmlal_s16(vld1q_s32(pOut32), InLow, Volume));
+			vst1q_s32(pOut32 + 4, vmlal_s16(vld1q_s32(pOut32 + 4), InHigh, Volume));
+		}
+#endif
+	}
+#endif
+	MixVoiceScalar(pOut + Done * 2, pIn + Done * Channels, Channels, Frames - Done, VolumeL, VolumeR);
+}
+
+void MixToOutput(short *pOut, const int *pIn, unsigned Samples, int MasterVolume)
+{
+	for(unsigned i = 0; i < Samples; i++)
+		pOut[i] = std::clamp<int>(((pIn[i] * MasterVolume) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+}
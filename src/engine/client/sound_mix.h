@@ -0,0 +1,20 @@
+#ifndef ENGINE_CLIENT_SOUND_MIX_H
+#define ENGINE_CLIENT_SOUND_MIX_H
+
+/**
+ * Adds the frames of a mono or stereo sample, multiplied with the volume of
+ * each side, to a buffer of interleaved stereo frames.
+ *
+ * Uses SSE2 or NEON if available, the result is the same as the one of
+ * `MixVoiceScalar`.
+ */
+void MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int VolumeL, int VolumeR);
+void MixVoiceScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int VolumeL, int VolumeR);
+
+/**
+ * Applies the master volume (0-100) to the mixed samples and clamps them to
+ * the range of 16-bit samples.
+ */
+void MixToOutput(short *pOut, const int *pIn, unsigned Samples, int MasterVolume);
+
+#endif
@@ -0,0 +1,76 @@
+#include "sound_stream.h"
+
+#include <base/mem.h>
+
+#include <algorithm>
+#include <cstdint>
+
+void CSoundStreamBuffer::Init(int Channels, int SourceRate, int TargetRate, int SourceFrames, unsigned MaxFrames, int MaxRead, int DecoderFrame)
+{
+	m_Channels = Channels;
+	m_SourceRate = SourceRate;
+	m_TargetRate = TargetRate;
+	m_SourceFrames = SourceFrames;
+	m_vSource.resize(((size_t)((int64_t)MaxFrames * SourceRate / TargetRate) + 1 + MaxRead) * Channels);
+	m_vConverted.resize(SourceRate == TargetRate ? 0 : (size_t)MaxFrames * Channels);
+	m_SourceStart = DecoderFrame;
+	m_SourceBuffered = 0;
+}
+
+const short *CSoundStreamBuffer::Frames(ISoundStreamDecoder &Decoder, int Tick, unsigned Frames)
+{
+	if(Frames == 0)
+		return nullptr;
+
+	// source frames that are needed, the conversion matches CSound::RateConvert
+	const int First = (int)((int64_t)Tick * m_SourceRate / m_TargetRate);
+	const int Last = std::min((int)((int64_t)(Tick + Frames - 1) * m_SourceRate / m_TargetRate), m_SourceFrames - 1);
+	if(Last < First)
+		return nullptr;
+
+	if(First < m_SourceStart || First > m_SourceStart + m_SourceBuffered)
+	{
+		if(!Decoder.Seek(First))
+		{
+			m_SourceStart = -1;
+			m_SourceBuffered = 0;
+			return nullptr;
+		}
+		m_SourceStart = First;
+		m_SourceBuffered = 0;
+	}
+	else
+	{
+		// drop the frames that were already mixed
+		const int Mixed = First - m_SourceStart;
+		mem_move(m_vSource.data(), m_vSource.data() + Mixed * m_Channels, (size_t)(m_SourceBuffered - Mixed) * m_Channels * sizeof(short));
+		m_SourceStart = First;
+		m_SourceBuffered -= Mixed;
+	}
+
+	const int Capacity = m_vSource.size() / m_Channels;
+	while(m_SourceStart + m_SourceBuffered <= Last)
+	{
+		const int Read = Decoder.Read(m_vSource.data() + m_SourceBuffered * m_Channels, Capacity - m_SourceBuffered);
+		if(Read <= 0)
+		{
+			// error or unexpected end of the sample, play silence instead
+			const int Missing = Last + 1 - m_SourceStart - m_SourceBuffered;
+			mem_zero(m_vSource.data() + m_SourceBuffered * m_Channels, (size_t)Missing * m_Channels * sizeof(short));
+			m_SourceBuffered += Missing;
+			break;
+		}
+		m_SourceBuffered += Read;
+	}
+
+	if(m_SourceRate == m_TargetRate)
+		return m_vSource.data();
+
+	for(unsigned i = 0; i < Frames; i++)
+	{
+		const int Frame = std::min((int)((int64_t)(Tick + i) * m_SourceRate / m_TargetRate), Last) - First;
+		for(int c = 0; c < m_Channels; c++)
+			m_vConverted[i * m_Channels + c] = m_vSource[Frame * m_Channels + c];
+	}
+	return m_vConverted.data();
+}
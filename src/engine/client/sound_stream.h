@@ -0,0 +1,71 @@
+#ifndef ENGINE_CLIENT_SOUND_STREAM_H
+#define ENGINE_CLIENT_SOUND_STREAM_H
+
+#include <vector>
+
+/**
+ * Source of the frames of a streamed sample.
+ */
+class ISoundStreamDecoder
+{
+public:
+	virtual ~ISoundStreamDecoder() = default;
+
+	/**
+	 * Continues decoding at the given frame.
+	 *
+	 * @return `true` on success.
+	 */
+	virtual bool Seek(int Frame) = 0;
+
+	/**
+	 * Decodes the next frames.
+	 *
+	 * @return The number of decoded frames, `0` at the end of the sample or a
+	 * negative value on errors.
+	 */
+	virtual int Read(short *pBuffer, int MaxFrames) = 0;
+};
+
+/**
+ * Buffers the decoded frames of a streamed sample for the mixer and converts
+ * them to the mixing rate like the samples that are decoded when loading.
+ */
+class CSoundStreamBuffer
+{
+	int m_Channels = 0;
+	int m_SourceRate = 0;
+	int m_TargetRate = 0;
+	int m_SourceFrames = 0;
+
+	// decoded frames at the source rate, starting at m_SourceStart, which
+	// is -1 if the position of the decoder is unknown
+	std::vector<short> m_vSource;
+	int m_SourceStart = 0;
+	int m_SourceBuffered = 0;
+
+	// frames converted to the target rate, if it differs
+	std::vector<short> m_vConverted;
+
+public:
+	/**
+	 * @param SourceFrames Total number of frames of the sample at the source rate.
+	 * @param MaxFrames The most frames that are requested at once.
+	 * @param MaxRead The most frames that the decoder returns at once.
+	 * @param DecoderFrame The frame that the decoder reads next, `-1` if
+	 * it is unknown. Decoders can be reused at any position.
+	 */
+	void Init(int Channels, int SourceRate, int TargetRate, int SourceFrames, unsigned MaxFrames, int MaxRead, int DecoderFrame);
+
+	/**
+	 * Returns the frames at the target rate from Tick on. Frames that are
+	 * still buffered are reused, the decoder only seeks when Tick jumps, e.g.
+	 * because the voice looped. Frames that the decoder fails to return are
+	 * silent.
+	 *
+	 * @return The frames, or `nullptr` if there are none or seeking failed.
+	 */
+	const short *Frames(ISoundStreamDecoder &Decoder, int Tick, unsigned Frames);
+};
+
+#endif
@@ -35,6 +35,15 @@ public:
 	virtual void *FindItem(int Type, int Id) = 0;
 	virtual int NumItems() const = 0;
 
+	/**
+	 * Shares the data of maps loaded afterwards with other processes through
+	 * a cache folder in the save storage.
+	 *
+	 * @param pDirectory Cache folder, empty to disable the cache.
+	 *
+	 * @see CDataFileReader::SetDataCache
+	 */
+	virtual void SetDataCache(const char *pDirectory) = 0;
 	[[nodiscard]] virtual bool Load(const char *pFullName, IStorage *pStorage, const char *pPath, int StorageType) = 0;
 	[[nodiscard]] virtual bool Load(IStorage *pStorage, const char *pPath, int StorageType) = 0;
 	virtual void Unload() = 0;
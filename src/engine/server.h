@@ -22,8 +22,10 @@
 
 #include <algorithm>
 #include <array>
+#include <memory>
 #include <optional>
 #include <type_traits>
+#include <vector>
 
 struct CAntibotRoundData;
 class IMap;
@@ -331,6 +333,13 @@ public:
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 	virtual void SnapSetStaticsize7(int ItemType, int Size) = 0;
 
+	// Items added with `SnapNewItem` between `SnapStartRecording` and
+	// `SnapStopRecording` are also appended to the recording, so the same
+	// items can be added to the snapshot of another client with `SnapReplay`.
+	virtual void SnapStartRecording(std::vector<int> *pvRecording) = 0;
+	virtual void SnapStopRecording() = 0;
+	virtual void SnapReplay(const std::vector<int> &vRecording) = 0;
+
 	enum
 	{
 		RCON_CID_SERV = -1,
@@ -347,6 +356,9 @@ public:
 	virtual void RedirectClient(int ClientId, int Port) = 0;
 	virtual void ChangeMap(const char *pMap) = 0;
 	virtual void ReloadMap() = 0;
+	// Starts loading the map in the background, so a following change to
+	// it does not stall the server.
+	virtual void PreloadMap(const char *pMap) = 0;
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
@@ -397,6 +409,9 @@ public:
 	// `pPersistentData` may be null if this is the last time `IGameServer`
 	// is destroyed.
 	virtual void OnShutdown(void *pPersistentData) = 0;
+	// Called on a job thread for a map that is preloaded, to prepare its
+	// data for `OnInit`. Must not access anything but `pMap`.
+	virtual void OnMapPreload(IMap *pMap) = 0;
 
 	virtual void OnTick() = 0;
 
@@ -456,6 +471,8 @@ public:
 
 	virtual IMap *Map() = 0;
 	virtual const IMap *Map() const = 0;
+	// Replaces the map with `pMap`, which then holds the previous map.
+	virtual void SwapMap(std::unique_ptr<IMap> &pMap) = 0;
 	virtual CNetObjHandler *GetNetObjHandler() = 0;
 	virtual protocol7::CNetObjHandler *GetNetObjHandler7() = 0;
 
@@ -5,8 +5,12 @@
 
 #include <engine/shared/protocol.h>
 
+#include <list>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 enum
 {
@@ -14,6 +18,70 @@ enum
 	MAX_NAME_LENGTH_SQL = MAX_NAME_LENGTH - 1,
 };
 
+// LRU cache of prepared statements keyed by their SQL text, so that
+// recurring queries skip parsing and planning. Owns the statements and
+// releases evicted ones with TDeleter.
+template<typename TStmt, typename TDeleter>
+class CPreparedStatementCache
+{
+	struct CEntry
+	{
+		std::string m_Sql;
+		std::unique_ptr<TStmt, TDeleter> m_pStmt;
+	};
+	// most recently used first
+	std::list<CEntry> m_Entries;
+	// keys point into m_Entries, list nodes don't move
+	std::unordered_map<std::string_view, typename std::list<CEntry>::iterator> m_Lookup;
+
+public:
+	// returns the statement prepared for pSql and marks it as most recently
+	// used, nullptr if there is none
+	TStmt *Find(const char *pSql)
+	{
+		auto It = m_Lookup.find(pSql);
+		if(It == m_Lookup.end())
+			return nullptr;
+		m_Entries.splice(m_Entries.begin(), m_Entries, It->second);
+		return It->second->m_pStmt.get();
+	}
+
+	// takes ownership of pStmt and evicts the least recently used
+	// statements to hold at most Capacity (at least one) statements
+	TStmt *Insert(const char *pSql, std::unique_ptr<TStmt, TDeleter> pStmt, int Capacity)
+	{
+		m_Entries.push_front(CEntry{pSql, std::move(pStmt)});
+		m_Lookup[m_Entries.front().m_Sql] = m_Entries.begin();
+		while(m_Entries.size() > 1 && (int)m_Entries.size() > Capacity)
+		{
+			m_Lookup.erase(m_Entries.back().m_Sql);
+			m_Entries.pop_back();
+		}
+		return m_Entries.front().m_pStmt.get();
+	}
+
+	void Remove(TStmt *pStmt)
+	{
+		for(auto It = m_Entries.begin(); It != m_Entries.end(); ++It)
+		{
+			if(It->m_pStmt.get() == pStmt)
+			{
+				m_Lookup.erase(It->m_Sql);
+				m_Entries.erase(It);
+				return;
+			}
+		}
+	}
+
+	void Clear()
+	{
+		m_Lookup.clear();
+		m_Entries.clear();
+	}
+
+	int Size() const { return m_Entries.size(); }
+};
+
 // can hold one PreparedStatement with Results
 class IDbConnection
 {
@@ -23,6 +91,15 @@ public:
 	IDbConnection &operator=(const IDbConnection &) = delete;
 	virtual void Print(const char *pMode) = 0;
 
+	enum
+	{
+		DEFAULT_STATEMENT_CACHE_SIZE = 16,
+	};
+
+	// number of prepared statements kept around for reuse, a size of one
+	// only reuses the statement of the previous query
+	void SetStatementCacheSize(int Size) { m_StatementCacheSize = Size; }
+
 	// returns the database prefix
 	const char *GetPrefix() const { return m_aPrefix; }
 	virtual const char *BinaryCollate() const = 0;
@@ -48,7 +125,8 @@ public:
 	// has to be called to return the connection back to the pool
 	virtual void Disconnect() = 0;
 
-	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements
+	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements.
+	// Statements are cached by their SQL text, so bind values instead of formatting them into pStmt
 	//
 	// returns true on success
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) = 0;
@@ -93,6 +171,8 @@ private:
 	char m_aPrefix[64];
 
 protected:
+	int m_StatementCacheSize = DEFAULT_STATEMENT_CACHE_SIZE;
+
 	void FormatCreateRace(char *aBuf, unsigned int BufferSize, bool Backup) const;
 	void FormatCreateTeamrace(char *aBuf, unsigned int BufferSize, const char *pIdType, bool Backup) const;
 	void FormatCreateMaps(char *aBuf, unsigned int BufferSize) const;
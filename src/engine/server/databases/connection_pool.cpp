@@ -7,10 +7,13 @@
 #include <base/mem.h>
 #include <base/str.h>
 #include <base/thread.h>
+#include <base/time.h>
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -69,6 +72,18 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	// set when a query is queued, used for the latency statistics
+	int64_t m_QueueTime = 0;
+
+	bool IsQuery() const { return m_Mode == READ_ACCESS || m_Mode == WRITE_ACCESS; }
+	void Complete(bool Success) const
+	{
+		if(m_pThreadData != nullptr && m_pThreadData->m_pResult != nullptr)
+		{
+			m_pThreadData->m_pResult->m_Success = Success;
+			m_pThreadData->m_pResult->m_Completed.store(true);
+		}
+	}
 };
 
 CSqlExecData::CSqlExecData(
@@ -121,25 +136,118 @@ CSqlExecData::CSqlExecData(CDbConnectionPool::Mode m) :
 	m_Ptr.m_Print.m_Mode = m;
 }
 
-void CDbConnectionPool::Print(Mode DatabaseMode)
+void CDbConnectionPool::CLaneStats::OnQueued()
+{
+	const int Queued = m_Queued.fetch_add(1) + 1;
+	int MaxQueued = m_MaxQueued.load();
+	while(Queued > MaxQueued && !m_MaxQueued.compare_exchange_weak(MaxQueued, Queued))
+	{
+	}
+}
+
+void CDbConnectionPool::CLaneStats::OnDone(int64_t QueueTime, bool Success)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode);
+	const int64_t Latency = time_get_impl() - QueueTime;
+	m_LatencySum.fetch_add(Latency);
+	int64_t LatencyMax = m_LatencyMax.load();
+	while(Latency > LatencyMax && !m_LatencyMax.compare_exchange_weak(LatencyMax, Latency))
+	{
+	}
+	m_NumDone.fetch_add(1);
+	if(!Success)
+		m_NumFailed.fetch_add(1);
+}
+
+void CDbConnectionPool::QueueWrite(std::unique_ptr<CSqlExecData> pData)
+{
+	CLaneStats &Stats = m_pShared->m_aStats[LANE_WRITE];
+	// only the main thread takes free slots, so the value can't drop below
+	// what is read here
+	if(pData->IsQuery() && m_pShared->m_NumFree.GetApproximateValue() <= 0)
+	{
+		// don't overwrite queued writes and don't stall the main thread
+		// until the worker catches up, fail the query like the read lane
+		Stats.m_NumFull.fetch_add(1);
+		if(time_get() > m_LastWriteQueueFullWarning + time_freq())
+		{
+			m_LastWriteQueueFullWarning = time_get();
+			log_warn("sql", "write queue is full, rejecting %s. rejected=%" PRIu64, pData->m_pName, Stats.m_NumFull.load());
+		}
+		pData->Complete(false);
+		return;
+	}
+	if(pData->IsQuery())
+	{
+		pData->m_QueueTime = time_get_impl();
+		Stats.OnQueued();
+	}
+	// registering databases and printing can't be rejected, they only come
+	// from the config and the console
+	m_pShared->m_NumFree.Wait();
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pData);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::QueueRead(std::unique_ptr<CSqlExecData> pData)
+{
+	StartReadWorkers();
+	CLaneStats &Stats = m_pShared->m_aStats[LANE_READ];
+	{
+		CLockScope LockScope(m_pShared->m_ReadLock);
+		if(pData->IsQuery() && (int)m_pShared->m_vpReadQueries.size() >= g_Config.m_SvSqlReadQueueSize)
+		{
+			// fail the query right away instead of letting the queue grow
+			// without bounds, the caller handles it like a database error
+			Stats.m_NumFull.fetch_add(1);
+			if(time_get() > m_LastReadQueueFullWarning + time_freq())
+			{
+				m_LastReadQueueFullWarning = time_get();
+				log_warn("sql", "read queue is full, rejecting %s. rejected=%" PRIu64, pData->m_pName, Stats.m_NumFull.load());
+			}
+			pData->Complete(false);
+			return;
+		}
+		if(pData->IsQuery())
+		{
+			pData->m_QueueTime = time_get_impl();
+			Stats.OnQueued();
+		}
+		m_pShared->m_vpReadQueries.push_back(std::move(pData));
+	}
+	m_pShared->m_NumRead.Signal();
+}
+
+void CDbConnectionPool::Print(Mode DatabaseMode)
+{
+	if(DatabaseMode == Mode::READ)
+		QueueRead(std::make_unique<CSqlExecData>(DatabaseMode));
+	else
+		QueueWrite(std::make_unique<CSqlExecData>(DatabaseMode));
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFilename);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+		RegisterReadDatabase(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
+	else
+		QueueWrite(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+		RegisterReadDatabase(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
+	else
+		QueueWrite(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
+}
+
+void CDbConnectionPool::RegisterReadDatabase(std::unique_ptr<CSqlExecData> pData)
+{
+	// every read worker connects to the new database before its next query
+	StartReadWorkers();
+	CLockScope LockScope(m_pShared->m_ReadLock);
+	m_pShared->m_vpReadDatabases.push_back(std::move(pData));
 }
 
 void CDbConnectionPool::Execute(
@@ -147,9 +255,7 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	QueueRead(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -157,9 +263,24 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	QueueWrite(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
+}
+
+void CDbConnectionPool::PrintStats()
+{
+	for(int Lane = 0; Lane < NUM_LANES; Lane++)
+	{
+		const CLaneStats &Stats = m_pShared->m_aStats[Lane];
+		const uint64_t NumDone = Stats.m_NumDone.load();
+		const double LatencyAvg = NumDone ? Stats.m_LatencySum.load() * 1000.0 / time_freq() / NumDone : 0.0;
+		const double LatencyMax = Stats.m_LatencyMax.load() * 1000.0 / time_freq();
+		log_info("server", "%s lane: workers=%d queued=%d max_queued=%d done=%" PRIu64 " failed=%" PRIu64 " rejected=%" PRIu64 " latency_avg=%.2fms latency_max=%.2fms",
+			Lane == LANE_READ ? "read" : "write",
+			Lane == LANE_READ ? (int)m_vpReadThreads.size() : 1,
+			Stats.m_Queued.load(), Stats.m_MaxQueued.load(), NumDone, Stats.m_NumFailed.load(),
+			Stats.m_NumFull.load(),
+			LatencyAvg, LatencyMax);
+	}
 }
 
 void CDbConnectionPool::OnShutdown()
@@ -168,6 +289,16 @@ void CDbConnectionPool::OnShutdown()
 		return;
 	m_Shutdown = true;
 	m_pShared->m_Shutdown.store(true);
+	// the read workers dismiss the remaining read queries and exit
+	{
+		CLockScope LockScope(m_pShared->m_ReadLock);
+		for(size_t i = 0; i < m_vpReadThreads.size(); i++)
+			m_pShared->m_vpReadQueries.push_back(nullptr);
+	}
+	for(size_t i = 0; i < m_vpReadThreads.size(); i++)
+		m_pShared->m_NumRead.Signal();
+	// the empty slot after the last query signals the shutdown to the write lane
+	m_pShared->m_NumFree.Wait();
 	m_pShared->m_NumBackup.Signal();
 	int i = 0;
 	while(m_pShared->m_Shutdown.load())
@@ -180,6 +311,9 @@ void CDbConnectionPool::OnShutdown()
 		++i;
 		std::this_thread::sleep_for(100ms);
 	}
+	for(void *pThread : m_vpReadThreads)
+		thread_wait(pThread);
+	m_vpReadThreads.clear();
 }
 
 // The backup worker thread looks at write queries and stores them
@@ -241,9 +375,10 @@ void CBackup::ProcessQueries()
 	}
 }
 
-// the worker threads executes queries on mysql or sqlite. If we write on
-// a mysql server and have a backup server configured, we'll remove the
-// entry from the backup server after completing it on the write server.
+// the worker thread executes write queries on mysql or sqlite in order. If
+// we write on a mysql server and have a backup server configured, we'll
+// remove the entry from the backup server after completing it on the write
+// server.
 // static void Worker(void *pUser);
 class CWorker
 {
@@ -265,8 +400,8 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
+	// The READ servers are connected to by the read workers.
 	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -283,10 +418,8 @@ void CWorker::Start(void *pUser)
 
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// until all requests are handled
 	bool FailMode = false;
 	for(int JobNum = 0;; JobNum++)
 	{
@@ -296,45 +429,20 @@ void CWorker::ProcessQueries()
 		}
 		m_pShared->m_NumWorker.Wait();
 		auto pThreadData = std::move(m_pShared->m_aQueries[JobNum % std::size(m_pShared->m_aQueries)]);
+		m_pShared->m_NumFree.Signal();
 		// work through all database jobs after OnShutdown is called before exiting the thread
 		if(pThreadData == nullptr)
 		{
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
+		if(pThreadData->IsQuery())
+			m_pShared->m_aStats[CDbConnectionPool::LANE_WRITE].m_Queued.fetch_sub(1);
 		bool Success = false;
 		switch(pThreadData->m_Mode)
 		{
 		case CSqlExecData::READ_ACCESS:
-		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
-			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
-					break;
-				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					if(m_DebugSql)
-						dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
-			}
-			if(!Success)
-			{
-				FailMode = true;
-			}
-		}
-		break;
+			dbg_assert_failed("read queries are executed by the read workers");
 		case CSqlExecData::WRITE_ACCESS:
 		{
 			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
@@ -368,8 +476,7 @@ void CWorker::ProcessQueries()
 			switch(pThreadData->m_Ptr.m_Mysql.m_Mode)
 			{
 			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
+				dbg_assert_failed("read databases are registered with the read workers");
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pMysql);
 				break;
@@ -388,8 +495,7 @@ void CWorker::ProcessQueries()
 			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
 			{
 			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
+				dbg_assert_failed("read databases are registered with the read workers");
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pSqlite);
 				break;
@@ -409,24 +515,15 @@ void CWorker::ProcessQueries()
 		}
 		if(!Success)
 			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
-		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
-		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
-		}
+		if(pThreadData->IsQuery())
+			m_pShared->m_aStats[CDbConnectionPool::LANE_WRITE].OnDone(pThreadData->m_QueueTime, Success);
+		pThreadData->Complete(Success);
 	}
 }
 
 void CWorker::Print(CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print("Read");
-		if(m_vpReadConnections.empty())
-			log_info("server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print("Write");
@@ -442,6 +539,125 @@ void CWorker::Print(CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute read queries on the READ servers. Read queries
+// don't depend on each other, so that multiple read workers with their own
+// connections can work on them in parallel. A slow read query therefore
+// doesn't delay the write queries of the worker thread.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, int DebugSql) :
+		m_DebugSql(DebugSql), m_pShared(std::move(pShared)) {}
+	static void Start(void *pUser);
+
+private:
+	void ProcessQueries();
+	void Print();
+
+	bool m_DebugSql;
+
+	// connections to `CSharedData::m_vpReadDatabases`, in the same order
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	CDbConnectionPool::CLaneStats &Stats = m_pShared->m_aStats[CDbConnectionPool::LANE_READ];
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	// enter fail mode when a read request fails, skip read requests during
+	// it until all queued requests are handled
+	bool FailMode = false;
+	while(true)
+	{
+		if(FailMode && m_pShared->m_NumRead.GetApproximateValue() == 0)
+		{
+			FailMode = false;
+		}
+		m_pShared->m_NumRead.Wait();
+		std::unique_ptr<CSqlExecData> pThreadData;
+		std::vector<const CSqlExecData *> vpNewDatabases;
+		{
+			CLockScope LockScope(m_pShared->m_ReadLock);
+			pThreadData = std::move(m_pShared->m_vpReadQueries.front());
+			m_pShared->m_vpReadQueries.pop_front();
+			// registered databases are never changed or removed while the workers run
+			for(size_t i = m_vpReadConnections.size(); i < m_pShared->m_vpReadDatabases.size(); i++)
+				vpNewDatabases.push_back(m_pShared->m_vpReadDatabases[i].get());
+		}
+		for(const CSqlExecData *pDatabase : vpNewDatabases)
+		{
+			if(pDatabase->m_Mode == CSqlExecData::ADD_MYSQL)
+				m_vpReadConnections.push_back(CreateMysqlConnection(pDatabase->m_Ptr.m_Mysql.m_Config));
+			else
+				m_vpReadConnections.push_back(CreateSqliteConnection(pDatabase->m_Ptr.m_Sqlite.m_Filename, true));
+		}
+
+		// work through all queued read jobs after OnShutdown is called before exiting the thread
+		if(pThreadData == nullptr)
+		{
+			return;
+		}
+		if(pThreadData->m_Mode == CSqlExecData::PRINT)
+		{
+			Print();
+			continue;
+		}
+		dbg_assert(pThreadData->m_Mode == CSqlExecData::READ_ACCESS, "unexpected query on the read lane");
+		Stats.m_Queued.fetch_sub(1);
+
+		const int JobNum = m_pShared->m_NextReadJob.fetch_add(1);
+		bool Success = false;
+		for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+		{
+			if(m_pShared->m_Shutdown)
+			{
+				dbg_msg("sql", "[r%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
+				break;
+			}
+			if(FailMode)
+			{
+				dbg_msg("sql", "[r%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
+				break;
+			}
+			int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+			if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+			{
+				ReadServer = CurServer;
+				if(m_DebugSql)
+					dbg_msg("sql", "[r%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
+				Success = true;
+				break;
+			}
+		}
+		if(!Success)
+		{
+			FailMode = true;
+			dbg_msg("sql", "[r%i] %s failed on all databases", JobNum, pThreadData->m_pName);
+		}
+		Stats.OnDone(pThreadData->m_QueueTime, Success);
+		pThreadData->Complete(Success);
+	}
+}
+
+void CReadWorker::Print()
+{
+	for(auto &pReadConnection : m_vpReadConnections)
+		pReadConnection->Print("Read");
+	if(m_vpReadConnections.empty())
+		log_info("server", "There are no read databases");
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -476,9 +692,24 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 	return Success;
 }
 
+void CDbConnectionPool::StartReadWorkers()
+{
+	if(!m_vpReadThreads.empty() || m_Shutdown)
+		return;
+	const int NumThreads = std::max(g_Config.m_SvSqlReadWorkers, 1);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		char aName[32];
+		str_format(aName, sizeof(aName), "database read worker %d", i);
+		m_vpReadThreads.push_back(thread_init(CReadWorker::Start, new CReadWorker(m_pShared, g_Config.m_DbgSql), aName));
+	}
+}
+
 CDbConnectionPool::CDbConnectionPool()
 {
 	m_pShared = std::make_shared<CSharedData>();
+	for(size_t i = 0; i < std::size(m_pShared->m_aQueries); i++)
+		m_pShared->m_NumFree.Signal();
 	m_pWorkerThread = thread_init(CWorker::Start, new CWorker(m_pShared, g_Config.m_DbgSql), "database worker thread");
 	m_pBackupThread = thread_init(CBackup::Start, new CBackup(m_pShared, g_Config.m_DbgSql), "database backup worker thread");
 }
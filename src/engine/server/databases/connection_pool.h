@@ -1,10 +1,12 @@
 #ifndef ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 #define ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 
+#include <base/lock.h>
 #include <base/sphore.h>
 #include <base/types.h>
 
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -96,19 +98,56 @@ public:
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 
+	// logs queue depth, throughput and latency of the read and write lanes
+	void PrintStats();
+
 	void OnShutdown();
 
 	friend class CWorker;
 	friend class CBackup;
+	friend class CReadWorker;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
 
+	// queues on the ordered write lane, queries fail right away if it is full
+	void QueueWrite(std::unique_ptr<struct CSqlExecData> pData);
+	// queues on the read lane, starts the read workers on first use
+	void QueueRead(std::unique_ptr<struct CSqlExecData> pData);
+	void RegisterReadDatabase(std::unique_ptr<struct CSqlExecData> pData);
+	void StartReadWorkers();
+
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
 	int m_InsertIdx = 0;
 
 	bool m_Shutdown = false;
+	int64_t m_LastReadQueueFullWarning = 0;
+	int64_t m_LastWriteQueueFullWarning = 0;
+
+	enum
+	{
+		LANE_READ,
+		LANE_WRITE,
+		NUM_LANES,
+	};
+
+	struct CLaneStats
+	{
+		// queries waiting for a worker
+		std::atomic_int m_Queued{0};
+		std::atomic_int m_MaxQueued{0};
+		std::atomic<uint64_t> m_NumDone{0};
+		std::atomic<uint64_t> m_NumFailed{0};
+		// queries failed because the queue was full
+		std::atomic<uint64_t> m_NumFull{0};
+		// time from queueing to completion
+		std::atomic<int64_t> m_LatencySum{0};
+		std::atomic<int64_t> m_LatencyMax{0};
+
+		void OnQueued();
+		void OnDone(int64_t QueueTime, bool Success);
+	};
 
 	struct CSharedData
 	{
@@ -127,11 +166,26 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+		// Number of free slots in `m_aQueries`, the worker thread signals it
+		// after taking a query out of the queue.
+		CSemaphore m_NumFree;
+
+		// Read queries are independent of each other and executed by
+		// multiple read workers, each with its own connections.
+		CLock m_ReadLock;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_vpReadQueries GUARDED_BY(m_ReadLock);
+		// registered read databases, every read worker connects to all of them
+		std::vector<std::unique_ptr<struct CSqlExecData>> m_vpReadDatabases GUARDED_BY(m_ReadLock);
+		CSemaphore m_NumRead;
+		std::atomic_int m_NextReadJob{0};
+
+		CLaneStats m_aStats[NUM_LANES];
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
 	void *m_pWorkerThread = nullptr;
 	void *m_pBackupThread = nullptr;
+	std::vector<void *> m_vpReadThreads;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
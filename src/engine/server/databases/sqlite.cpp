@@ -59,13 +59,24 @@ public:
 	bool CreateFailsafeTables();
 
 private:
+	class CStmtDeleter
+	{
+	public:
+		void operator()(sqlite3_stmt *pStmt) const;
+	};
+
 	// copy of config vars
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_Setup;
 
 	sqlite3 *m_pDb;
+	// current statement, owned by m_Statements
 	sqlite3_stmt *m_pStmt;
+	CPreparedStatementCache<sqlite3_stmt, CStmtDeleter> m_Statements;
 	bool m_Done; // no more rows available for Step
+	// resets the current statement for its next use, so it doesn't keep the
+	// read transaction open or point to stale bindings
+	void ReleaseStatement();
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
 	// returns true on failure
@@ -91,12 +102,18 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	// statements have to be finalized before the database can be closed
+	m_pStmt = nullptr;
+	m_Statements.Clear();
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
 
+void CSqliteConnection::CStmtDeleter::operator()(sqlite3_stmt *pStmt) const
+{
+	sqlite3_finalize(pStmt);
+}
+
 void CSqliteConnection::Print(const char *pMode)
 {
 	log_info("server",
@@ -182,26 +199,39 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
-	m_pStmt = nullptr;
+	ReleaseStatement();
 	m_InUse.store(false);
 }
 
-bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+void CSqliteConnection::ReleaseStatement()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	if(m_pStmt == nullptr)
+		return;
+	// the error of the last step was already reported by Step
+	sqlite3_reset(m_pStmt);
+	sqlite3_clear_bindings(m_pStmt);
 	m_pStmt = nullptr;
-	int Result = sqlite3_prepare_v2(
-		m_pDb,
-		pStmt,
-		-1, // pStmt can be any length
-		&m_pStmt,
-		nullptr);
-	if(FormatError(Result, pError, ErrorSize))
+}
+
+bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+{
+	ReleaseStatement();
+	m_pStmt = m_Statements.Find(pStmt);
+	if(m_pStmt == nullptr)
 	{
-		return false;
+		sqlite3_stmt *pNewStmt = nullptr;
+		int Result = sqlite3_prepare_v2(
+			m_pDb,
+			pStmt,
+			-1, // pStmt can be any length
+			&pNewStmt,
+			nullptr);
+		if(FormatError(Result, pError, ErrorSize))
+		{
+			sqlite3_finalize(pNewStmt);
+			return false;
+		}
+		m_pStmt = m_Statements.Insert(pStmt, std::unique_ptr<sqlite3_stmt, CStmtDeleter>(pNewStmt), m_StatementCacheSize);
 	}
 	m_Done = false;
 	return true;
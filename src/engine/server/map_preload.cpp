@@ -0,0 +1,210 @@
+#include "map_preload.h"
+
+#include <base/io.h>
+#include <base/log.h>
+#include <base/mem.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/server.h>
+#include <engine/storage.h>
+
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+static const char *DATA_CACHE_DIRECTORY = "mapcache";
+
+// Maps the file if it has exactly the expected contents.
+static void *MapIfEqual(IStorage *pStorage, const char *pPath, const void *pExpected, unsigned ExpectedSize)
+{
+	IOHANDLE File = pStorage->OpenFile(pPath, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		return nullptr;
+	}
+	int64_t Size;
+	void *pData = io_map(File, &Size);
+	io_close(File);
+	if(pData == nullptr)
+	{
+		return nullptr;
+	}
+	if(Size != ExpectedSize || mem_comp(pData, pExpected, ExpectedSize) != 0)
+	{
+		io_unmap(pData, Size);
+		return nullptr;
+	}
+	return pData;
+}
+
+// Reads the file and replaces it with a mapping of a copy in the map cache,
+// which is shared with other processes. The files in the maps folders can't
+// be mapped directly, overwriting them in place would change the data or
+// crash the server while it is sent.
+static bool ReadSharedFile(IStorage *pStorage, const char *pPath, void **ppData, unsigned *pSize, bool *pShared)
+{
+	void *pFileData;
+	unsigned FileSize;
+	if(!pStorage->ReadFile(pPath, IStorage::TYPE_ALL, &pFileData, &FileSize))
+	{
+		return false;
+	}
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(sha256(pFileData, FileSize), aSha256, sizeof(aSha256));
+	char aCachePath[IO_MAX_PATH_LENGTH];
+	str_format(aCachePath, sizeof(aCachePath), "%s/%s.map", DATA_CACHE_DIRECTORY, aSha256);
+	void *pData = MapIfEqual(pStorage, aCachePath, pFileData, FileSize);
+	if(pData == nullptr)
+	{
+		char aTmpPath[IO_MAX_PATH_LENGTH];
+		IStorage::FormatTmpPath(aTmpPath, sizeof(aTmpPath), aCachePath);
+		IOHANDLE File = pStorage->OpenFile(aTmpPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			const bool Written = io_write(File, pFileData, FileSize) == FileSize;
+			if(io_close(File) == 0 && Written && pStorage->RenameFile(aTmpPath, aCachePath, IStorage::TYPE_SAVE))
+				pData = MapIfEqual(pStorage, aCachePath, pFileData, FileSize);
+			else
+				pStorage->RemoveFile(aTmpPath, IStorage::TYPE_SAVE);
+		}
+	}
+
+	if(pData == nullptr)
+	{
+		log_error("map_preload", "failed to share map file, keeping it in memory. file='%s'", pPath);
+		*ppData = pFileData;
+		*pShared = false;
+	}
+	else
+	{
+		free(pFileData);
+		*ppData = pData;
+		*pShared = true;
+	}
+	*pSize = FileSize;
+	return true;
+}
+
+// Removes the files in the map cache that haven't been written for the
+// given number of days, the cache is keyed by content and never cleaned up
+// otherwise. Processes still using removed files keep their mappings.
+static void EvictDataCache(IStorage *pStorage, int MaxAgeDays)
+{
+	struct SEvictData
+	{
+		time_t m_MinTime;
+		std::vector<std::string> m_vOldFiles;
+	};
+	SEvictData Data;
+	Data.m_MinTime = time_timestamp() - (int64_t)MaxAgeDays * 24 * 60 * 60;
+	pStorage->ListDirectoryInfo(
+		IStorage::TYPE_SAVE, DATA_CACHE_DIRECTORY, [](const CFsFileInfo *pInfo, int IsDir, int StorageType, void *pUser) {
+			SEvictData *pData = static_cast<SEvictData *>(pUser);
+			if(!IsDir && pInfo->m_TimeModified < pData->m_MinTime)
+				pData->m_vOldFiles.emplace_back(pInfo->m_pName);
+			return 0;
+		},
+		&Data);
+
+	for(const std::string &File : Data.m_vOldFiles)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", DATA_CACHE_DIRECTORY, File.c_str());
+		if(pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE))
+			log_trace("map_preload", "removed old map cache file. file='%s'", aPath);
+	}
+}
+
+CMapPreloadJob::CMapPreloadJob(IStorage *pStorage, IGameServer *pGameServer, const char *pMapName, const char *pPath, bool Sixup, bool SharedData, int DataCacheMaxAge) :
+	m_pStorage(pStorage),
+	m_pGameServer(pGameServer),
+	m_Sixup(Sixup),
+	m_SharedData(SharedData),
+	m_DataCacheMaxAge(DataCacheMaxAge)
+{
+	str_copy(m_aMapName, pMapName);
+	str_copy(m_aPath, pPath);
+}
+
+CMapPreloadJob::~CMapPreloadJob()
+{
+	FreeData(m_pData, m_DataSize, m_DataShared);
+	FreeData(m_pSixupData, m_SixupDataSize, m_SixupDataShared);
+}
+
+void CMapPreloadJob::FreeData(unsigned char *pData, unsigned Size, bool SharedData)
+{
+	if(SharedData && pData != nullptr)
+		io_unmap(pData, Size);
+	else
+		free(pData);
+}
+
+void CMapPreloadJob::Run()
+{
+	Load();
+	if(m_pMap && m_pGameServer)
+		m_pGameServer->OnMapPreload(m_pMap.get());
+}
+
+void CMapPreloadJob::Load()
+{
+	const int64_t Start = time_get_impl();
+	m_pMap = CreateMap();
+	if(m_SharedData)
+	{
+		if(m_DataCacheMaxAge > 0)
+			EvictDataCache(m_pStorage, m_DataCacheMaxAge);
+		m_pMap->SetDataCache(DATA_CACHE_DIRECTORY);
+	}
+	if(!m_pMap->Load(m_aMapName, m_pStorage, m_aPath, IStorage::TYPE_ALL))
+	{
+		m_pMap = nullptr;
+		return;
+	}
+
+	const auto ReadData = [&](const char *pPath, void **ppData, unsigned *pSize, bool *pShared) {
+		if(m_SharedData)
+			return ReadSharedFile(m_pStorage, pPath, ppData, pSize, pShared);
+		*pShared = false;
+		return m_pStorage->ReadFile(pPath, IStorage::TYPE_ALL, ppData, pSize);
+	};
+
+	void *pData;
+	if(ReadData(m_aPath, &pData, &m_DataSize, &m_DataShared))
+		m_pData = (unsigned char *)pData;
+
+	if(m_Sixup)
+	{
+		char aSixupPath[IO_MAX_PATH_LENGTH];
+		str_format(aSixupPath, sizeof(aSixupPath), "maps7/%s.map", m_aMapName);
+		if(ReadData(aSixupPath, &pData, &m_SixupDataSize, &m_SixupDataShared))
+		{
+			m_pSixupData = (unsigned char *)pData;
+			m_SixupSha256 = sha256(m_pSixupData, m_SixupDataSize);
+			m_SixupCrc = crc32(0, m_pSixupData, m_SixupDataSize);
+		}
+	}
+	m_Duration = time_get_impl() - Start;
+}
+
+unsigned char *CMapPreloadJob::TakeData(unsigned *pSize, bool *pShared)
+{
+	unsigned char *pData = m_pData;
+	*pSize = m_DataSize;
+	*pShared = m_DataShared;
+	m_pData = nullptr;
+	return pData;
+}
+
+unsigned char *CMapPreloadJob::TakeSixupData(unsigned *pSize, bool *pShared)
+{
+	unsigned char *pData = m_pSixupData;
+	*pSize = m_SixupDataSize;
+	*pShared = m_SixupDataShared;
+	m_pSixupData = nullptr;
+	return pData;
+}
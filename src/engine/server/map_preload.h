@@ -0,0 +1,86 @@
+#ifndef ENGINE_SERVER_MAP_PRELOAD_H
+#define ENGINE_SERVER_MAP_PRELOAD_H
+
+#include <base/hash.h>
+#include <base/types.h>
+
+#include <engine/map.h>
+#include <engine/shared/jobs.h>
+
+#include <memory>
+
+class IGameServer;
+class IStorage;
+
+/**
+ * Loads a map and everything the server needs to switch to it: the parsed
+ * datafile, the file contents for the map download and the optional 0.7
+ * version of the map with its hashes.
+ *
+ * Runs as a job to prepare a map change in the background, or synchronously
+ * with `Load` when no matching preload exists.
+ *
+ * With shared data, the file contents and the decompressed map data are
+ * shared through copies in the `mapcache` folder, so server processes
+ * serving the same maps share their memory. Files in the folder that
+ * weren't written for `DataCacheMaxAge` days are removed when loading.
+ */
+class CMapPreloadJob : public IJob
+{
+	IStorage *m_pStorage;
+	IGameServer *m_pGameServer;
+	char m_aMapName[MAX_MAP_LENGTH];
+	char m_aPath[IO_MAX_PATH_LENGTH];
+	bool m_Sixup;
+	bool m_SharedData;
+	int m_DataCacheMaxAge;
+
+	std::unique_ptr<IMap> m_pMap;
+	unsigned char *m_pData = nullptr;
+	unsigned m_DataSize = 0;
+	bool m_DataShared = false;
+	unsigned char *m_pSixupData = nullptr;
+	unsigned m_SixupDataSize = 0;
+	bool m_SixupDataShared = false;
+	SHA256_DIGEST m_SixupSha256 = {};
+	unsigned m_SixupCrc = 0;
+	int64_t m_Duration = 0;
+
+	void Run() override;
+
+public:
+	/**
+	 * @param pGameServer Game server whose `OnMapPreload` is called on the
+	 * job thread, may be `nullptr`.
+	 * @param DataCacheMaxAge Age in days after which files in the map cache
+	 * are removed, `0` to keep them.
+	 */
+	CMapPreloadJob(IStorage *pStorage, IGameServer *pGameServer, const char *pMapName, const char *pPath, bool Sixup, bool SharedData, int DataCacheMaxAge);
+	~CMapPreloadJob() override;
+
+	void Load();
+
+	const char *MapName() const { return m_aMapName; }
+	const char *Path() const { return m_aPath; }
+	bool Sixup() const { return m_Sixup; }
+	bool SharedData() const { return m_SharedData; }
+	int64_t Duration() const { return m_Duration; }
+
+	/**
+	 * The loaded map, `nullptr` if loading failed. May be swapped with the
+	 * current map of the game.
+	 */
+	std::unique_ptr<IMap> &Map() { return m_pMap; }
+	/**
+	 * Transfers the ownership of the file contents to the caller, the data
+	 * must be freed with `FreeData` and the returned shared flag.
+	 */
+	unsigned char *TakeData(unsigned *pSize, bool *pShared);
+	unsigned char *TakeSixupData(unsigned *pSize, bool *pShared);
+	SHA256_DIGEST SixupSha256() const { return m_SixupSha256; }
+	unsigned SixupCrc() const { return m_SixupCrc; }
+
+	static void FreeData(unsigned char *pData, unsigned Size, bool SharedData);
+};
+
+#endif
@@ -120,9 +120,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 
 		if(NetMatch(&Data, Server()->ClientAddr(i)))
 		{
-			CNetHash NetHash(&Data);
 			char aBuf[256];
-			MakeBanInfo(pBanPool->Find(&Data, &NetHash), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
+			MakeBanInfo(pBanPool->Find(&Data), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
 			Server()->m_NetServer.Drop(i, aBuf);
 		}
 	}
@@ -130,6 +129,28 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 	return Result;
 }
 
+void CServerBan::OnBansLoaded()
+{
+	// drop banned clients like BanExt, but keep the client loading the bans
+	// and the ones it couldn't ban
+	const int RconClientId = Server()->m_RconClientId;
+	bool FromClient = false;
+	if(RconClientId >= 0 && RconClientId < MAX_CLIENTS)
+		FromClient = Server()->m_aClients[RconClientId].m_State != CServer::CClient::STATE_EMPTY;
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(Server()->m_aClients[i].m_State == CServer::CClient::STATE_EMPTY)
+			continue;
+
+		if(FromClient && (i == RconClientId || Server()->GetAuthedState(i) >= Server()->m_RconAuthLevel))
+			continue;
+
+		char aBuf[256];
+		if(IsBanned(Server()->ClientAddr(i), aBuf, sizeof(aBuf)))
+			Server()->m_NetServer.Drop(i, aBuf);
+	}
+}
+
 int CServerBan::BanAddr(const NETADDR *pAddr, int Seconds, const char *pReason, bool VerbatimReason)
 {
 	return BanExt(&m_BanAddrPool, pAddr, Seconds, pReason, VerbatimReason);
@@ -260,6 +281,7 @@ CServer::CServer()
 	{
 		m_apCurrentMapData[i] = nullptr;
 		m_aCurrentMapSize[i] = 0;
+		m_aCurrentMapDataShared[i] = false;
 	}
 
 	m_MapReload = false;
@@ -287,9 +309,9 @@ CServer::CServer()
 
 CServer::~CServer()
 {
-	for(auto &pCurrentMapData : m_apCurrentMapData)
+	for(int i = 0; i < NUM_MAP_TYPES; i++)
 	{
-		free(pCurrentMapData);
+		FreeCurrentMapData(i);
 	}
 
 	if(m_RunServer != UNINITIALIZED)
@@ -1036,6 +1058,15 @@ void CServer::DoSnapshot()
 			m_aDemoRecorder[RECORDER_AUTO].RecordSnapshot(Tick(), Data.AsSnapshot(), SnapshotSize);
 	}
 
+	if(m_SnapshotWorkers.NumThreads() != Config()->m_SvSnapshotThreads)
+	{
+		m_SnapshotWorkers.Init(Config()->m_SvSnapshotThreads);
+	}
+	const bool Parallel = m_SnapshotWorkers.NumThreads() > 0;
+
+	int aSnapClients[MAX_CLIENTS];
+	int NumSnapClients = 0;
+
 	// create snapshots for all clients
 	for(int i = 0; i < MaxClients(); i++)
 	{
@@ -1071,8 +1102,6 @@ void CServer::DoSnapshot()
 				m_aDemoRecorder[i].RecordSnapshot(Tick(), Data.AsSnapshot(), SnapshotSize);
 			}
 
-			int Crc = Data.AsSnapshot()->Crc();
-
 			// Remove old snapshots. Only the last acked snapshot
 			// is still needed as delta base, keep at most 3
 			// seconds worth for clients that aren't acking.
@@ -1084,91 +1113,184 @@ void CServer::DoSnapshot()
 
 			// save the snapshot
 			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, Data.AsSnapshot(), 0, nullptr);
+		}
 
-			// find snapshot that we can perform delta against
-			int DeltaTick = -1;
-			const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
-			{
-				int DeltashotSize;
-				if(m_aClients[i].m_LastAckedSnapshot >= MIN_TICK)
-				{
-					DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
-				}
-				else
-				{
-					DeltashotSize = -1;
-				}
-				if(DeltashotSize >= 0)
-				{
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				}
-				else
-				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
-				}
-			}
+		// the game world is not thread-safe, so `OnSnap` always runs on
+		// this thread, only the client's delta can be created in parallel
+		if(Parallel)
+		{
+			aSnapClients[NumSnapClients++] = i;
+		}
+		else
+		{
+			CreateSnapshotDelta(i);
+			SendSnapshotDelta(i);
+		}
+	}
 
-			// create delta
-			CSnapshotDelta *const pSnapshotDelta = IsSixup(i) ? &m_SnapshotDeltaSixup : &m_SnapshotDelta;
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = pSnapshotDelta->CreateDelta(pDeltashot, Data.AsSnapshot(), aDeltaData);
+	if(NumSnapClients > 0)
+	{
+		m_SnapshotWorkers.Run(NumSnapClients, [&](int Index) {
+			CreateSnapshotDelta(aSnapClients[Index]);
+		});
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		// send in client order, independent of the thread scheduling
+		for(int Index = 0; Index < NumSnapClients; Index++)
+		{
+			SendSnapshotDelta(aSnapClients[Index]);
+		}
+	}
 
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+	if(IsGlobalSnap)
+	{
+		GameServer()->OnPostGlobalSnap();
+	}
+}
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+// Only accesses the state of the given client, so it may run on a snapshot
+// worker thread concurrently for different clients.
+void CServer::CreateSnapshotDelta(int ClientId)
+{
+	CClient &Client = m_aClients[ClientId];
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
+	const CSnapshot *pData;
+	Client.m_Snapshots.Get(m_CurrentGameTick, nullptr, &pData, nullptr);
+	Client.m_SnapshotCrc = pData->Crc();
+
+	// find snapshot that we can perform delta against
+	Client.m_SnapshotDeltaTick = -1;
+	const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
+	{
+		int DeltashotSize;
+		if(Client.m_LastAckedSnapshot >= MIN_TICK)
+		{
+			DeltashotSize = Client.m_Snapshots.Get(Client.m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
+		}
+		else
+		{
+			DeltashotSize = -1;
+		}
+		if(DeltashotSize >= 0)
+		{
+			Client.m_SnapshotDeltaTick = Client.m_LastAckedSnapshot;
+		}
+		else
+		{
+			// no acked package found, force client to recover rate
+			if(Client.m_SnapRate == CClient::SNAPRATE_FULL)
+				Client.m_SnapRate = CClient::SNAPRATE_RECOVER;
+		}
+	}
+
+	// create delta
+	CSnapshotDelta *const pSnapshotDelta = Client.m_Sixup ? &m_SnapshotDeltaSixup : &m_SnapshotDelta;
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	int DeltaSize = pSnapshotDelta->CreateDelta(pDeltashot, pData, aDeltaData);
+
+	Client.m_vSnapshotDeltaData.clear();
+	if(DeltaSize)
+	{
+		// compress it
+		char aCompData[CSnapshot::MAX_SIZE];
+		const int CompSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+		Client.m_vSnapshotDeltaData.insert(Client.m_vSnapshotDeltaData.end(), aCompData, aCompData + CompSize);
+	}
+}
+
+void CServer::SendSnapshotDelta(int ClientId)
+{
+	CClient &Client = m_aClients[ClientId];
+	const int DeltaTick = Client.m_SnapshotDeltaTick;
+	const int Crc = Client.m_SnapshotCrc;
+
+	if(!Client.m_vSnapshotDeltaData.empty())
+	{
+		const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		const char *pCompData = Client.m_vSnapshotDeltaData.data();
+		const int SnapshotSize = Client.m_vSnapshotDeltaData.size();
+		int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+		for(int n = 0, Left = SnapshotSize; Left > 0; n++)
+		{
+			int Chunk = Left < MaxSize ? Left : MaxSize;
+			Left -= Chunk;
+
+			if(NumPackets == 1)
+			{
+				CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - DeltaTick);
+				Msg.AddInt(Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
 			}
 			else
 			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+				CMsgPacker Msg(NETMSG_SNAP, true);
 				Msg.AddInt(m_CurrentGameTick);
 				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				Msg.AddInt(NumPackets);
+				Msg.AddInt(n);
+				Msg.AddInt(Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
 			}
 		}
 	}
+	else
+	{
+		CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+		Msg.AddInt(m_CurrentGameTick);
+		Msg.AddInt(m_CurrentGameTick - DeltaTick);
+		SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+	}
 
-	if(IsGlobalSnap)
+	m_TickProfiler.AddSnapshot(ClientId, Client.m_vSnapshotDeltaData.size());
+
+	// debug dummies don't send input, acknowledge the snapshot for them so
+	// they exercise the same delta path as real clients
+	if(Client.m_DebugDummy)
 	{
-		GameServer()->OnPostGlobalSnap();
+		Client.m_LastAckedSnapshot = m_CurrentGameTick;
+		Client.m_SnapRate = CClient::SNAPRATE_FULL;
+	}
+}
+
+void CServer::UpdateSnapshotBenchmark(int64_t SnapshotTime, uint64_t Packets, uint64_t Syscalls)
+{
+	if(m_SnapshotBenchmarkTicksLeft <= 0)
+		return;
+
+	m_SnapshotBenchmarkTotalTime += SnapshotTime;
+	m_SnapshotBenchmarkMaxTime = std::max(m_SnapshotBenchmarkMaxTime, SnapshotTime);
+	m_SnapshotBenchmarkPackets += Packets;
+	m_SnapshotBenchmarkSyscalls += Syscalls;
+	m_SnapshotBenchmarkTicksLeft--;
+	if(m_SnapshotBenchmarkTicksLeft == 0)
+	{
+		log_info("server", "snapshot benchmark: ticks=%d clients=%d threads=%d avg=%.3fms max=%.3fms",
+			m_SnapshotBenchmarkTicks, ClientCount(), m_SnapshotWorkers.NumThreads(),
+			m_SnapshotBenchmarkTotalTime * 1000.0 / time_freq() / m_SnapshotBenchmarkTicks,
+			m_SnapshotBenchmarkMaxTime * 1000.0 / time_freq());
+		log_info("server", "snapshot benchmark: packets=%.1f/tick send_syscalls=%.1f/tick saved_syscalls=%.1f/tick",
+			(double)m_SnapshotBenchmarkPackets / m_SnapshotBenchmarkTicks,
+			(double)m_SnapshotBenchmarkSyscalls / m_SnapshotBenchmarkTicks,
+			((double)m_SnapshotBenchmarkPackets - m_SnapshotBenchmarkSyscalls) / m_SnapshotBenchmarkTicks);
+		log_info("server", "snapshot benchmark: storage_allocations=%.3f/tick",
+			(double)(SnapshotStorageAllocations() - m_SnapshotBenchmarkAllocations) / m_SnapshotBenchmarkTicks);
 	}
 }
 
+int64_t CServer::SnapshotStorageAllocations() const
+{
+	int64_t Allocations = 0;
+	for(const auto &Client : m_aClients)
+		Allocations += Client.m_Snapshots.NumAllocations();
+	return Allocations;
+}
+
 int CServer::ClientRejoinCallback(int ClientId, void *pUser)
 {
 	CServer *pThis = (CServer *)pUser;
@@ -1213,6 +1335,7 @@ int CServer::NewClientNoAuthCallback(int ClientId, void *pUser)
 	pThis->m_aClients[ClientId].m_GotDDNetVersionPacket = false;
 	pThis->m_aClients[ClientId].m_DDNetVersionSettled = false;
 	pThis->m_aClients[ClientId].Reset();
+	pThis->m_TickProfiler.ResetClient(ClientId);
 
 	pThis->GameServer()->TeehistorianRecordPlayerJoin(ClientId, false);
 	pThis->Antibot()->OnEngineClientJoin(ClientId);
@@ -1248,6 +1371,7 @@ int CServer::NewClientCallback(int ClientId, void *pUser, bool Sixup)
 	pThis->m_aClients[ClientId].m_DDNetVersionSettled = false;
 	pThis->m_aClients[ClientId].Reset();
 	pThis->m_aClients[ClientId].m_Sixup = Sixup;
+	pThis->m_TickProfiler.ResetClient(ClientId);
 
 	pThis->GameServer()->TeehistorianRecordPlayerJoin(ClientId, Sixup);
 	pThis->Antibot()->OnEngineClientJoin(ClientId);
@@ -1357,7 +1481,7 @@ void CServer::SendCapabilities(int ClientId)
 {
 	CMsgPacker Msg(NETMSG_CAPABILITIES, true);
 	Msg.AddInt(SERVERCAP_CURVERSION); // version
-	Msg.AddInt(SERVERCAPFLAG_DDNET | SERVERCAPFLAG_CHATTIMEOUTCODE | SERVERCAPFLAG_ANYPLAYERFLAG | SERVERCAPFLAG_PINGEX | SERVERCAPFLAG_ALLOWDUMMY | SERVERCAPFLAG_SYNCWEAPONINPUT); // flags
+	Msg.AddInt(SERVERCAPFLAG_DDNET | SERVERCAPFLAG_CHATTIMEOUTCODE | SERVERCAPFLAG_ANYPLAYERFLAG | SERVERCAPFLAG_PINGEX | SERVERCAPFLAG_ALLOWDUMMY | SERVERCAPFLAG_SYNCWEAPONINPUT | SERVERCAPFLAG_MAPDOWNLOADWINDOW); // flags
 	SendMsg(&Msg, MSGFLAG_VITAL, ClientId);
 }
 
@@ -1800,6 +1924,23 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			{
 				return;
 			}
+			// clients that know about SERVERCAPFLAG_MAPDOWNLOADWINDOW ask for
+			// several chunks at once and keep the window filled themselves
+			int NumChunks = Unpacker.GetInt();
+			if(!Unpacker.Error())
+			{
+				// a map never has more chunks than bytes
+				if(Chunk < 0 || Chunk > (int)m_aCurrentMapSize[MAP_TYPE_SIX])
+				{
+					return;
+				}
+				NumChunks = std::clamp(NumChunks, 1, (int)MAX_MAP_DOWNLOAD_WINDOW);
+				for(int i = 0; i < NumChunks; i++)
+				{
+					SendMapData(ClientId, Chunk + i);
+				}
+				return;
+			}
 			if(Chunk != m_aClients[ClientId].m_NextMapChunk || !Config()->m_SvFastDownload)
 			{
 				SendMapData(ClientId, Chunk);
@@ -2927,6 +3068,9 @@ void CServer::PumpNetwork()
 	// packets (preinput broadcasts, timing/ping replies, ...) into one packet
 	// per recipient, flushed once all packets have been handled below.
 	m_NetServer.BeginFlushBatch();
+	const bool SendBatch = Config()->m_SvSendBatch;
+	if(SendBatch)
+		m_NetServer.BeginSendBatch();
 
 	// Receive unconditionally, `net_udp_recv()` can hold packets that
 	// `net_socket_read_wait()` does not see.
@@ -3034,6 +3178,8 @@ void CServer::PumpNetwork()
 	}
 
 	m_NetServer.EndFlushBatch();
+	if(SendBatch)
+		m_NetServer.EndSendBatch();
 
 	m_ServerBan.Update();
 	m_Econ.Update();
@@ -3050,6 +3196,61 @@ void CServer::ReloadMap()
 	m_SameMapReload = true;
 }
 
+void CServer::PreloadMap(const char *pMap)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "maps/%s.map", pMap);
+	if(!str_valid_filename(fs_filename(aPath)))
+	{
+		log_error("server", "The name '%s' cannot be used for maps because not all platforms support it", aPath);
+		return;
+	}
+	if(m_pMapPreload && str_comp(m_pMapPreload->Path(), aPath) == 0 && m_pMapPreload->Sixup() == (Config()->m_SvSixup != 0) &&
+		m_pMapPreload->SharedData() == (Config()->m_SvSharedMapData != 0))
+	{
+		return;
+	}
+
+	// a running preload keeps its own reference until it finishes
+	m_pMapPreload = std::make_shared<CMapPreloadJob>(Storage(), GameServer(), pMap, aPath, Config()->m_SvSixup != 0, Config()->m_SvSharedMapData != 0, Config()->m_SvMapCacheMaxAge);
+	Engine()->AddJob(m_pMapPreload);
+	log_info("server", "preloading map '%s'", pMap);
+}
+
+bool CServer::MapPreloadRunning(const char *pMapName) const
+{
+	return m_pMapPreload && !m_pMapPreload->Done() && str_comp(m_pMapPreload->MapName(), pMapName) == 0;
+}
+
+std::shared_ptr<CMapPreloadJob> CServer::TakeMapPreload(const char *pMapName, const char *pPath)
+{
+	std::shared_ptr<CMapPreloadJob> pPreload = std::move(m_pMapPreload);
+	if(!pPreload)
+	{
+		return nullptr;
+	}
+	if(pPreload->State() != IJob::STATE_DONE || str_comp(pPreload->MapName(), pMapName) != 0 ||
+		str_comp(pPreload->Path(), pPath) != 0 || pPreload->Sixup() != (Config()->m_SvSixup != 0) ||
+		pPreload->SharedData() != (Config()->m_SvSharedMapData != 0))
+	{
+		log_info("server", "discarding preloaded map '%s'", pPreload->MapName());
+		return nullptr;
+	}
+	if(!pPreload->Map())
+	{
+		return nullptr;
+	}
+	log_info("server", "using preloaded map '%s', loading took %.2fms in the background", pMapName, pPreload->Duration() * 1000.0 / time_freq());
+	return pPreload;
+}
+
+void CServer::FreeCurrentMapData(int MapType)
+{
+	CMapPreloadJob::FreeData(m_apCurrentMapData[MapType], m_aCurrentMapSize[MapType], m_aCurrentMapDataShared[MapType]);
+	m_apCurrentMapData[MapType] = nullptr;
+	m_aCurrentMapDataShared[MapType] = false;
+}
+
 int CServer::LoadMap(const char *pMapName)
 {
 	m_MapReload = false;
@@ -3066,10 +3267,20 @@ int CServer::LoadMap(const char *pMapName)
 	{
 		return 0;
 	}
-	if(!GameServer()->Map()->Load(pMapName, Storage(), aBuf, IStorage::TYPE_ALL))
+
+	std::shared_ptr<CMapPreloadJob> pLoad = TakeMapPreload(pMapName, aBuf);
+	if(!pLoad)
 	{
-		return 0;
+		pLoad = std::make_shared<CMapPreloadJob>(Storage(), nullptr, pMapName, aBuf, Config()->m_SvSixup != 0, Config()->m_SvSharedMapData != 0, Config()->m_SvMapCacheMaxAge);
+		pLoad->Load();
+		if(!pLoad->Map())
+		{
+			return 0;
+		}
 	}
+	GameServer()->SwapMap(pLoad->Map());
+	// the game still refers to the previous map until it is reinitialized
+	m_pPreviousMap = std::move(pLoad->Map());
 
 	// reinit snapshot ids
 	m_IdPool.TimeoutIds();
@@ -3083,13 +3294,9 @@ int CServer::LoadMap(const char *pMapName)
 	str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
-	// load complete map into memory for download
-	{
-		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
-		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
-	}
+	// complete map in memory for download
+	FreeCurrentMapData(MAP_TYPE_SIX);
+	m_apCurrentMapData[MAP_TYPE_SIX] = pLoad->TakeData(&m_aCurrentMapSize[MAP_TYPE_SIX], &m_aCurrentMapDataShared[MAP_TYPE_SIX]);
 
 	if(Config()->m_SvMapsBaseUrl[0])
 	{
@@ -3103,12 +3310,14 @@ int CServer::LoadMap(const char *pMapName)
 		m_aMapDownloadUrl[0] = '\0';
 	}
 
-	// load sixup version of the map
+	// sixup version of the map
 	if(Config()->m_SvSixup)
 	{
 		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pMapName);
-		void *pData;
-		if(!Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIXUP]))
+		unsigned SixupSize;
+		bool SixupShared;
+		unsigned char *pSixupData = pLoad->TakeSixupData(&SixupSize, &SixupShared);
+		if(!pSixupData)
 		{
 			Config()->m_SvSixup = 0;
 			if(m_pRegister)
@@ -3120,11 +3329,13 @@ int CServer::LoadMap(const char *pMapName)
 		}
 		else
 		{
-			free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
-			m_apCurrentMapData[MAP_TYPE_SIXUP] = (unsigned char *)pData;
+			FreeCurrentMapData(MAP_TYPE_SIXUP);
+			m_apCurrentMapData[MAP_TYPE_SIXUP] = pSixupData;
+			m_aCurrentMapSize[MAP_TYPE_SIXUP] = SixupSize;
+			m_aCurrentMapDataShared[MAP_TYPE_SIXUP] = SixupShared;
 
-			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = sha256(m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
-			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = crc32(0, m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = pLoad->SixupSha256();
+			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = pLoad->SixupCrc();
 			sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIXUP], aSha256, sizeof(aSha256));
 			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "sixup", aBufMsg);
@@ -3132,8 +3343,7 @@ int CServer::LoadMap(const char *pMapName)
 	}
 	if(!Config()->m_SvSixup)
 	{
-		free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
-		m_apCurrentMapData[MAP_TYPE_SIXUP] = nullptr;
+		FreeCurrentMapData(MAP_TYPE_SIXUP);
 	}
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -3142,10 +3352,31 @@ int CServer::LoadMap(const char *pMapName)
 	return 1;
 }
 
+void CServer::UpdateDebugDummyInput(int ClientId)
+{
+	CClient &Client = m_aClients[ClientId];
+	CNetObj_PlayerInput Input = {0};
+	Input.m_Direction = (ClientId & 1) ? -1 : 1;
+	// the fire counter is masked, this presses fire every other tick
+	if(g_Config.m_DbgDummiesFire)
+		Input.m_Fire = Tick();
+	Client.m_aInputs[0].m_GameTick = Tick() + 1;
+	mem_copy(Client.m_aInputs[0].m_aData, &Input, std::min(sizeof(Input), sizeof(Client.m_aInputs[0].m_aData)));
+	Client.m_LatestInput = Client.m_aInputs[0];
+	Client.m_CurrentInput = 0;
+}
+
 void CServer::UpdateDebugDummies(bool ForceDisconnect)
 {
 	if(m_PreviousDebugDummies == g_Config.m_DbgDummies && !ForceDisconnect)
+	{
+		if(g_Config.m_DbgDummiesFire)
+		{
+			for(int DummyIndex = 0; DummyIndex < m_PreviousDebugDummies; ++DummyIndex)
+				UpdateDebugDummyInput(MaxClients() - DummyIndex - 1);
+		}
 		return;
+	}
 
 	g_Config.m_DbgDummies = std::clamp(g_Config.m_DbgDummies, 0, MaxClients());
 	for(int DummyIndex = 0; DummyIndex < std::max(m_PreviousDebugDummies, g_Config.m_DbgDummies); ++DummyIndex)
@@ -3155,7 +3386,8 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 		CClient &Client = m_aClients[ClientId];
 		if(AddDummy && m_aClients[ClientId].m_State == CClient::STATE_EMPTY)
 		{
-			NewClientCallback(ClientId, this, false);
+			const bool Sixup = DummyIndex < g_Config.m_DbgDummiesSixup;
+			NewClientCallback(ClientId, this, Sixup);
 			Client.m_DebugDummy = true;
 
 			// See https://en.wikipedia.org/wiki/Unique_local_address
@@ -3179,8 +3411,12 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 
 			GameServer()->OnClientConnected(ClientId, nullptr);
 			Client.m_State = CClient::STATE_INGAME;
-			Client.m_DDNetVersion = DDNET_VERSION_NUMBER;
-			Client.m_GotDDNetVersionPacket = true;
+			// 0.7 clients don't send a DDNet version
+			if(!Sixup)
+			{
+				Client.m_DDNetVersion = DDNET_VERSION_NUMBER;
+				Client.m_GotDDNetVersionPacket = true;
+			}
 			Client.m_DDNetVersionSettled = true;
 			char aDummyName[MAX_NAME_LENGTH];
 			str_format(aDummyName, sizeof(aDummyName), "Debug dummy %d", DummyIndex + 1);
@@ -3194,12 +3430,7 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 
 		if(AddDummy && Client.m_DebugDummy)
 		{
-			CNetObj_PlayerInput Input = {0};
-			Input.m_Direction = (ClientId & 1) ? -1 : 1;
-			Client.m_aInputs[0].m_GameTick = Tick() + 1;
-			mem_copy(Client.m_aInputs[0].m_aData, &Input, std::min(sizeof(Input), sizeof(Client.m_aInputs[0].m_aData)));
-			Client.m_LatestInput = Client.m_aInputs[0];
-			Client.m_CurrentInput = 0;
+			UpdateDebugDummyInput(ClientId);
 		}
 	}
 
@@ -3307,6 +3538,7 @@ int CServer::Run()
 
 	Antibot()->Init();
 	GameServer()->OnInit(nullptr);
+	m_pPreviousMap = nullptr;
 	if(ErrorShutdown())
 	{
 		m_RunServer = STOPPING;
@@ -3341,21 +3573,28 @@ int CServer::Run()
 		UpdateServerInfo(false);
 		while(m_RunServer < STOPPING)
 		{
+			m_TickProfiler.BeginLoop();
 			if(NonActive)
+			{
 				PumpNetwork();
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_NETWORK);
+			}
 
 			set_new_tick();
 
 			int64_t LastTime = time_get();
 			int NewTicks = 0;
 
-			// load new map
-			if(m_MapReload || m_SameMapReload || m_CurrentGameTick >= MAX_TICK) // force reload to make sure the ticks stay within a valid range
+			// load new map, unless it is still being preloaded in the background
+			const bool WaitForMapPreload = m_MapReload && MapPreloadRunning(Config()->m_SvMap);
+			if((m_MapReload && !WaitForMapPreload) || m_SameMapReload || m_CurrentGameTick >= MAX_TICK) // force reload to make sure the ticks stay within a valid range
 			{
 				const bool SameMapReload = m_SameMapReload;
+				const int64_t MapChangeStart = time_get_impl();
 				// load map
 				if(LoadMap(Config()->m_SvMap))
 				{
+					const int64_t MapLoadTime = time_get_impl() - MapChangeStart;
 					// new map loaded
 
 					// ask the game for the data it wants to persist past a map change
@@ -3391,6 +3630,7 @@ int CServer::Run()
 					Console()->StoreCommands(true);
 					GameServer()->OnInit(m_pPersistentData);
 					Console()->StoreCommands(false);
+					m_pPreviousMap = nullptr;
 
 					for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
 					{
@@ -3416,6 +3656,10 @@ int CServer::Run()
 						break;
 					}
 					ExpireServerInfo();
+
+					const int64_t MapChangeTime = time_get_impl() - MapChangeStart;
+					log_info("server", "map change stalled the server for %.2fms (map load %.2fms, game init %.2fms)",
+						MapChangeTime * 1000.0 / time_freq(), MapLoadTime * 1000.0 / time_freq(), (MapChangeTime - MapLoadTime) * 1000.0 / time_freq());
 				}
 				else
 				{
@@ -3423,6 +3667,7 @@ int CServer::Run()
 					Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 					str_copy(Config()->m_SvMap, GameServer()->Map()->FullName());
 				}
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_OTHER);
 			}
 
 			while(LastTime > TickStartTime(m_CurrentGameTick + 1))
@@ -3480,11 +3725,26 @@ int CServer::Run()
 			// snap game
 			if(NewTicks)
 			{
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_GAME_TICK);
+
+				NETSTATS NetStatsStart;
+				net_stats(&NetStatsStart);
+				const int64_t SnapshotStart = time_get_impl();
+				const bool SendBatch = Config()->m_SvSendBatch;
+				if(SendBatch)
+					m_NetServer.BeginSendBatch();
 				DoSnapshot();
+				if(SendBatch)
+					m_NetServer.EndSendBatch();
+				NETSTATS NetStatsEnd;
+				net_stats(&NetStatsEnd);
+				UpdateSnapshotBenchmark(time_get_impl() - SnapshotStart, NetStatsEnd.sent_packets - NetStatsStart.sent_packets, NetStatsEnd.sent_syscalls - NetStatsStart.sent_syscalls);
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_SNAPSHOT);
 
 				const int CommandSendingClientId = Tick() % MAX_CLIENTS;
 				UpdateClientRconCommands(CommandSendingClientId);
 				UpdateClientMaplistEntries(CommandSendingClientId);
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_RCON_COMMANDS);
 
 				m_Fifo.Update();
 
@@ -3496,15 +3756,20 @@ int CServer::Run()
 				}
 #endif
 
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_OTHER);
+
 				// master server stuff
 				m_pRegister->Update();
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_REGISTER);
 
 				if(m_ServerInfoNeedsUpdate)
 				{
 					UpdateServerInfo(m_ServerInfoNeedsResend);
 				}
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_OTHER);
 
 				Antibot()->OnEngineTick();
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_ANTIBOT);
 
 				// handle dnsbl
 				if(Config()->m_SvDnsbl)
@@ -3556,10 +3821,14 @@ int CServer::Run()
 						}
 					}
 				}
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_OTHER);
 			}
 
 			if(!NonActive)
+			{
 				PumpNetwork();
+				m_TickProfiler.EndPhase(CTickProfiler::PHASE_NETWORK);
+			}
 
 			NonActive = true;
 			for(const auto &Client : m_aClients)
@@ -3588,6 +3857,7 @@ int CServer::Run()
 			{
 				m_ReloadedWhenEmpty = false;
 			}
+			m_TickProfiler.EndPhase(CTickProfiler::PHASE_OTHER);
 
 			// wait for incoming data
 			if(NonActive && Config()->m_SvShutdownWhenEmpty)
@@ -3608,6 +3878,10 @@ int CServer::Run()
 				if(MicrosecondsToWait > 0us)
 					net_socket_read_wait(m_NetServer.Socket(), MicrosecondsToWait);
 			}
+			m_TickProfiler.EndPhase(CTickProfiler::PHASE_WAIT);
+			m_TickProfiler.EndLoop(NewTicks, TickSpeed());
+			m_TickProfiler.UpdateFile(Storage(), Config()->m_SvTickProfileFile, Config()->m_SvTickProfileInterval, Tick());
+
 			if(IsInterrupted())
 			{
 				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "interrupted");
@@ -3997,6 +4271,7 @@ void CServer::DemoRecorder_HandleAutoStart()
 		str_timestamp(aTimestamp, sizeof(aTimestamp));
 		char aFilename[IO_MAX_PATH_LENGTH];
 		str_format(aFilename, sizeof(aFilename), "demos/auto/server/%s_%s.demo", GameServer()->Map()->BaseName(), aTimestamp);
+		m_aDemoRecorder[RECORDER_AUTO].SetAsyncBufferSize(Config()->m_SvDemoAsyncBuffer * 1024);
 		m_aDemoRecorder[RECORDER_AUTO].Start(
 			Storage(),
 			m_pConsole,
@@ -4099,6 +4374,7 @@ void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 		str_timestamp(aTimestamp, sizeof(aTimestamp));
 		str_format(aFilename, sizeof(aFilename), "demos/demo_%s.demo", aTimestamp);
 	}
+	pServer->m_aDemoRecorder[RECORDER_MANUAL].SetAsyncBufferSize(pServer->Config()->m_SvDemoAsyncBuffer * 1024);
 	pServer->m_aDemoRecorder[RECORDER_MANUAL].Start(
 		pServer->Storage(),
 		pServer->Console(),
@@ -4125,6 +4401,11 @@ void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->ReloadMap();
 }
 
+void CServer::ConPreloadMap(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->PreloadMap(pResult->GetString(0));
+}
+
 void CServer::ConLogout(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pServer = (CServer *)pUser;
@@ -4196,6 +4477,32 @@ void CServer::ConForceHighBandwidthOnSpectate(IConsole::IResult *pResult, void *
 	}
 }
 
+void CServer::ConDbgSnapshotBenchmark(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	pThis->m_SnapshotBenchmarkTicks = pResult->NumArguments() ? std::max(pResult->GetInteger(0), 1) : pThis->TickSpeed() * 10;
+	pThis->m_SnapshotBenchmarkTicksLeft = pThis->m_SnapshotBenchmarkTicks;
+	pThis->m_SnapshotBenchmarkTotalTime = 0;
+	pThis->m_SnapshotBenchmarkMaxTime = 0;
+	pThis->m_SnapshotBenchmarkPackets = 0;
+	pThis->m_SnapshotBenchmarkSyscalls = 0;
+	pThis->m_SnapshotBenchmarkAllocations = pThis->SnapshotStorageAllocations();
+	log_info("server", "measuring snapshot time over the next %d ticks", pThis->m_SnapshotBenchmarkTicks);
+}
+
+void CServer::ConTickProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	pThis->m_TickProfiler.Print(pThis->Tick());
+}
+
+void CServer::ConTickProfileReset(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	pThis->m_TickProfiler.Reset();
+	log_info("server", "tick profile reset");
+}
+
 void CServer::ConAddSqlServer(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pSelf = (CServer *)pUserData;
@@ -4271,6 +4578,12 @@ void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CServer::ConSqlStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	pSelf->DbPool()->PrintStats();
+}
+
 void CServer::ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pThis = static_cast<CServer *>(pUserData);
@@ -4562,14 +4875,19 @@ void CServer::RegisterCommands()
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
 	Console()->Register("hide_auth_status", "?i[hide]", CFGFLAG_SERVER, ConHideAuthStatus, this, "Opt out of spectator count and hide auth status to non-authed players (1 = hidden, 0 = shown)");
 	Console()->Register("force_high_bandwidth_on_spectate", "?i[enable]", CFGFLAG_SERVER, ConForceHighBandwidthOnSpectate, this, "Force high bandwidth mode when spectating (1 = on, 0 = off)");
+	Console()->Register("dbg_snapshot_benchmark", "?i[ticks]", CFGFLAG_SERVER, ConDbgSnapshotBenchmark, this, "Measure the time spent creating snapshots over the next ticks, use with dbg_dummies");
+	Console()->Register("tick_profile", "", CFGFLAG_SERVER, ConTickProfile, this, "Show the time spent in each phase of the server loop, tick overruns and snapshot sizes per client");
+	Console()->Register("tick_profile_reset", "", CFGFLAG_SERVER, ConTickProfileReset, this, "Reset the stats shown by tick_profile");
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
+	Console()->Register("preload_map", "r[map]", CFGFLAG_SERVER, ConPreloadMap, this, "Load a map in the background so changing to it does not stall the server");
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?] ?i[SSL ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
+	Console()->Register("sql_stats", "", CFGFLAG_SERVER, ConSqlStats, this, "Shows queue depth, throughput and latency of the database workers");
 
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
@@ -4628,9 +4946,43 @@ void CServer::SnapFreeId(int Id)
 
 bool CServer::SnapNewItem(int Type, int Id, const void *pData, int Size)
 {
+	if(m_pvSnapRecording)
+	{
+		// type, id and size, followed by the item data
+		m_pvSnapRecording->push_back(Type);
+		m_pvSnapRecording->push_back(Id);
+		m_pvSnapRecording->push_back(Size);
+		const int *pItemData = static_cast<const int *>(pData);
+		m_pvSnapRecording->insert(m_pvSnapRecording->end(), pItemData, pItemData + Size / sizeof(int32_t));
+	}
 	return m_SnapshotBuilder.NewItem(Type, Id, pData, Size);
 }
 
+void CServer::SnapStartRecording(std::vector<int> *pvRecording)
+{
+	dbg_assert(m_pvSnapRecording == nullptr, "snap recording already started");
+	pvRecording->clear();
+	m_pvSnapRecording = pvRecording;
+}
+
+void CServer::SnapStopRecording()
+{
+	m_pvSnapRecording = nullptr;
+}
+
+void CServer::SnapReplay(const std::vector<int> &vRecording)
+{
+	for(size_t i = 0; i + 3 <= vRecording.size();)
+	{
+		const int Type = vRecording[i];
+		const int Id = vRecording[i + 1];
+		const int Size = vRecording[i + 2];
+		i += 3;
+		SnapNewItem(Type, Id, vRecording.data() + i, Size);
+		i += Size / sizeof(int32_t);
+	}
+}
+
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
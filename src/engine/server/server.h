@@ -5,8 +5,11 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "map_preload.h"
 #include "name_ban.h"
 #include "snap_id_pool.h"
+#include "snapshot_workers.h"
+#include "tick_profiler.h"
 
 #include <base/hash.h>
 
@@ -44,6 +47,7 @@ class CServerBan : public CNetBan
 
 	template<class T>
 	int BanExt(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool VerbatimReason);
+	void OnBansLoaded() override;
 
 public:
 	class CServer *Server() const { return m_pServer; }
@@ -85,6 +89,7 @@ class CServer : public IServer
 
 	int m_PreviousDebugDummies = 0;
 	void UpdateDebugDummies(bool ForceDisconnect);
+	void UpdateDebugDummyInput(int ClientId);
 
 public:
 	class IGameServer *GameServer() { return m_pGameServer; }
@@ -151,6 +156,11 @@ public:
 		int m_LastInputTick;
 		CSnapshotStorage m_Snapshots;
 
+		// delta of the current snapshot, see `CServer::CreateSnapshotDelta`
+		int m_SnapshotCrc;
+		int m_SnapshotDeltaTick;
+		std::vector<char> m_vSnapshotDeltaData; // compressed, empty if nothing changed
+
 		CNetMsg_Sv_PreInput m_LastPreInput = {};
 		CInput m_LatestInput;
 		CInput m_aInputs[200]; // TODO: handle input better
@@ -225,6 +235,8 @@ public:
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotDelta m_SnapshotDeltaSixup;
 	CSnapshotBuilder m_SnapshotBuilder;
+	std::vector<int> *m_pvSnapRecording = nullptr;
+	CSnapshotWorkerPool m_SnapshotWorkers;
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -269,7 +281,11 @@ public:
 	unsigned m_aCurrentMapCrc[NUM_MAP_TYPES];
 	unsigned char *m_apCurrentMapData[NUM_MAP_TYPES];
 	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
+	// memory-mapped from the map file with sv_shared_map_data
+	bool m_aCurrentMapDataShared[NUM_MAP_TYPES];
 	char m_aMapDownloadUrl[256];
+	std::shared_ptr<CMapPreloadJob> m_pMapPreload;
+	std::unique_ptr<IMap> m_pPreviousMap;
 
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 	CAuthManager m_AuthManager;
@@ -340,6 +356,22 @@ public:
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
 
 	void DoSnapshot();
+	void CreateSnapshotDelta(int ClientId);
+	void SendSnapshotDelta(int ClientId);
+
+	// ticks left to measure with `dbg_snapshot_benchmark`
+	int m_SnapshotBenchmarkTicksLeft = 0;
+	int m_SnapshotBenchmarkTicks = 0;
+	int64_t m_SnapshotBenchmarkTotalTime = 0;
+	int64_t m_SnapshotBenchmarkMaxTime = 0;
+	uint64_t m_SnapshotBenchmarkPackets = 0;
+	uint64_t m_SnapshotBenchmarkSyscalls = 0;
+	int64_t m_SnapshotBenchmarkAllocations = 0;
+	void UpdateSnapshotBenchmark(int64_t SnapshotTime, uint64_t Packets, uint64_t Syscalls);
+	int64_t SnapshotStorageAllocations() const;
+
+	// timing of the main loop phases, shown by `tick_profile`
+	CTickProfiler m_TickProfiler;
 
 	static int NewClientCallback(int ClientId, void *pUser, bool Sixup);
 	static int NewClientNoAuthCallback(int ClientId, void *pUser);
@@ -432,6 +464,10 @@ public:
 
 	void ChangeMap(const char *pMap) override;
 	void ReloadMap() override;
+	void PreloadMap(const char *pMap) override;
+	bool MapPreloadRunning(const char *pMapName) const;
+	std::shared_ptr<CMapPreloadJob> TakeMapPreload(const char *pMapName, const char *pPath);
+	void FreeCurrentMapData(int MapType);
 	int LoadMap(const char *pMapName);
 
 	void SaveDemo(int ClientId, float Time) override;
@@ -448,10 +484,14 @@ public:
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
+	static void ConPreloadMap(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
 	static void ConHideAuthStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConForceHighBandwidthOnSpectate(IConsole::IResult *pResult, void *pUser);
+	static void ConDbgSnapshotBenchmark(IConsole::IResult *pResult, void *pUser);
+	static void ConTickProfile(IConsole::IResult *pResult, void *pUser);
+	static void ConTickProfileReset(IConsole::IResult *pResult, void *pUser);
 
 	static void ConAuthAdd(IConsole::IResult *pResult, void *pUser);
 	static void ConAuthAddHashed(IConsole::IResult *pResult, void *pUser);
@@ -463,6 +503,7 @@ public:
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
+	static void ConSqlStats(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData);
 	static void ConReloadMaplist(IConsole::IResult *pResult, void *pUserData);
@@ -497,6 +538,9 @@ public:
 	bool SnapNewItem(int Type, int Id, const void *pData, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
 	void SnapSetStaticsize7(int ItemType, int Size) override;
+	void SnapStartRecording(std::vector<int> *pvRecording) override;
+	void SnapStopRecording() override;
+	void SnapReplay(const std::vector<int> &vRecording) override;
 
 	// DDRace
 
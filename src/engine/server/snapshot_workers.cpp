@@ -0,0 +1,91 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+
+#include "snapshot_workers.h"
+
+#include <base/dbg.h>
+#include <base/str.h>
+#include <base/thread.h>
+
+#include <algorithm>
+
+CSnapshotWorkerPool::~CSnapshotWorkerPool()
+{
+	Shutdown();
+}
+
+void CSnapshotWorkerPool::Init(int NumThreads)
+{
+	Shutdown();
+
+	m_Shutdown = false;
+	m_vpThreads.reserve(NumThreads);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "snapshot %d", i);
+		void *pThread = thread_init(WorkerThread, this, aName);
+		dbg_assert(pThread != nullptr, "failed to create snapshot worker thread");
+		m_vpThreads.push_back(pThread);
+	}
+}
+
+void CSnapshotWorkerPool::Shutdown()
+{
+	if(m_vpThreads.empty())
+		return;
+
+	m_Shutdown = true;
+	for(size_t i = 0; i < m_vpThreads.size(); i++)
+		m_Start.Signal();
+	for(void *pThread : m_vpThreads)
+		thread_wait(pThread);
+	m_vpThreads.clear();
+}
+
+void CSnapshotWorkerPool::WorkerThread(void *pUser)
+{
+	static_cast<CSnapshotWorkerPool *>(pUser)->RunLoop();
+}
+
+void CSnapshotWorkerPool::RunLoop()
+{
+	while(true)
+	{
+		m_Start.Wait();
+		if(m_Shutdown)
+			break;
+		ProcessWork();
+		m_Done.Signal();
+	}
+}
+
+void CSnapshotWorkerPool::ProcessWork()
+{
+	while(true)
+	{
+		const int Index = m_NextWork.fetch_add(1);
+		if(Index >= m_NumWork)
+			break;
+		(*m_pfnWork)(Index);
+	}
+}
+
+void CSnapshotWorkerPool::Run(int NumWork, const std::function<void(int)> &Work)
+{
+	m_pfnWork = &Work;
+	m_NumWork = NumWork;
+	m_NextWork = 0;
+
+	// don't wake up more threads than there is work for, the calling thread
+	// processes work as well
+	const int NumWakeup = std::min<int>(m_vpThreads.size(), NumWork - 1);
+	for(int i = 0; i < NumWakeup; i++)
+		m_Start.Signal();
+	ProcessWork();
+	for(int i = 0; i < NumWakeup; i++)
+		m_Done.Wait();
+
+	m_pfnWork = nullptr;
+	m_NumWork = 0;
+}
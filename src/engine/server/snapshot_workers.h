@@ -0,0 +1,53 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+
+#ifndef ENGINE_SERVER_SNAPSHOT_WORKERS_H
+#define ENGINE_SERVER_SNAPSHOT_WORKERS_H
+
+#include <base/sphore.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/**
+ * Fork-join thread pool used to process the per-client part of a snapshot
+ * tick in parallel. Unlike `CJobPool`, `Run` blocks until all work items
+ * have been processed, so results can be consumed in a deterministic order
+ * by the caller afterwards.
+ */
+class CSnapshotWorkerPool
+{
+	std::vector<void *> m_vpThreads;
+	std::atomic<bool> m_Shutdown = false;
+
+	CSemaphore m_Start;
+	CSemaphore m_Done;
+
+	const std::function<void(int)> *m_pfnWork = nullptr;
+	int m_NumWork = 0;
+	std::atomic<int> m_NextWork = 0;
+
+	static void WorkerThread(void *pUser);
+	void RunLoop();
+	void ProcessWork();
+
+public:
+	~CSnapshotWorkerPool();
+
+	/**
+	 * (Re)starts the pool with the given number of worker threads. Zero
+	 * threads means that `Run` processes all work on the calling thread.
+	 */
+	void Init(int NumThreads);
+	void Shutdown();
+	int NumThreads() const { return m_vpThreads.size(); }
+
+	/**
+	 * Calls `Work(Index)` for every `Index` in `[0, NumWork)` on the worker
+	 * threads and the calling thread. Returns once all calls have finished.
+	 */
+	void Run(int NumWork, const std::function<void(int)> &Work);
+};
+
+#endif
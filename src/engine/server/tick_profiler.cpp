@@ -0,0 +1,260 @@
+#include "tick_profiler.h"
+
+#include <base/dbg.h>
+#include <base/io.h>
+#include <base/log.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+
+static int64_t TimeToMicroseconds(int64_t Time)
+{
+	return Time * 1000000 / time_freq();
+}
+
+int CDurationHistogram::Bucket(int64_t Microseconds)
+{
+	if(Microseconds < SUB_BUCKETS)
+		return std::max<int64_t>(Microseconds, 0);
+	const int Exponent = std::bit_width((uint64_t)Microseconds) - 1;
+	const int SubBucket = (Microseconds >> (Exponent - 2)) & (SUB_BUCKETS - 1);
+	return std::min((Exponent - 1) * SUB_BUCKETS + SubBucket, (int)NUM_BUCKETS - 1);
+}
+
+int64_t CDurationHistogram::BucketUpperBound(int Bucket)
+{
+	if(Bucket < SUB_BUCKETS)
+		return Bucket;
+	const int Exponent = Bucket / SUB_BUCKETS + 1;
+	const int64_t LowerBound = (int64_t)(SUB_BUCKETS + Bucket % SUB_BUCKETS) << (Exponent - 2);
+	return LowerBound + ((int64_t)1 << (Exponent - 2)) - 1;
+}
+
+void CDurationHistogram::Reset()
+{
+	std::fill(std::begin(m_aBuckets), std::end(m_aBuckets), 0);
+	m_Count = 0;
+	m_Total = 0;
+	m_Max = 0;
+}
+
+void CDurationHistogram::Add(int64_t Microseconds)
+{
+	m_aBuckets[Bucket(Microseconds)]++;
+	m_Count++;
+	m_Total += Microseconds;
+	m_Max = std::max(m_Max, Microseconds);
+}
+
+int64_t CDurationHistogram::Percentile(int Percent) const
+{
+	if(m_Count == 0)
+		return 0;
+	const int64_t Target = std::max<int64_t>((m_Count * Percent + 99) / 100, 1);
+	int64_t Count = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+	{
+		Count += m_aBuckets[i];
+		if(Count >= Target)
+			return i == NUM_BUCKETS - 1 ? m_Max : std::min(BucketUpperBound(i), m_Max);
+	}
+	return m_Max;
+}
+
+const char *CTickProfiler::PhaseName(int Phase)
+{
+	static const char *s_apNames[] = {
+		"network",
+		"game_tick",
+		"snapshot",
+		"rcon_commands",
+		"register",
+		"antibot",
+		"other",
+		"wait",
+	};
+	static_assert(std::size(s_apNames) == NUM_PHASES);
+	dbg_assert(Phase >= 0 && Phase < NUM_PHASES, "invalid phase %d", Phase);
+	return s_apNames[Phase];
+}
+
+void CTickProfiler::CStats::Reset()
+{
+	for(auto &Phase : m_aPhases)
+		Phase.Reset();
+	m_Work.Reset();
+	m_Ticks = 0;
+	m_Overruns = 0;
+	m_CatchUpTicks = 0;
+	for(auto &Client : m_aClients)
+		Client = {0, 0, 0};
+	m_StartTime = time_get_impl();
+}
+
+CTickProfiler::~CTickProfiler()
+{
+	if(m_File)
+		io_close(m_File);
+}
+
+void CTickProfiler::BeginLoop()
+{
+	m_PhaseStart = time_get_impl();
+	std::fill(std::begin(m_aLoopTimes), std::end(m_aLoopTimes), 0);
+	m_LoopPhases = 0;
+}
+
+void CTickProfiler::EndPhase(EPhase Phase)
+{
+	const int64_t Now = time_get_impl();
+	m_aLoopTimes[Phase] += Now - m_PhaseStart;
+	m_LoopPhases |= 1u << Phase;
+	m_PhaseStart = Now;
+}
+
+void CTickProfiler::EndLoop(int NewTicks, int TickSpeed)
+{
+	int64_t WorkTime = 0;
+	for(int Phase = 0; Phase < NUM_PHASES; Phase++)
+	{
+		if(!(m_LoopPhases & (1u << Phase)))
+			continue;
+		const int64_t Microseconds = TimeToMicroseconds(m_aLoopTimes[Phase]);
+		m_Total.m_aPhases[Phase].Add(Microseconds);
+		m_Interval.m_aPhases[Phase].Add(Microseconds);
+		if(Phase != PHASE_WAIT)
+			WorkTime += m_aLoopTimes[Phase];
+	}
+	if(NewTicks == 0)
+		return;
+
+	const int64_t WorkMicroseconds = TimeToMicroseconds(WorkTime);
+	const bool Overrun = WorkTime > time_freq() / TickSpeed;
+	for(CStats *pStats : {&m_Total, &m_Interval})
+	{
+		pStats->m_Work.Add(WorkMicroseconds);
+		pStats->m_Ticks += NewTicks;
+		pStats->m_CatchUpTicks += NewTicks - 1;
+		if(Overrun)
+			pStats->m_Overruns++;
+	}
+}
+
+void CTickProfiler::AddSnapshot(int ClientId, int Bytes)
+{
+	for(CStats *pStats : {&m_Total, &m_Interval})
+	{
+		CClientSnapshots &Client = pStats->m_aClients[ClientId];
+		Client.m_Snapshots++;
+		Client.m_Bytes += Bytes;
+		Client.m_MaxBytes = std::max(Client.m_MaxBytes, Bytes);
+	}
+}
+
+void CTickProfiler::ResetClient(int ClientId)
+{
+	m_Total.m_aClients[ClientId] = {0, 0, 0};
+	m_Interval.m_aClients[ClientId] = {0, 0, 0};
+}
+
+void CTickProfiler::Reset()
+{
+	m_Total.Reset();
+	m_Interval.Reset();
+}
+
+void CTickProfiler::Print(int Tick) const
+{
+	const double Seconds = (double)(time_get_impl() - m_Total.m_StartTime) / time_freq();
+	log_info("server", "tick profile: seconds=%.1f tick=%d ticks=%" PRId64 " overruns=%" PRId64 " catch_up_ticks=%" PRId64,
+		Seconds, Tick, m_Total.m_Ticks, m_Total.m_Overruns, m_Total.m_CatchUpTicks);
+	log_info("server", "tick profile: work p50=%.3fms p99=%.3fms max=%.3fms",
+		m_Total.m_Work.Percentile(50) / 1000.0, m_Total.m_Work.Percentile(99) / 1000.0, m_Total.m_Work.Max() / 1000.0);
+	for(int Phase = 0; Phase < NUM_PHASES; Phase++)
+	{
+		const CDurationHistogram &Histogram = m_Total.m_aPhases[Phase];
+		log_info("server", "tick profile: phase=%s samples=%" PRId64 " p50=%.3fms p99=%.3fms max=%.3fms share=%.1f%%",
+			PhaseName(Phase), Histogram.Count(), Histogram.Percentile(50) / 1000.0, Histogram.Percentile(99) / 1000.0,
+			Histogram.Max() / 1000.0, Seconds > 0.0 ? Histogram.Total() / Seconds / 10000.0 : 0.0);
+	}
+	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+	{
+		const CClientSnapshots &Client = m_Total.m_aClients[ClientId];
+		if(Client.m_Snapshots == 0)
+			continue;
+		log_info("server", "tick profile: ClientId=%d snapshots=%" PRId64 " avg=%" PRId64 "B max=%dB rate=%.1fKiB/s",
+			ClientId, Client.m_Snapshots, Client.m_Bytes / Client.m_Snapshots, Client.m_MaxBytes,
+			Seconds > 0.0 ? Client.m_Bytes / Seconds / 1024.0 : 0.0);
+	}
+}
+
+static void AppendHistogramJson(const CDurationHistogram &Histogram, std::string &Out)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "{\"samples\":%" PRId64 ",\"p50_us\":%" PRId64 ",\"p99_us\":%" PRId64 ",\"max_us\":%" PRId64 ",\"total_us\":%" PRId64 "}",
+		Histogram.Count(), Histogram.Percentile(50), Histogram.Percentile(99), Histogram.Max(), Histogram.Total());
+	Out += aBuf;
+}
+
+void CTickProfiler::FormatJson(const CStats &Stats, int Tick, std::string &Out) const
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "{\"timestamp\":%" PRId64 ",\"tick\":%d,\"seconds\":%.3f,\"ticks\":%" PRId64 ",\"overruns\":%" PRId64 ",\"catch_up_ticks\":%" PRId64 ",\"work\":",
+		time_timestamp(), Tick, (double)(time_get_impl() - Stats.m_StartTime) / time_freq(), Stats.m_Ticks, Stats.m_Overruns, Stats.m_CatchUpTicks);
+	Out += aBuf;
+	AppendHistogramJson(Stats.m_Work, Out);
+	Out += ",\"phases\":{";
+	for(int Phase = 0; Phase < NUM_PHASES; Phase++)
+	{
+		str_format(aBuf, sizeof(aBuf), "%s\"%s\":", Phase == 0 ? "" : ",", PhaseName(Phase));
+		Out += aBuf;
+		AppendHistogramJson(Stats.m_aPhases[Phase], Out);
+	}
+	Out += "},\"snapshots\":[";
+	bool First = true;
+	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+	{
+		const CClientSnapshots &Client = Stats.m_aClients[ClientId];
+		if(Client.m_Snapshots == 0)
+			continue;
+		str_format(aBuf, sizeof(aBuf), "%s{\"client_id\":%d,\"snapshots\":%" PRId64 ",\"bytes\":%" PRId64 ",\"max_bytes\":%d}",
+			First ? "" : ",", ClientId, Client.m_Snapshots, Client.m_Bytes, Client.m_MaxBytes);
+		Out += aBuf;
+		First = false;
+	}
+	Out += "]}";
+}
+
+void CTickProfiler::UpdateFile(IStorage *pStorage, const char *pFilename, int IntervalSeconds, int Tick)
+{
+	if(str_comp(pFilename, m_aFilename) != 0)
+	{
+		if(m_File)
+		{
+			io_close(m_File);
+			m_File = nullptr;
+		}
+		str_copy(m_aFilename, pFilename);
+		if(m_aFilename[0] != '\0')
+		{
+			m_File = pStorage->OpenFile(m_aFilename, IOFLAG_APPEND, IStorage::TYPE_SAVE);
+			if(!m_File)
+				log_error("server", "failed to open tick profile file '%s'", m_aFilename);
+		}
+		m_Interval.Reset();
+	}
+	if(!m_File || time_get_impl() - m_Interval.m_StartTime < IntervalSeconds * time_freq())
+		return;
+
+	std::string Line;
+	FormatJson(m_Interval, Tick, Line);
+	io_write(m_File, Line.c_str(), Line.size());
+	io_write_newline(m_File);
+	io_flush(m_File);
+	m_Interval.Reset();
+}
@@ -0,0 +1,135 @@
+#ifndef ENGINE_SERVER_TICK_PROFILER_H
+#define ENGINE_SERVER_TICK_PROFILER_H
+
+#include <base/types.h>
+
+#include <engine/shared/protocol.h>
+
+#include <cstdint>
+#include <string>
+
+class IStorage;
+
+/**
+ * Histogram of durations in microseconds with four logarithmic buckets per
+ * power of two, percentiles are accurate to about 20%.
+ */
+class CDurationHistogram
+{
+	enum
+	{
+		SUB_BUCKETS = 4,
+		NUM_BUCKETS = 31 * SUB_BUCKETS,
+	};
+
+	uint32_t m_aBuckets[NUM_BUCKETS];
+	int64_t m_Count;
+	int64_t m_Total;
+	int64_t m_Max;
+
+	static int Bucket(int64_t Microseconds);
+	static int64_t BucketUpperBound(int Bucket);
+
+public:
+	CDurationHistogram() { Reset(); }
+
+	void Reset();
+	void Add(int64_t Microseconds);
+
+	int64_t Count() const { return m_Count; }
+	int64_t Total() const { return m_Total; }
+	int64_t Max() const { return m_Max; }
+	/**
+	 * Returns an upper bound of the given percentile, never more than the
+	 * maximum. Returns 0 if the histogram is empty.
+	 */
+	int64_t Percentile(int Percent) const;
+};
+
+/**
+ * Always-on timing of the phases of the server main loop. Each loop
+ * iteration attributes the time since the previous call of `EndPhase` to
+ * the given phase, `EndLoop` adds the accumulated times to the histograms.
+ */
+class CTickProfiler
+{
+public:
+	enum EPhase
+	{
+		PHASE_NETWORK,
+		PHASE_GAME_TICK,
+		PHASE_SNAPSHOT,
+		PHASE_RCON_COMMANDS,
+		PHASE_REGISTER,
+		PHASE_ANTIBOT,
+		PHASE_OTHER,
+		PHASE_WAIT,
+		NUM_PHASES,
+	};
+	static const char *PhaseName(int Phase);
+
+	class CClientSnapshots
+	{
+	public:
+		int64_t m_Snapshots;
+		int64_t m_Bytes;
+		int m_MaxBytes;
+	};
+
+	class CStats
+	{
+	public:
+		CDurationHistogram m_aPhases[NUM_PHASES];
+		// time of the loop iterations that ran ticks, without the wait
+		CDurationHistogram m_Work;
+		int64_t m_Ticks;
+		// loop iterations that took longer than one tick
+		int64_t m_Overruns;
+		// ticks that were run late to catch up with the tick time
+		int64_t m_CatchUpTicks;
+		CClientSnapshots m_aClients[MAX_CLIENTS];
+		int64_t m_StartTime;
+
+		CStats() { Reset(); }
+		void Reset();
+	};
+
+private:
+	CStats m_Total;
+	CStats m_Interval;
+
+	int64_t m_PhaseStart = 0;
+	int64_t m_aLoopTimes[NUM_PHASES] = {};
+	unsigned m_LoopPhases = 0;
+
+	IOHANDLE m_File = nullptr;
+	char m_aFilename[IO_MAX_PATH_LENGTH] = "";
+
+	void FormatJson(const CStats &Stats, int Tick, std::string &Out) const;
+
+public:
+	~CTickProfiler();
+
+	void BeginLoop();
+	void EndPhase(EPhase Phase);
+	void EndLoop(int NewTicks, int TickSpeed);
+
+	/**
+	 * Records the size of a snapshot sent to a client, including empty
+	 * snapshots.
+	 */
+	void AddSnapshot(int ClientId, int Bytes);
+	void ResetClient(int ClientId);
+
+	void Reset();
+	const CStats &Total() const { return m_Total; }
+	void Print(int Tick) const;
+
+	/**
+	 * Appends the stats of the last interval as one JSON line to the file
+	 * once the interval has passed. An empty filename disables the output.
+	 */
+	void UpdateFile(IStorage *pStorage, const char *pFilename, int IntervalSeconds, int Tick);
+};
+
+#endif
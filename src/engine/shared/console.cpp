@@ -184,14 +184,14 @@ int CConsole::ParseStart(CResult *pResult, const char *pString, int Length)
 	return 0;
 }
 
-int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
+int CConsole::ParseArgs(CResult *pResult, const char *pSignature)
 {
 	char *pStr = pResult->m_pArgsStart;
 	bool Optional = false;
 
 	pResult->ResetVictim();
 
-	for(char Command = *pFormat; Command != '\0'; Command = NextParam(pFormat))
+	for(char Command = *pSignature; Command != '\0'; Command = *++pSignature)
 	{
 		if(Command == '?')
 		{
@@ -215,7 +215,7 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 					pResult->SetVictim("me");
 					break;
 				}
-				Command = NextParam(pFormat);
+				Command = *++pSignature;
 			}
 			return PARSEARGS_OK;
 		}
@@ -305,6 +305,18 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 	return PARSEARGS_OK;
 }
 
+void CConsole::CCommand::UpdateSignature()
+{
+	unsigned Length = 0;
+	const char *pFormat = m_pParams;
+	for(char Param = *pFormat; Param != '\0'; Param = NextParam(pFormat))
+	{
+		dbg_assert(Length < sizeof(m_aSignature) - 1, "Too many parameters for command '%s'", m_pName);
+		m_aSignature[Length++] = Param;
+	}
+	m_aSignature[Length] = '\0';
+}
+
 char CConsole::NextParam(const char *&pFormat)
 {
 	if(*pFormat)
@@ -459,7 +471,7 @@ bool CConsole::LineIsValid(const char *pStr)
 			return false;
 
 		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
-		if(!pCommand || ParseArgs(&Result, pCommand->m_pParams))
+		if(!pCommand || ParseArgs(&Result, pCommand->m_aSignature))
 			return false;
 
 		pStr = pNextPart;
@@ -568,7 +580,7 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 
 				if(Stroke || IsStrokeCommand)
 				{
-					if(int Error = ParseArgs(&Result, pCommand->m_pParams))
+					if(int Error = ParseArgs(&Result, pCommand->m_aSignature))
 					{
 						char aBuf[CMDLINE_LENGTH + 64];
 						if(Error == PARSEARGS_INVALID_INTEGER)
@@ -682,15 +694,57 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+size_t CConsole::CCommandNameHash::operator()(std::string_view Name) const
+{
+	// FNV-1a of the lowercase name
+	size_t Hash = 2166136261u;
+	for(char c : Name)
+	{
+		Hash ^= (unsigned char)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+		Hash *= 16777619u;
+	}
+	return Hash;
+}
+
+bool CConsole::CCommandNameEqual::operator()(std::string_view Name1, std::string_view Name2) const
+{
+	return Name1.size() == Name2.size() && str_comp_nocase_num(Name1.data(), Name2.data(), Name1.size()) == 0;
+}
+
+void CConsole::IndexCommand(CCommand *pCommand)
+{
+	auto It = m_CommandIndex.find(std::string_view(pCommand->m_pName));
+	if(It == m_CommandIndex.end())
+		It = m_CommandIndex.emplace(pCommand->m_pName, std::vector<CCommand *>()).first;
+
+	// same position relative to the commands of the same name as in AddCommandSorted
+	std::vector<CCommand *> &vpCommands = It->second;
+	auto Position = std::find_if(vpCommands.begin(), vpCommands.end(), [&](const CCommand *pOther) {
+		return str_comp(pCommand->m_pName, pOther->m_pName) <= 0;
+	});
+	vpCommands.insert(Position, pCommand);
+}
+
+void CConsole::UnindexCommand(CCommand *pCommand)
+{
+	auto It = m_CommandIndex.find(std::string_view(pCommand->m_pName));
+	dbg_assert(It != m_CommandIndex.end(), "Command '%s' is not indexed", pCommand->m_pName);
+	std::vector<CCommand *> &vpCommands = It->second;
+	vpCommands.erase(std::remove(vpCommands.begin(), vpCommands.end(), pCommand), vpCommands.end());
+	if(vpCommands.empty())
+		m_CommandIndex.erase(It);
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(std::string_view(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask)
-		{
-			if(str_comp_nocase(pCommand->m_pName, pName) == 0)
-				return pCommand;
-		}
+			return pCommand;
 	}
 
 	return nullptr;
@@ -953,10 +1007,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 {
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->Next())
-			pCommand->SetNext(m_pFirstCommand);
-		else
-			pCommand->SetNext(nullptr);
+		pCommand->SetNext(m_pFirstCommand);
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -971,6 +1022,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+	IndexCommand(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -989,6 +1041,7 @@ void CConsole::Register(const char *pName, const char *pParams,
 	pCommand->m_pName = pName;
 	pCommand->m_pHelp = pHelp;
 	pCommand->m_pParams = pParams;
+	pCommand->UpdateSignature();
 
 	pCommand->m_Flags = Flags;
 	pCommand->m_Temp = false;
@@ -1025,6 +1078,7 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams, int Flags, c
 		str_copy(pMem, pParams, TEMPCMD_PARAMS_LENGTH);
 		pCommand->m_pParams = pMem;
 	}
+	pCommand->UpdateSignature();
 
 	pCommand->m_pfnCallback = nullptr;
 	pCommand->m_pUserData = nullptr;
@@ -1061,6 +1115,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		UnindexCommand(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1084,6 +1139,16 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(auto It = m_CommandIndex.begin(); It != m_CommandIndex.end();)
+	{
+		std::vector<CCommand *> &vpCommands = It->second;
+		vpCommands.erase(std::remove_if(vpCommands.begin(), vpCommands.end(), [](const CCommand *pCommand) { return pCommand->m_Temp; }), vpCommands.end());
+		if(vpCommands.empty())
+			It = m_CommandIndex.erase(It);
+		else
+			++It;
+	}
+
 	m_TempCommands.Reset();
 	m_pRecycleList = nullptr;
 }
@@ -1126,13 +1191,14 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(std::string_view(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
-		{
-			if(str_comp_nocase(pCommand->Name(), pName) == 0)
-				return pCommand;
-		}
+			return pCommand;
 	}
 
 	return nullptr;
@@ -9,6 +9,9 @@
 #include <engine/storage.h>
 
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 class CConsole : public IConsole
@@ -22,6 +25,10 @@ class CConsole : public IConsole
 		const char *m_pName;
 		const char *m_pHelp;
 		const char *m_pParams;
+		// parameter types of m_pParams without descriptions, as consumed by ParseArgs
+		char m_aSignature[TEMPCMD_PARAMS_LENGTH];
+
+		void UpdateSignature();
 
 		const CCommand *Next() const { return m_pNext; }
 		CCommand *Next() { return m_pNext; }
@@ -48,10 +55,27 @@ class CConsole : public IConsole
 		void *m_pUserData;
 	};
 
+	// case-insensitive, like command lookups
+	class CCommandNameHash
+	{
+	public:
+		using is_transparent = void;
+		size_t operator()(std::string_view Name) const;
+	};
+
+	class CCommandNameEqual
+	{
+	public:
+		using is_transparent = void;
+		bool operator()(std::string_view Name1, std::string_view Name2) const;
+	};
+
 	int m_FlagMask;
 	bool m_StoreCommands;
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
+	// commands by name, each in the same order as in the sorted command list
+	std::unordered_map<std::string, std::vector<CCommand *>, CCommandNameHash, CCommandNameEqual> m_CommandIndex;
 
 	class CExecFile
 	{
@@ -138,7 +162,7 @@ class CConsole : public IConsole
 		PARSEARGS_INVALID_FLOAT,
 	};
 
-	int ParseArgs(CResult *pResult, const char *pFormat);
+	int ParseArgs(CResult *pResult, const char *pSignature);
 
 	/*
 	this function will set pFormat to the next parameter (i,s,r,v,?) it contains and
@@ -146,7 +170,7 @@ class CConsole : public IConsole
 	returns '\0' if there is no next parameter; expects pFormat to point at a
 	parameter
 	*/
-	char NextParam(const char *&pFormat);
+	static char NextParam(const char *&pFormat);
 
 	class CExecutionQueueEntry
 	{
@@ -160,6 +184,8 @@ class CConsole : public IConsole
 	std::vector<CExecutionQueueEntry> m_vExecutionQueue;
 
 	void AddCommandSorted(CCommand *pCommand);
+	void IndexCommand(CCommand *pCommand);
+	void UnindexCommand(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
 	bool m_Cheated;
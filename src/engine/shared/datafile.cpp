@@ -26,6 +26,20 @@
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
 static constexpr int MAX_ITEM_ID = 0xFFFF;
 static constexpr int OFFSET_UUID_TYPE = 0x8000;
+// smaller data is not worth a file and a page of its own
+static constexpr int DATA_CACHE_MIN_SIZE = 16 * 1024;
+static constexpr int DATA_CACHE_VERSION = 2;
+
+// Appended to the data in the data cache files, to reject files that are
+// truncated, corrupted or written by a build with another cache format.
+struct CDataCacheTrailer
+{
+	char m_aMagic[4];
+	int m_Version;
+	int m_Size;
+	unsigned m_Crc;
+};
+static constexpr char DATA_CACHE_MAGIC[4] = {'D', 'D', 'C', 'D'};
 
 static inline void SwapEndianInPlace(void *pObj, size_t Size)
 {
@@ -154,8 +168,113 @@ public:
 	CDataProcessorWrapper **m_ppDataProcessors;
 	CDatafileItem **m_ppOverriddenItems;
 	int *m_pDataSizes;
+	// whether the data is mapped from the data cache instead of allocated
+	bool *m_pDataMapped;
 	char *m_pData;
 
+	IStorage *m_pCacheStorage;
+	char m_aCacheDirectory[IO_MAX_PATH_LENGTH];
+
+	void FreeData(int Index) const
+	{
+		if(m_pDataMapped[Index])
+			io_unmap(m_ppDataPtrs[Index], m_pDataSizes[Index] + sizeof(CDataCacheTrailer));
+		else
+			free(m_ppDataPtrs[Index]);
+		m_ppDataPtrs[Index] = nullptr;
+		m_pDataMapped[Index] = false;
+	}
+
+	void CacheFilename(int Index, bool Swap, char *pBuf, int BufSize) const
+	{
+		char aSha256[SHA256_MAXSTRSIZE];
+		sha256_str(m_Sha256, aSha256, sizeof(aSha256));
+		str_format(pBuf, BufSize, "%s/%s_%d_%d%s.bin", m_aCacheDirectory, aSha256, DATA_CACHE_VERSION, Index, Swap ? "_swapped" : "");
+	}
+
+	// Replaces the data with a mapping of the cached data. `ExpectedSize` is
+	// `-1` if the size of the processed data is not known yet, the size and
+	// checksum in the trailer are verified either way. Invalid files are
+	// removed so they are written again.
+	bool LoadCachedData(int Index, bool Swap, int ExpectedSize) const
+	{
+		char aFilename[IO_MAX_PATH_LENGTH];
+		CacheFilename(Index, Swap, aFilename, sizeof(aFilename));
+		IOHANDLE File = m_pCacheStorage->OpenFile(aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(!File)
+		{
+			return false;
+		}
+		int64_t Size;
+		void *pData = io_map(File, &Size);
+		io_close(File);
+		if(pData == nullptr)
+		{
+			return false;
+		}
+		const int64_t DataSize = Size - (int64_t)sizeof(CDataCacheTrailer);
+		CDataCacheTrailer Trailer = {};
+		if(DataSize >= 0)
+		{
+			mem_copy(&Trailer, (const char *)pData + DataSize, sizeof(Trailer));
+		}
+		if(DataSize < 0 || DataSize > std::numeric_limits<int>::max() ||
+			mem_comp(Trailer.m_aMagic, DATA_CACHE_MAGIC, sizeof(DATA_CACHE_MAGIC)) != 0 ||
+			Trailer.m_Version != DATA_CACHE_VERSION ||
+			Trailer.m_Size != DataSize ||
+			(ExpectedSize >= 0 && DataSize != ExpectedSize) ||
+			crc32(0, (const Bytef *)pData, DataSize) != Trailer.m_Crc)
+		{
+			log_error("datafile", "invalid data cache file. index=%d size=%" PRId64 " expected=%d file='%s'", Index, DataSize, ExpectedSize, aFilename);
+			io_unmap(pData, Size);
+			m_pCacheStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+			return false;
+		}
+		if(m_ppDataPtrs[Index] != nullptr)
+		{
+			FreeData(Index);
+		}
+		m_ppDataPtrs[Index] = pData;
+		m_pDataSizes[Index] = DataSize;
+		m_pDataMapped[Index] = true;
+		return true;
+	}
+
+	// Writes the loaded data to the data cache and maps it from there, so
+	// other processes loading the same file share its memory.
+	void StoreCachedData(int Index, bool Swap) const
+	{
+		char aFilename[IO_MAX_PATH_LENGTH];
+		CacheFilename(Index, Swap, aFilename, sizeof(aFilename));
+		char aTmpFilename[IO_MAX_PATH_LENGTH];
+		IStorage::FormatTmpPath(aTmpFilename, sizeof(aTmpFilename), aFilename);
+		IOHANDLE File = m_pCacheStorage->OpenFile(aTmpFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!File)
+		{
+			log_error("datafile", "failed to open data cache file for writing. file='%s'", aTmpFilename);
+			return;
+		}
+		CDataCacheTrailer Trailer;
+		mem_copy(Trailer.m_aMagic, DATA_CACHE_MAGIC, sizeof(DATA_CACHE_MAGIC));
+		Trailer.m_Version = DATA_CACHE_VERSION;
+		Trailer.m_Size = m_pDataSizes[Index];
+		Trailer.m_Crc = crc32(0, (const Bytef *)m_ppDataPtrs[Index], m_pDataSizes[Index]);
+		const bool Written = io_write(File, m_ppDataPtrs[Index], m_pDataSizes[Index]) == (unsigned)m_pDataSizes[Index] &&
+			io_write(File, &Trailer, sizeof(Trailer)) == sizeof(Trailer);
+		if(io_close(File) != 0 || !Written)
+		{
+			log_error("datafile", "failed to write data cache file. file='%s'", aTmpFilename);
+			m_pCacheStorage->RemoveFile(aTmpFilename, IStorage::TYPE_SAVE);
+			return;
+		}
+		// another process may have stored the same data in the meantime
+		if(!m_pCacheStorage->RenameFile(aTmpFilename, aFilename, IStorage::TYPE_SAVE))
+		{
+			m_pCacheStorage->RemoveFile(aTmpFilename, IStorage::TYPE_SAVE);
+		}
+		LoadCachedData(Index, Swap, m_pDataSizes[Index]);
+	}
+
 	int GetFileDataSize(int Index) const
 	{
 		dbg_assert(Index >= 0 && Index < m_Header.m_NumRawData, "Invalid Index: %d", Index);
@@ -216,6 +335,12 @@ public:
 			return nullptr;
 		}
 
+		const bool UseCache = m_pCacheStorage != nullptr && GetDataSize(Index) >= DATA_CACHE_MIN_SIZE;
+		if(UseCache && LoadCachedData(Index, Swap, m_ppDataProcessors[Index] == nullptr ? GetDataSize(Index) : -1))
+		{
+			return m_ppDataPtrs[Index];
+		}
+
 		const unsigned DataSize = GetFileDataSize(Index);
 		if(m_Info.m_pDataSizes != nullptr)
 		{
@@ -319,6 +444,11 @@ public:
 			m_pDataSizes[Index] = NewSize;
 		}
 
+		if(UseCache)
+		{
+			StoreCachedData(Index, Swap);
+		}
+
 		return m_ppDataPtrs[Index];
 	}
 
@@ -661,6 +791,7 @@ bool CDataFileReader::Open(const char *pFullName, IStorage *pStorage, const char
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(CDataProcessorWrapper *); // add space for data interceptors
 	AllocSize += (int64_t)Header.m_NumItems * sizeof(CDatafileItem *); // add space for item overrides
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(int); // add space for data sizes
+	AllocSize += (int64_t)Header.m_NumRawData * sizeof(bool); // add space for mapped flags
 	if(AllocSize > MaxAllocSize)
 	{
 		io_close(File);
@@ -682,6 +813,9 @@ bool CDataFileReader::Open(const char *pFullName, IStorage *pStorage, const char
 	pTmpDataFile->m_ppOverriddenItems = (CDatafileItem **)(pTmpDataFile->m_ppDataProcessors + Header.m_NumRawData);
 	pTmpDataFile->m_pDataSizes = (int *)(pTmpDataFile->m_ppOverriddenItems + Header.m_NumItems);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
+	pTmpDataFile->m_pDataMapped = (bool *)(pTmpDataFile->m_pData + Size);
+	pTmpDataFile->m_pCacheStorage = nullptr;
+	pTmpDataFile->m_aCacheDirectory[0] = '\0';
 	pTmpDataFile->m_File = File;
 	str_copy(pTmpDataFile->m_aFullName, pFullName);
 	pTmpDataFile->m_pBaseName = fs_filename(pTmpDataFile->m_aFullName);
@@ -695,6 +829,7 @@ bool CDataFileReader::Open(const char *pFullName, IStorage *pStorage, const char
 	mem_zero(pTmpDataFile->m_ppDataProcessors, Header.m_NumRawData * sizeof(CDataProcessorWrapper *));
 	mem_zero(pTmpDataFile->m_ppOverriddenItems, Header.m_NumItems * sizeof(CDatafileItem *));
 	mem_zero(pTmpDataFile->m_pDataSizes, Header.m_NumRawData * sizeof(int));
+	mem_zero(pTmpDataFile->m_pDataMapped, Header.m_NumRawData * sizeof(bool));
 
 	// read types, offsets, sizes and item data
 	const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
@@ -755,7 +890,7 @@ void CDataFileReader::Close()
 
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 	{
-		free(m_pDataFile->m_ppDataPtrs[i]);
+		m_pDataFile->FreeData(i);
 		delete m_pDataFile->m_ppDataProcessors[i];
 	}
 
@@ -832,6 +967,19 @@ void CDataFileReader::AddDataProcessor(int Index, FDataProcessor DataProcessor)
 	m_pDataFile->AddDataProcessor(Index, std::move(DataProcessor));
 }
 
+void CDataFileReader::SetDataCache(IStorage *pStorage, const char *pDirectory)
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	if(!pStorage->CreateFolder(pDirectory, IStorage::TYPE_SAVE))
+	{
+		log_error("datafile", "failed to create data cache folder. folder='%s'", pDirectory);
+		return;
+	}
+	m_pDataFile->m_pCacheStorage = pStorage;
+	str_copy(m_pDataFile->m_aCacheDirectory, pDirectory);
+}
+
 void CDataFileReader::UnloadData(int Index)
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
@@ -843,8 +991,7 @@ void CDataFileReader::UnloadData(int Index)
 	if(m_pDataFile->m_pDataSizes[Index] < 0)
 		return;
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
@@ -52,6 +52,12 @@ public:
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	const char *GetDataString(int Index);
 	void AddDataProcessor(int Index, FDataProcessor DataProcessor);
+	/**
+	 * Shares large data between processes through files in the given folder
+	 * of the save storage, named by the SHA256 of this file. Data is written
+	 * there once after loading and memory-mapped copy-on-write afterwards.
+	 */
+	void SetDataCache(IStorage *pStorage, const char *pDirectory);
 	void UnloadData(int Index);
 	int NumData() const;
 
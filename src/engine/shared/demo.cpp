@@ -4,10 +4,13 @@
 #include <base/dbg.h>
 #include <base/fs.h>
 #include <base/io.h>
+#include <base/lock.h>
 #include <base/log.h>
 #include <base/math.h>
 #include <base/mem.h>
+#include <base/sphore.h>
 #include <base/str.h>
+#include <base/thread.h>
 #include <base/time.h>
 
 #include <engine/console.h>
@@ -32,6 +35,38 @@ static const unsigned char gs_OldVersion = 3;
 static const unsigned char gs_Sha256Version = 6;
 static const unsigned char gs_VersionTickCompression = 5; // demo files with this version or higher will use `CHUNKTICKFLAG_TICK_COMPRESSED`
 
+// The keyframe index is stored next to the demo file, all values are big-endian.
+static const unsigned char gs_aIndexMarker[8] = {'T', 'W', 'D', 'E', 'M', 'I', 'D', 'X'};
+static const unsigned char gs_IndexVersion = 1;
+
+struct CDemoIndexHeader
+{
+	unsigned char m_aMarker[8];
+	unsigned char m_aVersion[sizeof(int32_t)];
+	// size of the demo file, the index is outdated if it changed
+	unsigned char m_aDemoSize[sizeof(int64_t)];
+	unsigned char m_aFirstTick[sizeof(int32_t)];
+	unsigned char m_aLastTick[sizeof(int32_t)];
+	unsigned char m_aNumKeyFrames[sizeof(int32_t)];
+};
+
+struct CDemoIndexKeyFrame
+{
+	unsigned char m_aFilepos[sizeof(int64_t)];
+	unsigned char m_aTick[sizeof(int32_t)];
+};
+
+static void Int64ToBytesBe(unsigned char *pBytes, int64_t Value)
+{
+	uint_to_bytes_be(pBytes, (uint64_t)Value >> 32);
+	uint_to_bytes_be(pBytes + sizeof(int32_t), (uint64_t)Value & 0xffffffff);
+}
+
+static int64_t BytesBeToInt64(const unsigned char *pBytes)
+{
+	return (int64_t)(((uint64_t)bytes_be_to_uint(pBytes) << 32) | bytes_be_to_uint(pBytes + sizeof(int32_t)));
+}
+
 // TODO: rewrite all logs in this file using log_log_color, and remove gs_DemoPrintColor and m_pConsole
 static constexpr ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 static constexpr LOG_COLOR DEMO_PRINT_COLOR = {191, 178, 178};
@@ -46,6 +81,181 @@ bool CDemoHeader::Valid() const
 	       mem_has_null(m_aTimestamp, sizeof(m_aTimestamp)) && str_utf8_check(m_aTimestamp);
 }
 
+enum
+{
+	// what the recorder hands from the recording thread to `ProcessRecord`
+	RECORD_RAW = 0, // already encoded chunk data, tick markers
+	RECORD_MESSAGE,
+	RECORD_KEYFRAME,
+	RECORD_DELTA,
+
+	MAX_RECORD_SIZE = 64 * 1024,
+};
+
+// Ring buffer of records between the recording thread and a background thread
+// that compresses them and writes them to the demo file. Records are stored
+// contiguously; if one doesn't fit before the end of the buffer, the rest of
+// the buffer is skipped with a wrap record.
+class CDemoRecorder::CAsyncWriter
+{
+	enum
+	{
+		RECORD_WRAP = -1,
+		ALIGNMENT = 8,
+	};
+
+	struct CRecordHeader
+	{
+		int m_Kind;
+		int m_Size;
+	};
+
+	static size_t RecordSize(int DataSize)
+	{
+		return (sizeof(CRecordHeader) + DataSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	CDemoRecorder *m_pRecorder;
+	void *m_pThread;
+
+	CLock m_Lock;
+	CSemaphore m_Work;
+	CSemaphore m_Space;
+	std::vector<unsigned char> m_vBuffer;
+	size_t m_ReadPos GUARDED_BY(m_Lock) = 0;
+	size_t m_WritePos GUARDED_BY(m_Lock) = 0;
+	size_t m_Used GUARDED_BY(m_Lock) = 0;
+	size_t m_PeakUsed GUARDED_BY(m_Lock) = 0;
+	bool m_WaitingForSpace GUARDED_BY(m_Lock) = false;
+	bool m_Finish GUARDED_BY(m_Lock) = false;
+	int m_NumStalls = 0;
+
+	static void ThreadFunc(void *pUser)
+	{
+		static_cast<CAsyncWriter *>(pUser)->Run();
+	}
+
+	void Run() REQUIRES(!m_Lock)
+	{
+		while(true)
+		{
+			m_Work.Wait();
+			while(true)
+			{
+				size_t Pos;
+				CRecordHeader Header;
+				{
+					const CLockScope LockScope(m_Lock);
+					if(m_Used == 0)
+					{
+						if(m_Finish)
+							return;
+						break;
+					}
+					Pos = m_ReadPos;
+				}
+
+				// the recording thread never touches used parts of the buffer
+				mem_copy(&Header, &m_vBuffer[Pos], sizeof(Header));
+				size_t Consumed;
+				if(Header.m_Kind == RECORD_WRAP)
+				{
+					Consumed = m_vBuffer.size() - Pos;
+				}
+				else
+				{
+					m_pRecorder->ProcessRecord(Header.m_Kind, &m_vBuffer[Pos + sizeof(Header)], Header.m_Size);
+					Consumed = RecordSize(Header.m_Size);
+				}
+
+				bool WakeUp;
+				{
+					const CLockScope LockScope(m_Lock);
+					m_ReadPos = (Pos + Consumed) % m_vBuffer.size();
+					m_Used -= Consumed;
+					WakeUp = m_WaitingForSpace;
+					m_WaitingForSpace = false;
+				}
+				if(WakeUp)
+					m_Space.Signal();
+			}
+		}
+	}
+
+public:
+	CAsyncWriter(CDemoRecorder *pRecorder, int BufferSize) :
+		m_pRecorder(pRecorder)
+	{
+		// any record must fit, even after skipping to the start of the buffer
+		const size_t MinSize = 2 * RecordSize(MAX_RECORD_SIZE);
+		const size_t Size = ((size_t)BufferSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		m_vBuffer.resize(std::max(Size, MinSize));
+		m_pThread = thread_init(ThreadFunc, this, "demo writer");
+		dbg_assert(m_pThread != nullptr, "failed to create demo writer thread");
+	}
+
+	void Push(int Kind, const void *pData, int Size) REQUIRES(!m_Lock)
+	{
+		const size_t Needed = RecordSize(Size);
+		bool Stalled = false;
+		while(true)
+		{
+			{
+				const CLockScope LockScope(m_Lock);
+				const size_t Tail = m_vBuffer.size() - m_WritePos;
+				const size_t Required = Needed <= Tail ? Needed : Tail + Needed;
+				if(m_vBuffer.size() - m_Used >= Required)
+				{
+					if(Needed > Tail)
+					{
+						const CRecordHeader Wrap = {RECORD_WRAP, 0};
+						mem_copy(&m_vBuffer[m_WritePos], &Wrap, sizeof(Wrap));
+						m_Used += Tail;
+						m_WritePos = 0;
+					}
+					const CRecordHeader Header = {Kind, Size};
+					mem_copy(&m_vBuffer[m_WritePos], &Header, sizeof(Header));
+					mem_copy(&m_vBuffer[m_WritePos + sizeof(Header)], pData, Size);
+					m_WritePos = (m_WritePos + Needed) % m_vBuffer.size();
+					m_Used += Needed;
+					m_PeakUsed = std::max(m_PeakUsed, m_Used);
+					break;
+				}
+				m_WaitingForSpace = true;
+			}
+			if(!Stalled)
+			{
+				m_NumStalls++;
+				Stalled = true;
+			}
+			m_Space.Wait();
+		}
+		m_Work.Signal();
+	}
+
+	void Finish() REQUIRES(!m_Lock)
+	{
+		{
+			const CLockScope LockScope(m_Lock);
+			m_Finish = true;
+		}
+		m_Work.Signal();
+		thread_wait(m_pThread);
+		m_pThread = nullptr;
+	}
+
+	int NumStalls() const { return m_NumStalls; }
+	size_t PeakUsed() REQUIRES(!m_Lock)
+	{
+		const CLockScope LockScope(m_Lock);
+		return m_PeakUsed;
+	}
+};
+
+CDemoRecorder::CDemoRecorder() = default;
+CDemoRecorder::CDemoRecorder(CDemoRecorder &&Other) = default;
+CDemoRecorder &CDemoRecorder::operator=(CDemoRecorder &&Other) = default;
+
 CDemoRecorder::CDemoRecorder(CSnapshotDelta *pSnapshotDelta, bool NoMapData)
 {
 	m_File = nullptr;
@@ -222,6 +432,11 @@ int CDemoRecorder::Start(IStorage *pStorage, IConsole *pConsole, const char *pFi
 	m_File = DemoFile;
 	str_copy(m_aCurrentFilename, pFilename);
 
+	m_NumAsyncStalls = 0;
+	m_AsyncPeakBuffered = 0;
+	if(m_AsyncBufferSize > 0)
+		m_pAsyncWriter = std::make_unique<CAsyncWriter>(this, m_AsyncBufferSize);
+
 	return 0;
 }
 
@@ -264,13 +479,13 @@ void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 		if(Keyframe)
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		Record(RECORD_RAW, aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		Record(RECORD_RAW, aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -283,7 +498,7 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	if(!m_File)
 		return;
 
-	if(Size > 64 * 1024)
+	if(Size > MAX_RECORD_SIZE)
 		return;
 
 	/* pad the data with 0 so we get an alignment of 4,
@@ -328,6 +543,49 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	io_write(m_File, aBuffer2, Size);
 }
 
+void CDemoRecorder::Record(int Kind, const void *pData, int Size)
+{
+	if(!m_pAsyncWriter)
+	{
+		ProcessRecord(Kind, pData, Size);
+		return;
+	}
+	// `Write` drops these anyway
+	if(Size < 0 || Size > MAX_RECORD_SIZE)
+		return;
+	m_pAsyncWriter->Push(Kind, pData, Size);
+}
+
+void CDemoRecorder::ProcessRecord(int Kind, const void *pData, int Size)
+{
+	switch(Kind)
+	{
+	case RECORD_RAW:
+		io_write(m_File, pData, Size);
+		break;
+	case RECORD_MESSAGE:
+		Write(CHUNKTYPE_MESSAGE, pData, Size);
+		break;
+	case RECORD_KEYFRAME:
+		Write(CHUNKTYPE_SNAPSHOT, pData, Size);
+		mem_copy(&m_LastSnapshotData, pData, Size);
+		break;
+	case RECORD_DELTA:
+	{
+		char aDeltaData[CSnapshot::MAX_SIZE];
+		const int DeltaSize = m_pSnapshotDelta->CreateDelta(m_LastSnapshotData.AsSnapshot(), (const CSnapshot *)pData, &aDeltaData);
+		if(DeltaSize)
+		{
+			Write(CHUNKTYPE_DELTA, aDeltaData, DeltaSize);
+			mem_copy(&m_LastSnapshotData, pData, Size);
+		}
+		break;
+	}
+	default:
+		dbg_assert_failed("invalid demo record kind %d", Kind);
+	}
+}
+
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 {
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
@@ -336,25 +594,17 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		WriteTickMarker(Tick, true);
 
 		// write snapshot
-		Write(CHUNKTYPE_SNAPSHOT, pData, Size);
+		Record(RECORD_KEYFRAME, pData, Size);
 
 		m_LastKeyFrame = Tick;
-		mem_copy(&m_LastSnapshotData, pData, Size);
 	}
 	else
 	{
 		// write tickmarker
 		WriteTickMarker(Tick, false);
 
-		// create delta
-		char aDeltaData[CSnapshot::MAX_SIZE];
-		const int DeltaSize = m_pSnapshotDelta->CreateDelta(m_LastSnapshotData.AsSnapshot(), (CSnapshot *)pData, &aDeltaData);
-		if(DeltaSize)
-		{
-			// record delta
-			Write(CHUNKTYPE_DELTA, aDeltaData, DeltaSize);
-			mem_copy(&m_LastSnapshotData, pData, Size);
-		}
+		// write delta to the last snapshot
+		Record(RECORD_DELTA, pData, Size);
 	}
 }
 
@@ -367,7 +617,7 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 			return;
 		}
 	}
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	Record(RECORD_MESSAGE, pData, Size);
 }
 
 int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename)
@@ -375,6 +625,20 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	if(!m_File)
 		return -1;
 
+	if(m_pAsyncWriter)
+	{
+		m_pAsyncWriter->Finish();
+		m_NumAsyncStalls = m_pAsyncWriter->NumStalls();
+		m_AsyncPeakBuffered = m_pAsyncWriter->PeakUsed();
+		m_pAsyncWriter = nullptr;
+		if(m_pConsole)
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "Demo writer buffered up to %d KiB, recording waited %d times for a full buffer", (int)(m_AsyncPeakBuffered / 1024), m_NumAsyncStalls);
+			m_pConsole->Print(m_NumAsyncStalls ? IConsole::OUTPUT_LEVEL_STANDARD : IConsole::OUTPUT_LEVEL_ADDINFO, "demo_recorder", aBuf, gs_DemoPrintColor);
+		}
+	}
+
 	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE)
 	{
 		// add the demo length to the header
@@ -498,6 +762,7 @@ void CDemoPlayer::Construct(CSnapshotDelta *pSnapshotDelta, CSnapshotDelta *pSna
 	m_UseVideo = UseVideo;
 
 	m_aFilename[0] = '\0';
+	m_aIndexPath[0] = '\0';
 	m_aErrorMessage[0] = '\0';
 }
 
@@ -665,6 +930,113 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 	return ResetToStartPosition(m_vKeyFrames.empty() ? EScanFileResult::ERROR_UNRECOVERABLE : EScanFileResult::SUCCESS);
 }
 
+void CDemoPlayer::IndexFilename(const char *pDemoFilename, char *pBuffer, size_t BufferSize)
+{
+	str_format(pBuffer, BufferSize, "%s.idx", pDemoFilename);
+}
+
+bool CDemoPlayer::LoadIndex(IStorage *pStorage)
+{
+	if(m_aIndexPath[0] == '\0')
+		return false;
+	IOHANDLE IndexFile = pStorage->OpenFile(m_aIndexPath, IOFLAG_READ, IStorage::TYPE_ABSOLUTE);
+	if(!IndexFile)
+		return false;
+
+	CDemoIndexHeader Header;
+	const int64_t IndexSize = io_length(IndexFile);
+	if(io_read(IndexFile, &Header, sizeof(Header)) != sizeof(Header) ||
+		mem_comp(Header.m_aMarker, gs_aIndexMarker, sizeof(gs_aIndexMarker)) != 0 ||
+		bytes_be_to_uint(Header.m_aVersion) != gs_IndexVersion)
+	{
+		io_close(IndexFile);
+		return false;
+	}
+
+	const int64_t DemoSize = io_length(m_File);
+	const int NumKeyFrames = bytes_be_to_uint(Header.m_aNumKeyFrames);
+	if(io_seek(m_File, m_DataOffset, EIoSeekOrigin::START) != 0 || DemoSize < 0 ||
+		BytesBeToInt64(Header.m_aDemoSize) != DemoSize ||
+		NumKeyFrames <= 0 ||
+		IndexSize != (int64_t)(sizeof(Header) + NumKeyFrames * sizeof(CDemoIndexKeyFrame)))
+	{
+		io_close(IndexFile);
+		return false;
+	}
+
+	std::vector<CDemoIndexKeyFrame> vIndexKeyFrames(NumKeyFrames);
+	const unsigned ReadSize = NumKeyFrames * sizeof(CDemoIndexKeyFrame);
+	const bool Read = io_read(IndexFile, vIndexKeyFrames.data(), ReadSize) == ReadSize;
+	io_close(IndexFile);
+	if(!Read)
+		return false;
+
+	std::vector<CKeyFrame> vKeyFrames;
+	vKeyFrames.reserve(NumKeyFrames);
+	for(const CDemoIndexKeyFrame &IndexKeyFrame : vIndexKeyFrames)
+	{
+		const int64_t Filepos = BytesBeToInt64(IndexKeyFrame.m_aFilepos);
+		const int Tick = bytes_be_to_uint(IndexKeyFrame.m_aTick);
+		if(Filepos < m_DataOffset || Filepos >= DemoSize || Tick < MIN_TICK || Tick >= MAX_TICK ||
+			(!vKeyFrames.empty() && (Filepos <= vKeyFrames.back().m_Filepos || Tick <= vKeyFrames.back().m_Tick)))
+			return false;
+		vKeyFrames.emplace_back(Filepos, Tick);
+	}
+	const int FirstTick = bytes_be_to_uint(Header.m_aFirstTick);
+	const int LastTick = bytes_be_to_uint(Header.m_aLastTick);
+	if(FirstTick > vKeyFrames.front().m_Tick || LastTick < vKeyFrames.back().m_Tick)
+		return false;
+
+	// check that the last keyframe is where the index says it is
+	int ChunkType, ChunkSize;
+	int ChunkTick = -1;
+	const bool Valid = io_seek(m_File, vKeyFrames.back().m_Filepos, EIoSeekOrigin::START) == 0 &&
+			   ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick) == CHUNKHEADER_SUCCESS &&
+			   ChunkType == (CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_KEYFRAME) &&
+			   ChunkTick == vKeyFrames.back().m_Tick;
+	if(io_seek(m_File, m_DataOffset, EIoSeekOrigin::START) != 0 || !Valid)
+		return false;
+
+	m_vKeyFrames = std::move(vKeyFrames);
+	m_Info.m_Info.m_FirstTick = FirstTick;
+	m_Info.m_Info.m_LastTick = LastTick;
+	return true;
+}
+
+bool CDemoPlayer::SaveIndex(IStorage *pStorage)
+{
+	if(!m_File || m_vKeyFrames.empty() || m_aIndexPath[0] == '\0')
+		return false;
+
+	const int64_t Pos = io_tell(m_File);
+	const int64_t DemoSize = io_length(m_File);
+	if(Pos < 0 || DemoSize < 0 || io_seek(m_File, Pos, EIoSeekOrigin::START) != 0)
+		return false;
+
+	CDemoIndexHeader Header;
+	mem_copy(Header.m_aMarker, gs_aIndexMarker, sizeof(Header.m_aMarker));
+	uint_to_bytes_be(Header.m_aVersion, gs_IndexVersion);
+	Int64ToBytesBe(Header.m_aDemoSize, DemoSize);
+	uint_to_bytes_be(Header.m_aFirstTick, m_Info.m_Info.m_FirstTick);
+	uint_to_bytes_be(Header.m_aLastTick, m_Info.m_Info.m_LastTick);
+	uint_to_bytes_be(Header.m_aNumKeyFrames, m_vKeyFrames.size());
+
+	std::vector<CDemoIndexKeyFrame> vIndexKeyFrames(m_vKeyFrames.size());
+	for(size_t i = 0; i < m_vKeyFrames.size(); i++)
+	{
+		Int64ToBytesBe(vIndexKeyFrames[i].m_aFilepos, m_vKeyFrames[i].m_Filepos);
+		uint_to_bytes_be(vIndexKeyFrames[i].m_aTick, m_vKeyFrames[i].m_Tick);
+	}
+
+	IOHANDLE IndexFile = pStorage->OpenFile(m_aIndexPath, IOFLAG_WRITE, IStorage::TYPE_ABSOLUTE);
+	if(!IndexFile)
+		return false;
+	const unsigned KeyFramesSize = vIndexKeyFrames.size() * sizeof(CDemoIndexKeyFrame);
+	const bool Written = io_write(IndexFile, &Header, sizeof(Header)) == sizeof(Header) &&
+			     io_write(IndexFile, vIndexKeyFrames.data(), KeyFramesSize) == KeyFramesSize;
+	return io_close(IndexFile) == 0 && Written;
+}
+
 void CDemoPlayer::DoTick()
 {
 	// update ticks
@@ -864,6 +1236,20 @@ int CDemoPlayer::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilen
 	}
 	m_Sixup = str_startswith(m_Info.m_Header.m_aNetversion, "0.7");
 
+	// keep the index in the directory the demo was found in, the storage
+	// types may search several directories
+	char aDemoPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE DemoPathFile = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aDemoPath, sizeof(aDemoPath));
+	if(DemoPathFile)
+	{
+		io_close(DemoPathFile);
+		IndexFilename(aDemoPath, m_aIndexPath, sizeof(m_aIndexPath));
+	}
+	else
+	{
+		m_aIndexPath[0] = '\0';
+	}
+
 	// save byte offset of map for later use
 	m_MapOffset = io_tell(m_File);
 	if(m_MapOffset < 0 || io_skip(m_File, m_MapInfo.m_Size) != 0)
@@ -871,6 +1257,12 @@ int CDemoPlayer::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilen
 		Stop("Error skipping map data");
 		return -1;
 	}
+	m_DataOffset = io_tell(m_File);
+	if(m_DataOffset < 0)
+	{
+		Stop("Error reading demo file position");
+		return -1;
+	}
 
 	if(m_Info.m_Header.m_Version > gs_OldVersion)
 	{
@@ -883,8 +1275,8 @@ int CDemoPlayer::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilen
 		}
 	}
 
-	// Scan the file for interesting points
-	if(ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
+	// Use the keyframe index if it is up to date, otherwise scan the file for interesting points
+	if(!LoadIndex(pStorage) && ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
 	{
 		Stop("Error scanning demo file");
 		return -1;
@@ -1291,6 +1683,7 @@ void CDemoPlayer::Stop(const char *pErrorMessage)
 	m_File = nullptr;
 	m_vKeyFrames.clear();
 	str_copy(m_aFilename, "");
+	m_aIndexPath[0] = '\0';
 	str_copy(m_aErrorMessage, pErrorMessage);
 }
 
@@ -11,6 +11,7 @@
 #include <engine/shared/protocol.h>
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
@@ -41,14 +42,38 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
+	class CAsyncWriter;
+	int m_AsyncBufferSize = 0;
+	std::unique_ptr<CAsyncWriter> m_pAsyncWriter;
+	int m_NumAsyncStalls = 0;
+	size_t m_AsyncPeakBuffered = 0;
+
 	void WriteTickMarker(int Tick, bool Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void Record(int Kind, const void *pData, int Size);
+	void ProcessRecord(int Kind, const void *pData, int Size);
 
 public:
 	CDemoRecorder(CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
-	CDemoRecorder() = default;
+	CDemoRecorder();
+	CDemoRecorder(CDemoRecorder &&Other);
+	CDemoRecorder &operator=(CDemoRecorder &&Other);
 	~CDemoRecorder() override;
 
+	/**
+	 * Makes the following recordings hand snapshots and messages to a
+	 * background thread, which compresses them and writes them to the file.
+	 * Recording then only copies the data into a ring buffer of the given size
+	 * in bytes. The file contents are the same as with synchronous recording.
+	 * A size of zero records synchronously. Takes effect on the next `Start`.
+	 */
+	void SetAsyncBufferSize(int Size) { m_AsyncBufferSize = Size; }
+	// Statistics of the background writer of the last recording, available
+	// after `Stop`: how often recording had to wait because the buffer was
+	// full, and the maximum number of bytes that were waiting to be written.
+	int NumAsyncStalls() const { return m_NumAsyncStalls; }
+	size_t AsyncPeakBuffered() const { return m_AsyncPeakBuffered; }
+
 	int Start(IStorage *pStorage, IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser);
 	int Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename = "") override;
 
@@ -120,7 +145,10 @@ private:
 	IConsole *m_pConsole;
 	IOHANDLE m_File;
 	int64_t m_MapOffset;
+	int64_t m_DataOffset;
 	char m_aFilename[IO_MAX_PATH_LENGTH];
+	// absolute path of the index file, next to the loaded demo file
+	char m_aIndexPath[IO_MAX_PATH_LENGTH];
 	char m_aErrorMessage[256];
 	std::vector<CKeyFrame> m_vKeyFrames;
 	CMapInfo m_MapInfo;
@@ -161,6 +189,7 @@ private:
 		ERROR_UNRECOVERABLE,
 	};
 	EScanFileResult ScanFile();
+	bool LoadIndex(IStorage *pStorage);
 	void UpdateTimes();
 
 	int64_t Time();
@@ -177,6 +206,15 @@ public:
 	void SetListener(IListener *pListener);
 
 	int Load(IStorage *pStorage, IConsole *pConsole, const char *pFilename, int StorageType);
+	/**
+	 * Writes the keyframes of the loaded demo to an index file next to the
+	 * demo, in the directory the demo was loaded from. `Load` uses the index
+	 * instead of scanning the whole demo file as long as the demo has not
+	 * been changed since.
+	 */
+	bool SaveIndex(IStorage *pStorage);
+	static void IndexFilename(const char *pDemoFilename, char *pBuffer, size_t BufferSize);
+	const char *IndexPath() const { return m_aIndexPath; }
 	unsigned char *GetMapData(IStorage *pStorage);
 	bool ExtractMap(IStorage *pStorage);
 	void Play();
@@ -86,6 +86,11 @@ static bool AtMostOneBitSet(int Flags)
 	return (Flags & (Flags - 1)) == 0;
 }
 
+void CMap::SetDataCache(const char *pDirectory)
+{
+	str_copy(m_aDataCacheDirectory, pDirectory);
+}
+
 bool CMap::Load(const char *pFullName, IStorage *pStorage, const char *pPath, int StorageType)
 {
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
@@ -93,6 +98,8 @@ bool CMap::Load(const char *pFullName, IStorage *pStorage, const char *pPath, in
 	CDataFileReader NewDataFile;
 	if(!NewDataFile.Open(pFullName, pStorage, pPath, StorageType))
 		return false;
+	if(m_aDataCacheDirectory[0] != '\0')
+		NewDataFile.SetDataCache(pStorage, m_aDataCacheDirectory);
 
 	if(!ValidateMapVersion(NewDataFile))
 	{
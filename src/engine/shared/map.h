@@ -17,6 +17,7 @@ class CMapItemLayerTilemap_v2;
 class CMap : public IMap
 {
 	CDataFileReader m_DataFile;
+	char m_aDataCacheDirectory[IO_MAX_PATH_LENGTH] = "";
 
 public:
 	CMap();
@@ -36,6 +37,7 @@ public:
 	void *FindItem(int Type, int Id) override;
 	int NumItems() const override;
 
+	void SetDataCache(const char *pDirectory) override;
 	[[nodiscard]] bool Load(const char *pFullName, IStorage *pStorage, const char *pPath, int StorageType) override;
 	[[nodiscard]] bool Load(IStorage *pStorage, const char *pPath, int StorageType) override;
 	void Unload() override;
@@ -5,166 +5,86 @@
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
-CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
-{
-	if(pAddr->type == NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3]) & 0xFF;
-	else
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3] + pAddr->ip[4] + pAddr->ip[5] + pAddr->ip[6] + pAddr->ip[7] +
-				 pAddr->ip[8] + pAddr->ip[9] + pAddr->ip[10] + pAddr->ip[11] + pAddr->ip[12] + pAddr->ip[13] + pAddr->ip[14] + pAddr->ip[15]) &
-			 0xFF;
-	m_HashIndex = 0;
-}
+#include <limits>
+#include <string_view>
 
-CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
+size_t CNetBan::CNetDataHash::operator()(const NETADDR &Addr) const
 {
-	m_Hash = 0;
-	m_HashIndex = 0;
-	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
-	{
-		m_Hash += pRange->m_LB.ip[i];
-		++m_HashIndex;
-	}
-	m_Hash &= 0xFF;
+	// the bytes compared by NetComp
+	return std::hash<std::string_view>()(std::string_view((const char *)&Addr, Addr.type == NETTYPE_IPV4 ? 8 : 20));
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
+size_t CNetBan::CNetDataHash::operator()(const CNetRange &Range) const
 {
-	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
-	{
-		Sum += pAddr->ip[i - 1];
-		aHash[i].m_Hash = Sum & 0xFF;
-		aHash[i].m_HashIndex = i % Length;
-	}
-	return Length;
+	return (*this)(Range.m_LB) * 31 + (*this)(Range.m_UB);
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::InsertUsed(CBan<T> *pBan)
+template<class T>
+void CNetBan::CBanPool<T>::InsertUsed(CBan<T> *pBan)
 {
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed;; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pBan->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && pBan->m_Info.m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
+	// before all bans that expire at the same time or later
+	const int64_t Expires = pBan->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER ? std::numeric_limits<int64_t>::max() : pBan->m_Info.m_Expires;
+	pBan->m_UsedIterator = m_UsedOrder.emplace_hint(m_UsedOrder.lower_bound(Expires), Expires, pBan);
 
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = nullptr;
-				break;
-			}
-		}
-	}
+	auto Next = std::next(pBan->m_UsedIterator);
+	pBan->m_pNext = Next == m_UsedOrder.end() ? nullptr : Next->second;
+	pBan->m_pPrev = pBan->m_UsedIterator == m_UsedOrder.begin() ? nullptr : std::prev(pBan->m_UsedIterator)->second;
+	if(pBan->m_pNext)
+		pBan->m_pNext->m_pPrev = pBan;
+	if(pBan->m_pPrev)
+		pBan->m_pPrev->m_pNext = pBan;
 	else
-	{
 		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = nullptr;
-	}
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo, const CNetHash *pNetHash)
+template<class T>
+void CNetBan::CBanPool<T>::RemoveUsed(CBan<T> *pBan)
 {
-	if(!m_pFirstFree)
-		return nullptr;
-
-	// create new ban
-	CBan<T> *pBan = m_pFirstFree;
-	pBan->m_Data = *pData;
-	pBan->m_Info = *pInfo;
-	pBan->m_NetHash = *pNetHash;
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
 	if(pBan->m_pPrev)
 		pBan->m_pPrev->m_pNext = pBan->m_pNext;
 	else
-		m_pFirstFree = pBan->m_pNext;
+		m_pFirstUsed = pBan->m_pNext;
+	m_UsedOrder.erase(pBan->m_UsedIterator);
+}
 
-	// add it to the hash list
-	if(m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = nullptr;
-	pBan->m_pHashNext = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Add(const T *pData, const CBanInfo *pInfo)
+{
+	// create new ban
+	std::unique_ptr<CBan<T>> pNewBan = std::make_unique<CBan<T>>();
+	CBan<T> *pBan = pNewBan.get();
+	pBan->m_Data = *pData;
+	pBan->m_Info = *pInfo;
+	m_Bans.emplace(*pData, std::move(pNewBan));
 
 	// insert it into the used list
 	InsertUsed(pBan);
 
-	// update ban count
-	++m_CountUsed;
-
 	return pBan;
 }
 
-template<class T, int HashCount>
-int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanPool<T>::Remove(CBan<T> *pBan)
 {
 	if(pBan == nullptr)
 		return -1;
 
-	// remove from hash list
-	if(pBan->m_pHashNext)
-		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
-	if(pBan->m_pHashPrev)
-		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
-	else
-		m_aapHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
-	pBan->m_pHashNext = pBan->m_pHashPrev = nullptr;
-
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
-
-	// add to recycle list
-	if(m_pFirstFree)
-		m_pFirstFree->m_pPrev = pBan;
-	pBan->m_pPrev = nullptr;
-	pBan->m_pNext = m_pFirstFree;
-	m_pFirstFree = pBan;
-
-	// update ban count
-	--m_CountUsed;
-
+	RemoveUsed(pBan);
+	const T Data = pBan->m_Data;
+	m_Bans.erase(Data);
 	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
+template<class T>
+void CNetBan::CBanPool<T>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
+	RemoveUsed(pBan);
 	pBan->m_Info = *pInfo;
-
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
-
-	// insert it into the used list
 	InsertUsed(pBan);
 }
 
@@ -174,27 +94,16 @@ void CNetBan::UnbanAll()
 	m_BanRangePool.Reset();
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Reset()
+template<class T>
+void CNetBan::CBanPool<T>::Reset()
 {
-	mem_zero(m_aapHashList, sizeof(m_aapHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
+	m_Bans.clear();
+	m_UsedOrder.clear();
 	m_pFirstUsed = nullptr;
-	m_CountUsed = 0;
-
-	for(int i = 1; i < MAX_BANS - 1; ++i)
-	{
-		m_aBans[i].m_pNext = &m_aBans[i + 1];
-		m_aBans[i].m_pPrev = &m_aBans[i - 1];
-	}
-
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS - 1].m_pPrev = &m_aBans[MAX_BANS - 2];
-	m_pFirstFree = &m_aBans[0];
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Get(int Index) const
 {
 	if(Index < 0 || Index >= Num())
 		return nullptr;
@@ -208,6 +117,145 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
 	return nullptr;
 }
 
+static int AddressBit(const unsigned char *pIp, int Bit)
+{
+	return (pIp[Bit / 8] >> (7 - Bit % 8)) & 1;
+}
+
+CNetBan::CBanRangePool::CRangeBounds CNetBan::CBanRangePool::MakeBounds(const CBanRange *pBan)
+{
+	CRangeBounds Bounds;
+	Bounds.m_pBan = const_cast<CBanRange *>(pBan);
+	Bounds.m_Bits = pBan->m_Data.m_LB.type == NETTYPE_IPV4 ? 32 : 128;
+	Bounds.m_LastOneLB = -1;
+	Bounds.m_LastZeroUB = -1;
+	for(int Bit = 0; Bit < Bounds.m_Bits; Bit++)
+	{
+		if(AddressBit(pBan->m_Data.m_LB.ip, Bit))
+			Bounds.m_LastOneLB = Bit;
+		if(!AddressBit(pBan->m_Data.m_UB.ip, Bit))
+			Bounds.m_LastZeroUB = Bit;
+	}
+	return Bounds;
+}
+
+int CNetBan::CBanRangePool::NewNode()
+{
+	int Node;
+	if(m_vFreeNodes.empty())
+	{
+		Node = m_vNodes.size();
+		m_vNodes.emplace_back();
+	}
+	else
+	{
+		Node = m_vFreeNodes.back();
+		m_vFreeNodes.pop_back();
+	}
+	m_vNodes[Node].m_aChildren[0] = -1;
+	m_vNodes[Node].m_aChildren[1] = -1;
+	return Node;
+}
+
+// OnLB and OnUB tell whether the prefix of the node equals the one of the lower
+// and upper bound, the range covers all addresses of the node if the rest of
+// those bounds is all zeros and all ones respectively
+void CNetBan::CBanRangePool::Insert(int Node, int Depth, bool OnLB, bool OnUB, const CRangeBounds &Bounds)
+{
+	if((!OnLB || Bounds.m_LastOneLB < Depth) && (!OnUB || Bounds.m_LastZeroUB < Depth))
+	{
+		m_vNodes[Node].m_vpBans.push_back(Bounds.m_pBan);
+		return;
+	}
+
+	const int BitLB = AddressBit(Bounds.m_pBan->m_Data.m_LB.ip, Depth);
+	const int BitUB = AddressBit(Bounds.m_pBan->m_Data.m_UB.ip, Depth);
+	for(int Bit = 0; Bit < 2; Bit++)
+	{
+		if((OnLB && Bit < BitLB) || (OnUB && Bit > BitUB))
+			continue;
+		if(m_vNodes[Node].m_aChildren[Bit] < 0)
+		{
+			const int Child = NewNode();
+			m_vNodes[Node].m_aChildren[Bit] = Child;
+		}
+		Insert(m_vNodes[Node].m_aChildren[Bit], Depth + 1, OnLB && Bit == BitLB, OnUB && Bit == BitUB, Bounds);
+	}
+}
+
+// returns whether the node is unused afterwards
+bool CNetBan::CBanRangePool::Erase(int Node, int Depth, bool OnLB, bool OnUB, const CRangeBounds &Bounds)
+{
+	CNode &Current = m_vNodes[Node];
+	if((!OnLB || Bounds.m_LastOneLB < Depth) && (!OnUB || Bounds.m_LastZeroUB < Depth))
+	{
+		Current.m_vpBans.erase(std::find(Current.m_vpBans.begin(), Current.m_vpBans.end(), Bounds.m_pBan));
+	}
+	else
+	{
+		const int BitLB = AddressBit(Bounds.m_pBan->m_Data.m_LB.ip, Depth);
+		const int BitUB = AddressBit(Bounds.m_pBan->m_Data.m_UB.ip, Depth);
+		for(int Bit = 0; Bit < 2; Bit++)
+		{
+			if((OnLB && Bit < BitLB) || (OnUB && Bit > BitUB))
+				continue;
+			const int Child = Current.m_aChildren[Bit];
+			if(Erase(Child, Depth + 1, OnLB && Bit == BitLB, OnUB && Bit == BitUB, Bounds))
+			{
+				Current.m_aChildren[Bit] = -1;
+				m_vFreeNodes.push_back(Child);
+			}
+		}
+	}
+	return Current.m_vpBans.empty() && Current.m_aChildren[0] < 0 && Current.m_aChildren[1] < 0;
+}
+
+CNetBan::CBanRange *CNetBan::CBanRangePool::Add(const CNetRange *pData, const CBanInfo *pInfo)
+{
+	CBanRange *pBan = CBanPool<CNetRange>::Add(pData, pInfo);
+	Insert(pData->m_LB.type == NETTYPE_IPV4 ? ROOT_IPV4 : ROOT_IPV6, 0, true, true, MakeBounds(pBan));
+	return pBan;
+}
+
+int CNetBan::CBanRangePool::Remove(CBanRange *pBan)
+{
+	if(pBan == nullptr)
+		return -1;
+
+	// the roots are never freed
+	Erase(pBan->m_Data.m_LB.type == NETTYPE_IPV4 ? ROOT_IPV4 : ROOT_IPV6, 0, true, true, MakeBounds(pBan));
+	return CBanPool<CNetRange>::Remove(pBan);
+}
+
+void CNetBan::CBanRangePool::Reset()
+{
+	CBanPool<CNetRange>::Reset();
+	m_vNodes.clear();
+	m_vFreeNodes.clear();
+	for(int i = 0; i < NUM_ROOTS; i++)
+		NewNode();
+}
+
+const CNetBan::CBanRange *CNetBan::CBanRangePool::FindMatching(const NETADDR *pAddr) const
+{
+	if(m_vNodes.empty())
+		return nullptr;
+
+	const int Bits = pAddr->type == NETTYPE_IPV4 ? 32 : 128;
+	const CBanRange *pMatch = nullptr;
+	int Node = pAddr->type == NETTYPE_IPV4 ? ROOT_IPV4 : ROOT_IPV6;
+	for(int Depth = 0; Node >= 0; Depth++)
+	{
+		const CNode &Current = m_vNodes[Node];
+		if(!Current.m_vpBans.empty())
+			pMatch = Current.m_vpBans.back();
+		if(Depth == Bits)
+			break;
+		Node = Current.m_aChildren[AddressBit(pAddr->ip, Depth)];
+	}
+	return pMatch;
+}
+
 template<class T>
 int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool VerbatimReason)
 {
@@ -227,8 +275,7 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	str_copy(Info.m_aReason, pReason);
 
 	// check if it already exists
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		// adjust the ban
@@ -240,24 +287,17 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	}
 
 	// add ban and print result
-	pBan = pBanPool->Add(pData, &Info, &NetHash);
-	if(pBan)
-	{
-		char aBuf[256];
-		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		return 0;
-	}
-	else
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (full banlist)");
-	return -1;
+	pBan = pBanPool->Add(pData, &Info);
+	char aBuf[256];
+	MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+	return 0;
 }
 
 template<class T>
 int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 {
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		char aBuf[256];
@@ -290,6 +330,7 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("bans", "?i[page]", CFGFLAG_SERVER, ConBans, this, "Show banlist (page 1 by default, 20 entries per page)");
 	Console()->Register("bans_find", "s[ip]", CFGFLAG_SERVER, ConBansFind, this, "Find all ban records for the specified IP address");
 	Console()->Register("bans_save", "s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_load", "s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConBansLoad, this, "Load a banlist saved with bans_save, without listing every ban");
 }
 
 void CNetBan::Update()
@@ -387,11 +428,9 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 		pAddr = &Addr;
 		Addr.type = NETTYPE_IPV6;
 	}
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
 
 	// check ban addresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Find(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -399,16 +438,11 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	}
 
 	// check ban ranges
-	for(int i = Length - 1; i >= 0; --i)
+	const CBanRange *pBanRange = m_BanRangePool.FindMatching(pAddr);
+	if(pBanRange)
 	{
-		for(CBanRange *pBanRange = m_BanRangePool.First(&aHash[i]); pBanRange; pBanRange = pBanRange->m_pHashNext)
-		{
-			if(NetMatch(&pBanRange->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
-			}
-		}
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
 	}
 
 	return false;
@@ -615,3 +649,85 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+int CNetBan::LoadBan(const char *pLine)
+{
+	// same format as written by bans_save
+	char aCommand[16];
+	char aAddrStr1[NETADDR_MAXSTRSIZE];
+	char aAddrStr2[NETADDR_MAXSTRSIZE];
+	char aMinutes[16];
+	pLine = str_next_token(pLine, " ", aCommand, sizeof(aCommand));
+	if(!pLine)
+		return 0;
+	const bool IsRange = str_comp(aCommand, "ban_range") == 0;
+	if(!IsRange && str_comp(aCommand, "ban") != 0)
+		return -1;
+	pLine = str_next_token(pLine, " ", aAddrStr1, sizeof(aAddrStr1));
+	if(pLine && IsRange)
+		pLine = str_next_token(pLine, " ", aAddrStr2, sizeof(aAddrStr2));
+	if(pLine)
+		pLine = str_next_token(pLine, " ", aMinutes, sizeof(aMinutes));
+	int Minutes;
+	if(!pLine || !str_toint(aMinutes, &Minutes))
+		return -1;
+	const char *pReason = str_skip_whitespaces_const(pLine);
+
+	CBanInfo Info = {0};
+	Info.m_Expires = Minutes > 0 ? time_timestamp() + std::min(Minutes, 525600) * 60 : static_cast<int64_t>(CBanInfo::EXPIRES_NEVER);
+	Info.m_VerbatimReason = false;
+	str_copy(Info.m_aReason, pReason[0] ? pReason : "No reason given");
+
+	if(IsRange)
+	{
+		CNetRange Range;
+		if(net_addr_from_str(&Range.m_LB, aAddrStr1) != 0 || net_addr_from_str(&Range.m_UB, aAddrStr2) != 0 || !Range.IsValid() ||
+			NetMatch(&Range, &m_LocalhostIpV4) || NetMatch(&Range, &m_LocalhostIpV6))
+			return -1;
+		if(CBanRange *pBan = m_BanRangePool.Find(&Range))
+			m_BanRangePool.Update(pBan, &Info);
+		else
+			m_BanRangePool.Add(&Range, &Info);
+	}
+	else
+	{
+		NETADDR Addr;
+		if(net_addr_from_str(&Addr, aAddrStr1) != 0 || NetMatch(&Addr, &m_LocalhostIpV4) || NetMatch(&Addr, &m_LocalhostIpV6))
+			return -1;
+		if(CBanAddr *pBan = m_BanAddrPool.Find(&Addr))
+			m_BanAddrPool.Update(pBan, &Info);
+		else
+			m_BanAddrPool.Add(&Addr, &Info);
+	}
+	return 1;
+}
+
+void CNetBan::ConBansLoad(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	char aBuf[256];
+	CLineReader LineReader;
+	if(!LineReader.OpenFile(pThis->Storage()->OpenFile(pResult->GetString(0), IOFLAG_READ, IStorage::TYPE_ALL)))
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to load banlist from '%s'", pResult->GetString(0));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return;
+	}
+
+	int NumLoaded = 0;
+	int NumInvalid = 0;
+	while(const char *pLine = LineReader.Get())
+	{
+		const int Result = pThis->LoadBan(pLine);
+		if(Result > 0)
+			NumLoaded++;
+		else if(Result < 0)
+			NumInvalid++;
+	}
+
+	str_format(aBuf, sizeof(aBuf), "loaded %d bans from '%s', %d invalid entries", NumLoaded, pResult->GetString(0), NumInvalid);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+	if(NumLoaded > 0)
+		pThis->OnBansLoaded();
+}
@@ -8,6 +8,11 @@
 
 #include <engine/console.h>
 
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
 	return mem_comp(pAddr1, pAddr2, pAddr1->type == NETTYPE_IPV4 ? 8 : 20);
@@ -63,17 +68,19 @@ protected:
 		return pBuffer;
 	}
 
-	class CNetHash
+	// equality of NetComp, ports are ignored
+	class CNetDataHash
 	{
 	public:
-		int m_Hash;
-		int m_HashIndex; // matching parts for ranges, 0 for addr
-
-		CNetHash() = default;
-		CNetHash(const NETADDR *pAddr);
-		CNetHash(const CNetRange *pRange);
+		size_t operator()(const NETADDR &Addr) const;
+		size_t operator()(const CNetRange &Range) const;
+	};
 
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
+	class CNetDataEqual
+	{
+	public:
+		bool operator()(const NETADDR &Addr1, const NETADDR &Addr2) const { return NetComp(&Addr1, &Addr2) == 0; }
+		bool operator()(const CNetRange &Range1, const CNetRange &Range2) const { return NetComp(&Range1, &Range2) == 0; }
 	};
 
 	struct CBanInfo
@@ -93,64 +100,95 @@ protected:
 	{
 		T m_Data;
 		CBanInfo m_Info;
-		CNetHash m_NetHash;
 
-		// hash list
-		CBan *m_pHashNext;
-		CBan *m_pHashPrev;
+		// position in the used list
+		typename std::multimap<int64_t, CBan *>::iterator m_UsedIterator;
 
-		// used or free list
+		// used list
 		CBan *m_pNext;
 		CBan *m_pPrev;
 	};
 
-	template<class T, int HashCount>
+	template<class T>
 	class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
-		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
+		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
 
-		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
+		int Num() const { return m_Bans.size(); }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
-		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
+		CBan<CDataType> *Find(const CDataType *pData) const
 		{
-			for(CBan<CDataType> *pBan = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
-			{
-				if(NetComp(&pBan->m_Data, pData) == 0)
-					return pBan;
-			}
-
-			return nullptr;
+			auto It = m_Bans.find(*pData);
+			return It == m_Bans.end() ? nullptr : It->second.get();
 		}
 		CBan<CDataType> *Get(int Index) const;
 
 	private:
-		enum
-		{
-			MAX_BANS = 2048,
-		};
-
-		CBan<CDataType> *m_aapHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
-		CBan<CDataType> *m_pFirstFree;
-		CBan<CDataType> *m_pFirstUsed;
-		int m_CountUsed;
+		std::unordered_map<CDataType, std::unique_ptr<CBan<CDataType>>, CNetDataHash, CNetDataEqual> m_Bans;
+		// bans ordered by expiry, the newest first for the same expiry, which is the order of the used list
+		std::multimap<int64_t, CBan<CDataType> *> m_UsedOrder;
+		CBan<CDataType> *m_pFirstUsed = nullptr;
 
 		void InsertUsed(CBan<CDataType> *pBan);
+		void RemoveUsed(CBan<CDataType> *pBan);
 	};
 
-	typedef CBanPool<NETADDR, 1> CBanAddrPool;
-	typedef CBanPool<CNetRange, 16> CBanRangePool;
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
+	typedef CBanPool<NETADDR> CBanAddrPool;
+
+	// Additionally indexes the ranges in a binary trie per address family.
+	// Each range is stored at the nodes of the prefixes it consists of, so
+	// the bans matching an address are found on the path of its bits.
+	class CBanRangePool : public CBanPool<CNetRange>
+	{
+	public:
+		CBanRange *Add(const CNetRange *pData, const CBanInfo *pInfo);
+		int Remove(CBanRange *pBan);
+		void Reset();
+
+		// the matching range with the longest common prefix
+		const CBanRange *FindMatching(const NETADDR *pAddr) const;
+
+	private:
+		enum
+		{
+			ROOT_IPV4 = 0,
+			ROOT_IPV6,
+			NUM_ROOTS,
+		};
+
+		class CNode
+		{
+		public:
+			int m_aChildren[2];
+			std::vector<CBanRange *> m_vpBans;
+		};
+		std::vector<CNode> m_vNodes;
+		std::vector<int> m_vFreeNodes;
+
+		class CRangeBounds
+		{
+		public:
+			CBanRange *m_pBan;
+			int m_Bits;
+			// last set bit of the lower bound, last unset bit of the upper bound
+			int m_LastOneLB;
+			int m_LastZeroUB;
+		};
+
+		int NewNode();
+		void Insert(int Node, int Depth, bool OnLB, bool OnUB, const CRangeBounds &Bounds);
+		bool Erase(int Node, int Depth, bool OnLB, bool OnUB, const CRangeBounds &Bounds);
+		static CRangeBounds MakeBounds(const CBanRange *pBan);
+	};
 
 	template<class T>
 	void MakeBanInfo(const CBan<T> *pBan, char *pBuf, unsigned BuffSize, int Type) const;
@@ -158,6 +196,9 @@ protected:
 	int Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool VerbatimReason);
 	template<class T>
 	int Unban(T *pBanPool, const typename T::CDataType *pData);
+	int LoadBan(const char *pLine);
+	// called after bans_load added bans, which bypasses BanAddr and BanRange
+	virtual void OnBansLoaded() {}
 
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
@@ -196,6 +237,7 @@ public:
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansFind(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansLoad(class IConsole::IResult *pResult, void *pUser);
 };
 
 template<class T>
@@ -229,6 +229,17 @@ public:
 	CONNECTIVITY GetConnectivity(int NetType, NETADDR *pGlobalAddr);
 };
 
+class CNetConnectionStats
+{
+public:
+	uint64_t m_SentPackets = 0;
+	uint64_t m_RecvPackets = 0;
+	// vital chunks that were sent again, because they were not acked in time or the peer asked for them
+	uint64_t m_ResentChunks = 0;
+	// vital chunks that arrived out of sequence, each one asks the peer for a resend
+	uint64_t m_ResendRequests = 0;
+};
+
 class CNetConnection
 {
 	// TODO: is this needed because this needs to be aware of
@@ -274,7 +285,7 @@ private:
 	int m_NumConnectAddrs;
 	NETADDR m_PeerAddr;
 	NETSOCKET m_Socket;
-	NETSTATS m_Stats;
+	CNetConnectionStats m_Stats;
 
 	std::array<char, NETADDR_MAXSTRSIZE> m_aPeerAddrStr;
 	std::array<char, NETADDR_MAXSTRSIZE> m_aPeerAddrStrNoPort;
@@ -320,6 +331,7 @@ public:
 	const char *ErrorString();
 	void SignalResend();
 	EState State() const { return m_State; }
+	const CNetConnectionStats &Stats() const { return m_Stats; }
 	const NETADDR *PeerAddress() const { return &m_PeerAddr; }
 	const std::array<char, NETADDR_MAXSTRSIZE> &PeerAddressString(bool IncludePort) const
 	{
@@ -507,6 +519,12 @@ public:
 	void BeginFlushBatch() { m_FlushBatch = true; }
 	void EndFlushBatch();
 
+	// While a send batch is open, the packets sent over the server socket
+	// are queued and submitted with as few system calls as possible, see
+	// `net_udp_send_batch_begin`. EndSendBatch() sends the queued packets.
+	void BeginSendBatch() { net_udp_send_batch_begin(m_Socket); }
+	void EndSendBatch() { net_udp_send_batch_end(m_Socket); }
+
 	//
 	void Drop(int ClientId, const char *pReason);
 
@@ -646,6 +664,7 @@ public:
 	void ConnectAddresses(const NETADDR **ppAddrs, int *pNumAddrs) const { m_Connection.ConnectAddresses(ppAddrs, pNumAddrs); }
 	bool GotProblems(int64_t MaxLatency) const;
 	const char *ErrorString() const;
+	const CNetConnectionStats &Stats() const { return m_Connection.Stats(); }
 
 	// stun
 	void FeedStunServer(NETADDR StunServer);
@@ -118,6 +118,7 @@ void CNetConnection::AckChunks(int Ack)
 
 void CNetConnection::SignalResend()
 {
+	m_Stats.m_ResendRequests++;
 	m_Construct.m_Flags |= NET_PACKETFLAG_RESEND;
 }
 
@@ -134,6 +135,7 @@ int CNetConnection::Flush()
 	// send of the packets
 	m_Construct.m_Ack = m_Ack;
 	CNetBase::SendPacket(m_Socket, &m_PeerAddr, &m_Construct, m_SecurityToken, m_Sixup);
+	m_Stats.m_SentPackets++;
 
 	// update send times
 	m_LastSendTime = time_get();
@@ -225,6 +227,7 @@ void CNetConnection::ResendChunk(CNetChunkResend *pResend)
 {
 	QueueChunkEx(pResend->m_Flags | NET_CHUNKFLAG_RESEND, pResend->m_DataSize, pResend->m_pData, pResend->m_Sequence);
 	pResend->m_LastSendTime = time_get();
+	m_Stats.m_ResentChunks++;
 }
 
 void CNetConnection::Resend()
@@ -501,6 +504,7 @@ int CNetConnection::Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr, SECURITY_
 		AckChunks(pPacket->m_Ack);
 	}
 
+	m_Stats.m_RecvPackets++;
 	return 1;
 }
 
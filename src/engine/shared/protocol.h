@@ -105,6 +105,13 @@ enum
 	 */
 	MAX_INPUT_SIZE = 128,
 	MAX_SNAPSHOT_PACKSIZE = 900,
+	/**
+	 * The maximum number of map chunks a client may request at once, see
+	 * `SERVERCAPFLAG_MAPDOWNLOADWINDOW`.
+	 *
+	 * The chunks in flight have to fit into the resend buffer of the connection.
+	 */
+	MAX_MAP_DOWNLOAD_WINDOW = 24,
 
 	MAX_NAME_LENGTH = 16,
 	MAX_CLAN_LENGTH = 12,
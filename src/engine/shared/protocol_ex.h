@@ -29,13 +29,14 @@ enum
 
 enum
 {
-	SERVERCAP_CURVERSION = 5,
+	SERVERCAP_CURVERSION = 6,
 	SERVERCAPFLAG_DDNET = 1 << 0,
 	SERVERCAPFLAG_CHATTIMEOUTCODE = 1 << 1,
 	SERVERCAPFLAG_ANYPLAYERFLAG = 1 << 2,
 	SERVERCAPFLAG_PINGEX = 1 << 3,
 	SERVERCAPFLAG_ALLOWDUMMY = 1 << 4,
 	SERVERCAPFLAG_SYNCWEAPONINPUT = 1 << 5,
+	SERVERCAPFLAG_MAPDOWNLOADWINDOW = 1 << 6,
 };
 
 void RegisterUuids(CUuidManager *pManager);
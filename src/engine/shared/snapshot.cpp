@@ -14,8 +14,10 @@
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
+#include <new>
 
 // CSnapshot
 
@@ -631,68 +633,128 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshotBuffer *pTo, co
 
 // CSnapshotStorage
 
+bool CSnapshotStorage::CBuffer::Contains(const void *pPtr) const
+{
+	const char *pChar = static_cast<const char *>(pPtr);
+	return m_pData && pChar >= m_pData.get() && pChar < m_pData.get() + m_Size;
+}
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	m_Tail = 0;
+	m_vRetiredBuffers.clear();
 }
 
 void CSnapshotStorage::PurgeAll()
 {
-	while(m_pFirst)
-	{
-		CHolder *pNext = m_pFirst->m_pNext;
-		free(m_pFirst->m_pSnap);
-		free(m_pFirst->m_pAltSnap);
-		free(m_pFirst);
-		m_pFirst = pNext;
-	}
+	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	OnPurge();
 }
 
 void CSnapshotStorage::PurgeUntil(int Tick)
 {
-	CHolder *pHolder = m_pFirst;
+	while(m_pFirst && m_pFirst->m_Tick < Tick)
+		m_pFirst = m_pFirst->m_pNext;
 
-	while(pHolder)
-	{
-		CHolder *pNext = pHolder->m_pNext;
-		if(pHolder->m_Tick >= Tick)
-			return; // no more to remove
-		free(pHolder->m_pSnap);
-		free(pHolder->m_pAltSnap);
-		free(pHolder);
+	if(m_pFirst)
+		m_pFirst->m_pPrev = nullptr;
+	else
+		m_pLast = nullptr;
+	OnPurge();
+}
 
-		// did we come to the end of the list?
-		if(!pNext)
-			break;
+void CSnapshotStorage::OnPurge()
+{
+	// retired buffers only contain snapshots older than the current buffer
+	while(!m_vRetiredBuffers.empty() && !(m_pFirst && m_vRetiredBuffers.front().Contains(m_pFirst)))
+		m_vRetiredBuffers.erase(m_vRetiredBuffers.begin());
+	if(!m_pFirst)
+		m_Tail = 0;
+}
 
-		m_pFirst = pNext;
-		pNext->m_pPrev = nullptr;
-		pHolder = pNext;
+void *CSnapshotStorage::Allocate(size_t Size)
+{
+	if(m_Buffer.m_pData)
+	{
+		char *pData = m_Buffer.m_pData.get();
+		if(!m_pFirst || !m_Buffer.Contains(m_pFirst))
+		{
+			// only [0, m_Tail) is in use
+			if(m_Tail + Size <= m_Buffer.m_Size)
+			{
+				m_Tail += Size;
+				return pData + m_Tail - Size;
+			}
+		}
+		else
+		{
+			const size_t Head = (char *)m_pFirst - pData;
+			if(m_Tail > Head)
+			{
+				// [Head, m_Tail) is in use, continue at the end or wrap around
+				if(m_Tail + Size <= m_Buffer.m_Size)
+				{
+					m_Tail += Size;
+					return pData + m_Tail - Size;
+				}
+				if(Size <= Head)
+				{
+					m_Tail = Size;
+					return pData;
+				}
+			}
+			else if(m_Tail + Size <= Head)
+			{
+				// wrapped around, [Head, end) and [0, m_Tail) are in use
+				m_Tail += Size;
+				return pData + m_Tail - Size;
+			}
+		}
 	}
 
-	// no more snapshots in storage
-	m_pFirst = nullptr;
-	m_pLast = nullptr;
+	// the buffer is full, keep it until its snapshots are purged
+	size_t NewSize = std::max<size_t>(m_Buffer.m_Size * 2, MIN_BUFFER_SIZE);
+	while(NewSize < Size)
+		NewSize *= 2;
+	if(m_pFirst)
+		m_vRetiredBuffers.push_back(std::move(m_Buffer));
+	m_Buffer.m_pData = std::make_unique<char[]>(NewSize);
+	m_Buffer.m_Size = NewSize;
+	m_NumAllocations++;
+	m_Tail = Size;
+	return m_Buffer.m_pData.get();
+}
+
+static size_t AlignSize(size_t Size)
+{
+	return (Size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
 }
 
 void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData)
 {
 	dbg_assert(DataSize <= (size_t)CSnapshot::MAX_SIZE, "Snapshot data size invalid");
 	dbg_assert(AltDataSize <= (size_t)CSnapshot::MAX_SIZE, "Alt snapshot data size invalid");
+	dbg_assert(!m_pLast || m_pLast->m_Tick < Tick, "snapshots inserted into CSnapshotStorage with non-increasing tick %d >= %d", m_pLast ? m_pLast->m_Tick : 0, Tick);
+
+	// the holder is followed by the snapshot and the alternative snapshot
+	const size_t HolderSize = AlignSize(sizeof(CHolder));
+	const size_t SnapSize = AlignSize(DataSize);
+	char *pEntry = static_cast<char *>(Allocate(HolderSize + SnapSize + AlignSize(AltDataSize)));
 
-	CHolder *pHolder = static_cast<CHolder *>(malloc(sizeof(CHolder)));
+	CHolder *pHolder = new(pEntry) CHolder;
 	pHolder->m_Tick = Tick;
 	pHolder->m_Tagtime = Tagtime;
 
-	pHolder->m_pSnap = static_cast<CSnapshot *>(malloc(DataSize));
+	pHolder->m_pSnap = reinterpret_cast<CSnapshot *>(pEntry + HolderSize);
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
 	pHolder->m_SnapSize = DataSize;
 
 	if(AltDataSize) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = static_cast<CSnapshot *>(malloc(AltDataSize));
+		pHolder->m_pAltSnap = reinterpret_cast<CSnapshot *>(pEntry + HolderSize + SnapSize);
 		mem_copy(pHolder->m_pAltSnap, pAltData, AltDataSize);
 		pHolder->m_AltSnapSize = AltDataSize;
 	}
@@ -706,14 +768,9 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	pHolder->m_pNext = nullptr;
 	pHolder->m_pPrev = m_pLast;
 	if(m_pLast)
-	{
-		dbg_assert(m_pLast->m_Tick < Tick, "snapshots inserted into CSnapshotStorage with non-increasing tick %d >= %d", m_pLast->m_Tick, Tick);
 		m_pLast->m_pNext = pHolder;
-	}
 	else
-	{
 		m_pFirst = pHolder;
-	}
 	m_pLast = pHolder;
 }
 
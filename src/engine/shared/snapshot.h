@@ -5,7 +5,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <vector>
 
 // CSnapshot
 
@@ -143,12 +145,41 @@ public:
 	CHolder *m_pLast;
 
 	CSnapshotStorage() { Init(); }
-	~CSnapshotStorage() { PurgeAll(); }
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData);
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
+
+	// number of buffers allocated by this storage so far
+	int64_t NumAllocations() const { return m_NumAllocations; }
+
+private:
+	class CBuffer
+	{
+	public:
+		std::unique_ptr<char[]> m_pData;
+		size_t m_Size = 0;
+
+		bool Contains(const void *pPtr) const;
+	};
+
+	enum
+	{
+		MIN_BUFFER_SIZE = 64 * 1024,
+	};
+
+	// Snapshots are added in increasing tick order and purged oldest first,
+	// so their holders and data are stored in a ring buffer. The buffer grows
+	// until it holds all snapshots that are kept at the same time, the old
+	// buffers are freed once their snapshots have been purged.
+	CBuffer m_Buffer;
+	size_t m_Tail;
+	std::vector<CBuffer> m_vRetiredBuffers;
+	int64_t m_NumAllocations = 0;
+
+	void *Allocate(size_t Size);
+	void OnPurge();
 };
 
 class CSnapshotBuilder
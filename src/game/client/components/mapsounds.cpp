@@ -1,8 +1,10 @@
 #include "mapsounds.h"
 
 #include <base/log.h>
+#include <base/time.h>
 
 #include <engine/demo.h>
+#include <engine/shared/config.h>
 #include <engine/sound.h>
 
 #include <game/client/components/camera.h>
@@ -49,6 +51,7 @@ void CMapSounds::OnMapLoad()
 	m_Count = std::clamp<int>(m_Count, 0, MAX_MAPSOUNDS);
 
 	// load new samples
+	const int64_t LoadStartTime = time_get_impl();
 	bool ShowWarning = false;
 	for(int i = 0; i < m_Count; i++)
 	{
@@ -87,6 +90,8 @@ void CMapSounds::OnMapLoad()
 		}
 		ShowWarning = ShowWarning || m_aSounds[i] == -1;
 	}
+	if(g_Config.m_Debug)
+		log_trace("mapsounds", "Loaded %d map sounds in %.2fms", m_Count, (time_get_impl() - LoadStartTime) * 1000.0 / time_freq());
 	if(ShowWarning)
 	{
 		Client()->AddWarning(SWarning(Localize("Some map sounds could not be loaded. Check the local console for details.")));
@@ -22,6 +22,7 @@
 #include <engine/keys.h>
 #include <engine/serverbrowser.h>
 #include <engine/shared/config.h>
+#include <engine/shared/demo.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
@@ -1531,7 +1532,16 @@ void CMenus::RenderPopupFullscreen(CUIRect Screen)
 			{
 				str_copy(m_aCurrentDemoSelectionName, m_DemoRenameInput.GetString());
 				if(!m_vpFilteredDemos[m_DemolistSelectedIndex]->m_IsDir)
+				{
 					fs_split_file_extension(m_DemoRenameInput.GetString(), m_aCurrentDemoSelectionName, sizeof(m_aCurrentDemoSelectionName));
+					// the keyframe index belongs to the demo
+					char aIndexOld[IO_MAX_PATH_LENGTH];
+					char aIndexNew[IO_MAX_PATH_LENGTH];
+					CDemoPlayer::IndexFilename(aBufOld, aIndexOld, sizeof(aIndexOld));
+					CDemoPlayer::IndexFilename(aBufNew, aIndexNew, sizeof(aIndexNew));
+					if(Storage()->FileExists(aIndexOld, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
+						Storage()->RenameFile(aIndexOld, aIndexNew, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType);
+				}
 				DemolistPopulate();
 				DemolistOnUpdate(false);
 			}
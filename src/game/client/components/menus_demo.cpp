@@ -16,6 +16,7 @@
 #include <engine/font_icons.h>
 #include <engine/graphics.h>
 #include <engine/keys.h>
+#include <engine/shared/demo.h>
 #include <engine/shared/localization.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
@@ -1727,6 +1728,11 @@ void CMenus::PopupConfirmDeleteDemo()
 	str_format(aBuf, sizeof(aBuf), "%s/%s", m_aCurrentDemoFolder, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_aFilename);
 	if(Storage()->RemoveFile(aBuf, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
 	{
+		// the keyframe index belongs to the demo
+		char aIndexFilename[IO_MAX_PATH_LENGTH];
+		CDemoPlayer::IndexFilename(aBuf, aIndexFilename, sizeof(aIndexFilename));
+		if(Storage()->FileExists(aIndexFilename, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
+			Storage()->RemoveFile(aIndexFilename, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType);
 		DemolistPopulate();
 		DemolistOnUpdate(false);
 	}
@@ -14,6 +14,7 @@
 #include <game/layers.h>
 #include <game/mapitems.h>
 
+#include <algorithm>
 #include <cmath>
 
 vec2 ClampVel(int MoveRestriction, vec2 Vel)
@@ -322,30 +323,175 @@ int CCollision::GetTile(int x, int y) const
 	return 0;
 }
 
-// TODO: rewrite this smarter!
+// Walks the samples `mix(Pos0, Pos1, i / Divisor)` for `i` in `[0, NumSamples)`
+// that the line checks test, but only stops at the first sample of every run
+// of consecutive samples that lie in the same tiles. The tile coordinates of
+// the samples are monotonic along the line, so the end of a run is predicted
+// from the next tile border the line crosses (Amanatides-Woo) and then fixed
+// up by evaluating the samples around it exactly. Since every check only
+// depends on the tiles of a sample, callers get the same results as if they
+// tested every sample.
+class CLineTileWalker
+{
+public:
+	enum class ERounding
+	{
+		ROUND, // `round_to_int`, used by the collision checks
+		TRUNCATE, // `(int)`, used by the map index lookups
+	};
+
+	CLineTileWalker(vec2 Pos0, vec2 Pos1, float Divisor, int NumSamples, int Width, int Height, ERounding Rounding, int OffsetX = 0, int OffsetY = 0) :
+		m_Pos0(Pos0), m_Pos1(Pos1), m_Divisor(Divisor), m_NumSamples(NumSamples), m_Rounding(Rounding)
+	{
+		m_aMaxTile[0] = Width - 1;
+		m_aMaxTile[1] = Height - 1;
+		m_aOffset[0] = OffsetX;
+		m_aOffset[1] = OffsetY;
+		for(int Axis = 0; Axis < 2; Axis++)
+		{
+			const float Delta = m_Pos1[Axis] - m_Pos0[Axis];
+			m_aSamplesPerUnit[Axis] = Delta != 0.0f ? m_Divisor / Delta : 0.0f;
+		}
+		if(m_NumSamples > 0)
+			Evaluate(0, &m_Current);
+	}
+
+	bool Done() const { return m_Index >= m_NumSamples; }
+	vec2 Pos() const { return m_Current.m_Pos; }
+	vec2 PrevPos() const { return m_Index == 0 ? m_Pos0 : SamplePos(m_Index - 1); }
+	int X() const { return m_Current.m_aPixel[0]; }
+	int Y() const { return m_Current.m_aPixel[1]; }
+	int TileX() const { return m_Current.m_aTile[0]; }
+	int TileY() const { return m_Current.m_aTile[1]; }
+
+	void Next()
+	{
+		const int Start = m_Index;
+		int End = PredictRunEnd();
+		CSample EndSample;
+		if(End < m_NumSamples)
+			Evaluate(End, &EndSample);
+		if(End < m_NumSamples && SameTiles(EndSample))
+		{
+			// prediction fell short of the tile border
+			do
+			{
+				End++;
+				if(End < m_NumSamples)
+					Evaluate(End, &EndSample);
+			} while(End < m_NumSamples && SameTiles(EndSample));
+		}
+		else
+		{
+			// prediction is at or past the tile border
+			CSample Prev;
+			while(End - 1 > Start)
+			{
+				Evaluate(End - 1, &Prev);
+				if(SameTiles(Prev))
+					break;
+				End--;
+				EndSample = Prev;
+			}
+		}
+		m_Index = End;
+		if(End < m_NumSamples)
+			m_Current = EndSample;
+	}
+
+private:
+	struct CSample
+	{
+		vec2 m_Pos;
+		int m_aPixel[2];
+		// x, y, then x and y of the pixel shifted by the offset
+		int m_aTile[4];
+	};
+
+	vec2 m_Pos0;
+	vec2 m_Pos1;
+	float m_Divisor;
+	int m_NumSamples;
+	ERounding m_Rounding;
+	int m_aMaxTile[2];
+	int m_aOffset[2];
+	// signed number of samples per unit along each axis, 0 if the line
+	// doesn't move along it
+	float m_aSamplesPerUnit[2];
+
+	int m_Index = 0;
+	CSample m_Current;
+
+	vec2 SamplePos(int Index) const
+	{
+		return mix(m_Pos0, m_Pos1, Index / m_Divisor);
+	}
+
+	void Evaluate(int Index, CSample *pSample) const
+	{
+		pSample->m_Pos = SamplePos(Index);
+		for(int Axis = 0; Axis < 2; Axis++)
+		{
+			const float Coord = pSample->m_Pos[Axis];
+			const int Pixel = m_Rounding == ERounding::ROUND ? round_to_int(Coord) : round_truncate(Coord);
+			pSample->m_aPixel[Axis] = Pixel;
+			pSample->m_aTile[Axis] = std::clamp(Pixel / 32, 0, m_aMaxTile[Axis]);
+			pSample->m_aTile[Axis + 2] = std::clamp((Pixel + m_aOffset[Axis]) / 32, 0, m_aMaxTile[Axis]);
+		}
+	}
+
+	bool SameTiles(const CSample &Sample) const
+	{
+		return std::equal(std::begin(Sample.m_aTile), std::end(Sample.m_aTile), std::begin(m_Current.m_aTile));
+	}
+
+	// Estimates the index of the first sample past the next tile border,
+	// always in `[m_Index + 1, m_NumSamples]`.
+	int PredictRunEnd() const
+	{
+		const float Bias = m_Rounding == ERounding::ROUND ? 0.5f : 0.0f;
+		const int NumKeys = m_aOffset[0] || m_aOffset[1] ? 4 : 2;
+		float Best = m_NumSamples;
+		for(int Key = 0; Key < NumKeys; Key++)
+		{
+			const int Axis = Key % 2;
+			const int Offset = Key < 2 ? 0 : m_aOffset[Axis];
+			const int Tile = m_Current.m_aTile[Key];
+			float Border;
+			if(m_aSamplesPerUnit[Axis] > 0.0f && Tile < m_aMaxTile[Axis])
+				Border = 32 * (Tile + 1) - Offset - Bias;
+			else if(m_aSamplesPerUnit[Axis] < 0.0f && Tile > 0)
+				Border = 32 * Tile - Offset - Bias;
+			else
+				continue;
+			Best = std::min(Best, (Border - m_Pos0[Axis]) * m_aSamplesPerUnit[Axis]);
+		}
+		if(!(Best < m_NumSamples))
+			return m_NumSamples;
+		if(!(Best > m_Index))
+			return m_Index + 1;
+		return std::max(m_Index + 1, (int)std::ceil(Best));
+	}
+};
+
 int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	CLineTileWalker Walker(Pos0, Pos1, End, End + 1, m_Width, m_Height, CLineTileWalker::ERounding::ROUND);
+	for(; !Walker.Done(); Walker.Next())
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
+		int ix = Walker.X();
+		int iy = Walker.Y();
 
 		if(CheckPoint(ix, iy))
 		{
 			if(pOutCollision)
-				*pOutCollision = Pos;
+				*pOutCollision = Walker.Pos();
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			return GetCollisionAt(ix, iy);
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -358,18 +504,15 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
-	for(int i = 0; i <= End; i++)
+	CLineTileWalker Walker(Pos0, Pos1, End, End + 1, m_Width, m_Height, CLineTileWalker::ERounding::ROUND, dx, dy);
+	for(; !Walker.Done(); Walker.Next())
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
+		int ix = Walker.X();
+		int iy = Walker.Y();
 
-		int Index = GetPureMapIndex(Pos);
+		int Index = GetPureMapIndex(Walker.Pos());
 		if(pTeleNr)
 		{
 			if(g_Config.m_SvOldTeleportHook)
@@ -380,9 +523,9 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 		if(pTeleNr && *pTeleNr)
 		{
 			if(pOutCollision)
-				*pOutCollision = Pos;
+				*pOutCollision = Walker.Pos();
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			return TILE_TELEINHOOK;
 		}
 
@@ -399,13 +542,11 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 		if(Hit)
 		{
 			if(pOutCollision)
-				*pOutCollision = Pos;
+				*pOutCollision = Walker.Pos();
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			return Hit;
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -418,16 +559,13 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	CLineTileWalker Walker(Pos0, Pos1, End, End + 1, m_Width, m_Height, CLineTileWalker::ERounding::ROUND);
+	for(; !Walker.Done(); Walker.Next())
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
+		int ix = Walker.X();
+		int iy = Walker.Y();
 
-		int Index = GetPureMapIndex(Pos);
+		int Index = GetPureMapIndex(Walker.Pos());
 		if(pTeleNr)
 		{
 			if(g_Config.m_SvOldTeleportWeapons)
@@ -438,22 +576,20 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 		if(pTeleNr && *pTeleNr)
 		{
 			if(pOutCollision)
-				*pOutCollision = Pos;
+				*pOutCollision = Walker.Pos();
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			return TILE_TELEINWEAPON;
 		}
 
 		if(CheckPoint(ix, iy))
 		{
 			if(pOutCollision)
-				*pOutCollision = Pos;
+				*pOutCollision = Walker.Pos();
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			return GetCollisionAt(ix, iy);
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -940,13 +1076,10 @@ std::vector<int> CCollision::GetMapIndices(vec2 PrevPos, vec2 Pos, unsigned MaxI
 	else
 	{
 		int LastIndex = 0;
-		for(int i = 0; i < End; i++)
+		CLineTileWalker Walker(PrevPos, Pos, d, End, m_Width, m_Height, CLineTileWalker::ERounding::TRUNCATE);
+		for(; !Walker.Done(); Walker.Next())
 		{
-			float a = i / d;
-			vec2 Tmp = mix(PrevPos, Pos, a);
-			int Nx = std::clamp((int)Tmp.x / 32, 0, m_Width - 1);
-			int Ny = std::clamp((int)Tmp.y / 32, 0, m_Height - 1);
-			int Index = Ny * m_Width + Nx;
+			int Index = Walker.TileY() * m_Width + Walker.TileX();
 			if(TileExists(Index) && LastIndex != Index)
 			{
 				if(MaxIndices && vIndices.size() > MaxIndices)
@@ -1147,27 +1280,25 @@ void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY)
 int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	CLineTileWalker Walker(Pos0, Pos1, Distance, DistanceRounded, m_Width, m_Height, CLineTileWalker::ERounding::ROUND);
+	for(; !Walker.Done(); Walker.Next())
 	{
-		float a = i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, m_Width - 1);
-		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, m_Height - 1);
+		vec2 Pos = Walker.Pos();
+		int Nx = Walker.TileX();
+		int Ny = Walker.TileY();
 		if(GetIndex(Nx, Ny) == TILE_SOLID || GetIndex(Nx, Ny) == TILE_NOHOOK || GetIndex(Nx, Ny) == TILE_NOLASER || GetFrontIndex(Nx, Ny) == TILE_NOLASER)
 		{
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Walker.PrevPos();
 			if(GetFrontIndex(Nx, Ny) == TILE_NOLASER)
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 			else
 				return GetCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -11,6 +11,7 @@
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <limits>
 
 const char *CTuningParams::ms_apNames[] =
@@ -351,9 +352,13 @@ void CCharacterCore::Tick(bool UseInput, bool DoDeferredTick)
 		// Check against other players first
 		if(!m_HookHitDisabled && m_pWorld && m_Tuning.m_PlayerHooking && (m_HookState == HOOK_FLYING || !m_NewHook))
 		{
+			// players further away than the hit radius from the hook segment can't be hit
+			int aIds[MAX_CLIENTS];
+			const int NumIds = m_pWorld->CharactersInBox(m_HookPos, NewPos, PhysicalSize() + 2.0f + 1.0f, aIds);
 			float Distance = 0.0f;
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int j = 0; j < NumIds; j++)
 			{
+				const int i = aIds[j];
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
@@ -466,8 +471,12 @@ void CCharacterCore::TickDeferred()
 {
 	if(m_pWorld)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		// only close players collide, the hooked one is pulled from anywhere
+		int aIds[MAX_CLIENTS];
+		const int NumIds = m_pWorld->CharactersInBox(m_Pos, m_Pos, PhysicalSize() * 1.25f + 1.0f, aIds, m_HookedPlayer);
+		for(int j = 0; j < NumIds; j++)
 		{
+			const int i = aIds[j];
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 			if(!pCharCore)
 				continue;
@@ -575,14 +584,18 @@ void CCharacterCore::Move()
 		float Distance = distance(m_Pos, NewPos);
 		if(Distance > 0)
 		{
+			// the players that can be touched anywhere along the way
+			int aIds[MAX_CLIENTS];
+			const int NumIds = m_pWorld->CharactersInBox(m_Pos, NewPos, PhysicalSize() + 1.0f, aIds);
 			int End = Distance + 1;
 			vec2 LastPos = m_Pos;
-			for(int i = 0; i < End; i++)
+			for(int i = 0; i < End && NumIds > 0; i++)
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int j = 0; j < NumIds; j++)
 				{
+					const int p = aIds[j];
 					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
 					if(!pCharCore || pCharCore == this)
 						continue;
@@ -746,6 +759,23 @@ bool CCharacterCore::IsSwitchActiveCb(unsigned char Number, void *pUser)
 	return false;
 }
 
+int CWorldCore::CharactersInBox(vec2 From, vec2 To, float Margin, int *pIds, int Include) const
+{
+	const vec2 Min = vec2(std::min(From.x, To.x) - Margin, std::min(From.y, To.y) - Margin);
+	const vec2 Max = vec2(std::max(From.x, To.x) + Margin, std::max(From.y, To.y) + Margin);
+	int NumIds = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CCharacterCore *pCharCore = m_apCharacters[i];
+		if(!pCharCore)
+			continue;
+		const vec2 Pos = pCharCore->m_Pos;
+		if(m_NoBroadphase || i == Include || (Pos.x >= Min.x && Pos.x <= Max.x && Pos.y >= Min.y && Pos.y <= Max.y))
+			pIds[NumIds++] = i;
+	}
+	return NumIds;
+}
+
 void CWorldCore::InitSwitchers(int HighestSwitchNumber)
 {
 	if(HighestSwitchNumber > 0)
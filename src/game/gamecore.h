@@ -172,6 +172,15 @@ public:
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
 	CPrng *m_pPrng;
 
+	// Broadphase for the character interactions in `CCharacterCore`: writes
+	// the ids of the characters whose position lies in the box spanned by
+	// `From` and `To` grown by `Margin` to `pIds`, in ascending order, and
+	// returns their number. `Include` is added regardless of its position.
+	int CharactersInBox(vec2 From, vec2 To, float Margin, int *pIds, int Include = -1) const;
+	// return all characters from `CharactersInBox`, for comparing the physics
+	// against the exhaustive search in tests
+	bool m_NoBroadphase = false;
+
 	void InitSwitchers(int HighestSwitchNumber);
 	std::vector<SSwitchers> m_vSwitchers;
 };
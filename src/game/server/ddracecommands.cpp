@@ -13,6 +13,7 @@
 #include <game/server/gamemodes/ddnet.h>
 #include <game/server/player.h>
 #include <game/server/save.h>
+#include <game/server/scoreworker.h>
 #include <game/server/teams.h>
 
 void CGameContext::ConGoLeft(IConsole::IResult *pResult, void *pUserData)
@@ -419,7 +420,7 @@ void CGameContext::ModifyWeapons(IConsole::IResult *pResult, void *pUserData,
 void CGameContext::Teleport(CCharacter *pChr, vec2 Pos)
 {
 	pChr->SetPosition(Pos);
-	pChr->m_Pos = Pos;
+	pChr->SetPos(Pos);
 	pChr->m_PrevPos = Pos;
 	pChr->m_DDRaceState = ERaceState::CHEATED;
 }
@@ -638,6 +639,18 @@ void CGameContext::ConAntibot(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Antibot()->ConsoleCommand(pResult->GetString(0));
 }
 
+void CGameContext::ConScoreCacheStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	CScoreResultCache &Cache = CScoreWorker::ResultCache();
+	const uint64_t Hits = Cache.NumHits();
+	const uint64_t Misses = Cache.NumMisses();
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "hits=%" PRIu64 " misses=%" PRIu64 " hit_rate=%.1f%% entries=%d ttl=%ds",
+		Hits, Misses, Hits + Misses > 0 ? 100.0 * Hits / (Hits + Misses) : 0.0, Cache.NumEntries(), g_Config.m_SvSqlCacheTtl);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "score", aBuf);
+}
+
 void CGameContext::ConDumpLog(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
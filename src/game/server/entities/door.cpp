@@ -81,3 +81,10 @@ void CDoor::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId().value(),
 		m_Pos, From, StartTick, -1, LASERTYPE_DOOR, 0, m_Number);
 }
+
+bool CDoor::GetSnapBounds(vec2 &Min, vec2 &Max)
+{
+	Min = vec2(std::min(m_Pos.x, m_To.x), std::min(m_Pos.y, m_To.y));
+	Max = vec2(std::max(m_Pos.x, m_To.x), std::max(m_Pos.y, m_To.y));
+	return true;
+}
@@ -39,7 +39,7 @@ void CDragger::Tick()
 	{
 		m_EvalTick = Server()->Tick();
 		GameServer()->Collision()->MoverSpeed(m_Pos.x, m_Pos.y, &m_Core);
-		m_Pos += m_Core;
+		SetPos(m_Pos + m_Core);
 
 		// Adopt the new position for all outgoing laser beams
 		for(auto &DraggerBeam : m_apDraggerBeam)
@@ -234,6 +234,13 @@ void CDragger::Snap(int SnappingClient)
 		m_Pos, m_Pos, StartTick, -1, LASERTYPE_DRAGGER, Subtype, m_Number);
 }
 
+bool CDragger::GetSnapBounds(vec2 &Min, vec2 &Max)
+{
+	Min = m_Pos;
+	Max = m_Pos;
+	return true;
+}
+
 void CDragger::SwapClients(int Client1, int Client2)
 {
 	std::swap(m_apDraggerBeam[Client1], m_apDraggerBeam[Client2]);
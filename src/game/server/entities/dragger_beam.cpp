@@ -75,11 +75,6 @@ void CDraggerBeam::Tick()
 	}
 }
 
-void CDraggerBeam::SetPos(vec2 Pos)
-{
-	m_Pos = Pos;
-}
-
 void CDraggerBeam::Reset()
 {
 	m_MarkedForDestroy = true;
@@ -139,6 +134,17 @@ void CDraggerBeam::Snap(int SnappingClient)
 		TargetPos, m_Pos, StartTick, m_ForClientId, LASERTYPE_DRAGGER, Subtype, m_Number);
 }
 
+bool CDraggerBeam::GetSnapBounds(vec2 &Min, vec2 &Max)
+{
+	CCharacter *pTarget = GameServer()->GetPlayerChar(m_ForClientId);
+	if(!pTarget)
+		return false;
+
+	Min = vec2(std::min(m_Pos.x, pTarget->m_Pos.x), std::min(m_Pos.y, pTarget->m_Pos.y));
+	Max = vec2(std::max(m_Pos.x, pTarget->m_Pos.x), std::max(m_Pos.y, pTarget->m_Pos.y));
+	return true;
+}
+
 void CDraggerBeam::SwapClients(int Client1, int Client2)
 {
 	m_ForClientId = m_ForClientId == Client1 ? Client2 : (m_ForClientId == Client2 ? Client1 : m_ForClientId);
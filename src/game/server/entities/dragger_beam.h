@@ -33,11 +33,10 @@ class CDraggerBeam : public CEntity
 public:
 	CDraggerBeam(CGameWorld *pGameWorld, CDragger *pDragger, vec2 Pos, float Strength, bool IgnoreWalls, int ForClientId, int Layer, int Number);
 
-	void SetPos(vec2 Pos);
-
 	void Reset() override;
 	void Tick() override;
 	void Snap(int SnappingClient) override;
+	bool GetSnapBounds(vec2 &Min, vec2 &Max) override;
 	void SwapClients(int Client1, int Client2) override;
 	ESaveResult BlocksSave(int ClientId) override;
 };
@@ -36,7 +36,7 @@ void CGun::Tick()
 	{
 		m_EvalTick = Server()->Tick();
 		GameServer()->Collision()->MoverSpeed(m_Pos.x, m_Pos.y, &m_Core);
-		m_Pos += m_Core;
+		SetPos(m_Pos + m_Core);
 	}
 	if(g_Config.m_SvPlasmaPerSec > 0)
 	{
@@ -172,3 +172,10 @@ void CGun::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId().value(),
 		m_Pos, m_Pos, StartTick, -1, LASERTYPE_GUN, Subtype, m_Number);
 }
+
+bool CGun::GetSnapBounds(vec2 &Min, vec2 &Max)
+{
+	Min = m_Pos;
+	Max = m_Pos;
+	return true;
+}
@@ -89,7 +89,7 @@ void CLight::Tick()
 	{
 		m_EvalTick = Server()->Tick();
 		GameServer()->Collision()->MoverSpeed(m_Pos.x, m_Pos.y, &m_Core);
-		m_Pos += m_Core;
+		SetPos(m_Pos + m_Core);
 		Step();
 	}
 
@@ -141,3 +141,10 @@ void CLight::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId().value(),
 		m_Pos, From, StartTick, -1, LASERTYPE_FREEZE, 0, m_Number);
 }
+
+bool CLight::GetSnapBounds(vec2 &Min, vec2 &Max)
+{
+	Min = vec2(std::min(m_Pos.x, m_To.x), std::min(m_Pos.y, m_To.y));
+	Max = vec2(std::max(m_Pos.x, m_To.x), std::max(m_Pos.y, m_To.y));
+	return true;
+}
@@ -31,6 +31,7 @@ public:
 	void Reset() override;
 	void Tick() override;
 	void Snap(int SnappingClient) override;
+	bool GetSnapBounds(vec2 &Min, vec2 &Max) override;
 };
 
 #endif // GAME_SERVER_ENTITIES_LIGHT_H
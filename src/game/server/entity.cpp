@@ -26,6 +26,11 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, bool RequestSnapId, vec2 P
 
 	m_pPrevTypeEntity = nullptr;
 	m_pNextTypeEntity = nullptr;
+	m_pPrevCellEntity = nullptr;
+	m_pNextCellEntity = nullptr;
+	m_GridCell = -1;
+	m_InsertIndex = 0;
+	m_SnapQueryStamp = 0;
 }
 
 CEntity::~CEntity()
@@ -35,6 +40,12 @@ CEntity::~CEntity()
 		Server()->SnapFreeId(m_Id.value());
 }
 
+void CEntity::SetPos(vec2 Pos)
+{
+	m_Pos = Pos;
+	m_pGameWorld->UpdateEntityPos(this);
+}
+
 bool CEntity::NetworkClipped(int SnappingClient) const
 {
 	return ::NetworkClipped(m_pGameWorld->GameServer(), SnappingClient, m_Pos);
@@ -26,6 +26,13 @@ private:
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
 
+	// spatial index handling, see CGameWorld::UpdateEntityPos
+	CEntity *m_pPrevCellEntity;
+	CEntity *m_pNextCellEntity;
+	int m_GridCell;
+	int64_t m_InsertIndex;
+	int m_SnapQueryStamp;
+
 	/* Identity */
 	CGameWorld *m_pGameWorld;
 	CCollision *m_pCCollision;
@@ -46,7 +53,8 @@ protected:
 public: // TODO: Maybe make protected
 	/*
 		Variable: m_Pos
-			Contains the current posititon of the entity.
+			Contains the current posititon of the entity. Use SetPos
+			to move an entity that has been inserted into the world.
 	*/
 	vec2 m_Pos;
 
@@ -76,6 +84,9 @@ public: // TODO: Maybe make protected
 	const vec2 &GetPos() const { return m_Pos; }
 	float GetProximityRadius() const { return m_ProximityRadius; }
 
+	/* Setters */
+	void SetPos(vec2 Pos);
+
 	/* Other functions */
 
 	/*
@@ -123,6 +134,22 @@ public: // TODO: Maybe make protected
 	*/
 	virtual void Snap(int SnappingClient) {}
 
+	/*
+		Function: GetSnapBounds
+			Returns the area that has to be within the network clip
+			range of a client for Snap to produce anything for it.
+			Entities that return true are skipped for clients whose
+			view doesn't overlap the area.
+
+		Arguments:
+			Min - Top left corner of the area.
+			Max - Bottom right corner of the area.
+
+		Returns:
+			False if Snap always has to be called.
+	*/
+	virtual bool GetSnapBounds(vec2 &Min, vec2 &Max) { return false; }
+
 	/*
 		Function: SwapClients
 			Called when two players have swapped their client ids.
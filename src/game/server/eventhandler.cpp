@@ -43,10 +43,28 @@ void CEventHandler::Clear()
 {
 	m_NumEvents = 0;
 	m_CurrentOffset = 0;
+	m_NumSixupEvents = 0;
+}
+
+void CEventHandler::TranslateSixupEvents()
+{
+	// events created since the last translation
+	for(; m_NumSixupEvents < m_NumEvents; m_NumSixupEvents++)
+	{
+		const int i = m_NumSixupEvents;
+		m_aSixupTypes[i] = m_aTypes[i];
+		m_aSixupSizes[i] = m_aSizes[i];
+		m_apSixupData[i] = &m_aData[m_aOffsets[i]];
+		EventToSixup(&m_aSixupTypes[i], &m_aSixupSizes[i], &m_apSixupData[i], m_aaSixupData[i]);
+	}
 }
 
 void CEventHandler::Snap(int SnappingClient)
 {
+	const bool Sixup = GameServer()->Server()->IsSixup(SnappingClient);
+	if(Sixup)
+		TranslateSixupEvents();
+
 	for(int i = 0; i < m_NumEvents; i++)
 	{
 		if(SnappingClient == SERVER_DEMO_CLIENT || m_aClientMasks[i].test(SnappingClient))
@@ -54,11 +72,9 @@ void CEventHandler::Snap(int SnappingClient)
 			CNetEvent_Common *pEvent = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
 			if(!NetworkClipped(GameServer(), SnappingClient, vec2(pEvent->m_X, pEvent->m_Y)))
 			{
-				int Type = m_aTypes[i];
-				int Size = m_aSizes[i];
-				const char *pData = &m_aData[m_aOffsets[i]];
-				if(GameServer()->Server()->IsSixup(SnappingClient))
-					EventToSixup(&Type, &Size, &pData);
+				int Type = Sixup ? m_aSixupTypes[i] : m_aTypes[i];
+				int Size = Sixup ? m_aSixupSizes[i] : m_aSizes[i];
+				const char *pData = Sixup ? m_apSixupData[i] : &m_aData[m_aOffsets[i]];
 
 				const auto &&SnapEvent = [&]() {
 					GameServer()->Server()->SnapNewItem(Type, i, pData, Size);
@@ -86,13 +102,14 @@ void CEventHandler::Snap(int SnappingClient)
 	}
 }
 
-void CEventHandler::EventToSixup(int *pType, int *pSize, const char **ppData)
+void CEventHandler::EventToSixup(int *pType, int *pSize, const char **ppData, char *pStore)
 {
-	static char s_aEventStore[128];
+	static_assert(sizeof(protocol7::CNetEvent_Damage) <= MAX_SIXUP_EVENT_SIZE);
+	static_assert(sizeof(protocol7::CNetEvent_SoundWorld) <= MAX_SIXUP_EVENT_SIZE);
 	if(*pType == NETEVENTTYPE_DAMAGEIND)
 	{
 		const CNetEvent_DamageInd *pEvent = (const CNetEvent_DamageInd *)(*ppData);
-		protocol7::CNetEvent_Damage *pEvent7 = (protocol7::CNetEvent_Damage *)s_aEventStore;
+		protocol7::CNetEvent_Damage *pEvent7 = (protocol7::CNetEvent_Damage *)pStore;
 		*pType = -protocol7::NETEVENTTYPE_DAMAGE;
 		*pSize = sizeof(*pEvent7);
 
@@ -111,12 +128,12 @@ void CEventHandler::EventToSixup(int *pType, int *pSize, const char **ppData)
 		pEvent7->m_ArmorAmount = 0;
 		pEvent7->m_Self = 0;
 
-		*ppData = s_aEventStore;
+		*ppData = pStore;
 	}
 	else if(*pType == NETEVENTTYPE_SOUNDGLOBAL) // No more global sounds for the server
 	{
 		const CNetEvent_SoundGlobal *pEvent = (const CNetEvent_SoundGlobal *)(*ppData);
-		protocol7::CNetEvent_SoundWorld *pEvent7 = (protocol7::CNetEvent_SoundWorld *)s_aEventStore;
+		protocol7::CNetEvent_SoundWorld *pEvent7 = (protocol7::CNetEvent_SoundWorld *)pStore;
 
 		*pType = -protocol7::NETEVENTTYPE_SOUNDWORLD;
 		*pSize = sizeof(*pEvent7);
@@ -125,6 +142,6 @@ void CEventHandler::EventToSixup(int *pType, int *pSize, const char **ppData)
 		pEvent7->m_X = pEvent->m_X;
 		pEvent7->m_Y = pEvent->m_Y;
 
-		*ppData = s_aEventStore;
+		*ppData = pStore;
 	}
 }
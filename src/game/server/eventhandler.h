@@ -13,6 +13,7 @@ class CEventHandler
 	{
 		MAX_EVENTS = 128,
 		MAX_DATASIZE = 128 * 64,
+		MAX_SIXUP_EVENT_SIZE = 32,
 	};
 
 	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
@@ -21,6 +22,13 @@ class CEventHandler
 	CClientMask m_aClientMasks[MAX_EVENTS];
 	char m_aData[MAX_DATASIZE];
 
+	// events translated for 0.7 clients, only once per tick for all of them
+	int m_aSixupTypes[MAX_EVENTS];
+	int m_aSixupSizes[MAX_EVENTS];
+	const char *m_apSixupData[MAX_EVENTS];
+	char m_aaSixupData[MAX_EVENTS][MAX_SIXUP_EVENT_SIZE];
+	int m_NumSixupEvents;
+
 	class CGameContext *m_pGameServer;
 
 	int m_CurrentOffset;
@@ -42,7 +50,8 @@ public:
 	void Clear();
 	void Snap(int SnappingClient);
 
-	void EventToSixup(int *pType, int *pSize, const char **ppData);
+	void TranslateSixupEvents();
+	static void EventToSixup(int *pType, int *pSize, const char **ppData, char *pStore);
 };
 
 #endif
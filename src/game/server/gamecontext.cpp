@@ -969,6 +969,42 @@ void CGameContext::SendSkinChange7(int ClientId)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, -1);
 }
 
+// Extracts the map of a `change_map` or `sv_map` vote command.
+static bool VoteCommandMap(const char *pCommand, char *pMap, int MapSize)
+{
+	pCommand = str_skip_whitespaces_const(pCommand);
+	const char *pArg = str_startswith(pCommand, "change_map");
+	if(!pArg)
+		pArg = str_startswith(pCommand, "sv_map");
+	if(!pArg || (*pArg != ' ' && *pArg != '\t'))
+		return false;
+	pArg = str_skip_whitespaces_const(pArg);
+
+	int Length = 0;
+	if(*pArg == '"')
+	{
+		for(pArg++; *pArg && *pArg != '"'; pArg++)
+		{
+			if(*pArg == '\\' && (pArg[1] == '"' || pArg[1] == '\\'))
+				pArg++;
+			if(Length < MapSize - 1)
+				pMap[Length++] = *pArg;
+		}
+	}
+	else
+	{
+		// the map argument takes the rest of the command
+		for(; *pArg && *pArg != ';'; pArg++)
+		{
+			if(Length < MapSize - 1)
+				pMap[Length++] = *pArg;
+		}
+	}
+	pMap[Length] = '\0';
+	str_utf8_trim_right(pMap);
+	return pMap[0] != '\0';
+}
+
 void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc)
 {
 	// reset votes
@@ -982,6 +1018,11 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 		}
 	}
 
+	// start loading the map of a map vote, so it is ready once the vote passes
+	char aVoteMap[MAX_MAP_LENGTH];
+	if(VoteCommandMap(pCommand, aVoteMap, sizeof(aVoteMap)))
+		Server()->PreloadMap(aVoteMap);
+
 	// start vote
 	m_VoteCloseTime = time_get() + time_freq() * g_Config.m_SvVoteTime;
 	str_copy(m_aVoteDescription, pDesc);
@@ -1215,6 +1256,9 @@ void CGameContext::OnTick()
 			m_TeeHistorian.EndInputs();
 			m_TeeHistorian.EndTick();
 		}
+		// make the compressed file readable up to now once per second
+		if(m_pTeeHistorianCompressor && Server()->Tick() % Server()->TickSpeed() == 0)
+			m_pTeeHistorianCompressor->Flush();
 		m_TeeHistorian.BeginTick(Server()->Tick());
 		m_TeeHistorian.BeginPlayers();
 	}
@@ -3951,6 +3995,7 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("votes", "?i[page]", CFGFLAG_SERVER, ConVotes, this, "Show all votes (page 0 by default, 20 entries per page)");
 	Console()->Register("dump_antibot", "", CFGFLAG_SERVER | CFGFLAG_STORE, ConDumpAntibot, this, "Dumps the antibot status");
 	Console()->Register("antibot", "r[command]", CFGFLAG_SERVER | CFGFLAG_STORE, ConAntibot, this, "Sends a command to the antibot");
+	Console()->Register("score_cache_stats", "", CFGFLAG_SERVER, ConScoreCacheStats, this, "Shows hits and misses of the score query result cache");
 
 	Console()->Chain("sv_motd", ConchainSpecialMotdupdate, this);
 
@@ -4278,8 +4323,19 @@ void CGameContext::OnInit(const void *pPersistentData)
 		char aGameUuid[UUID_MAXSTRSIZE];
 		FormatUuid(m_GameUuid, aGameUuid, sizeof(aGameUuid));
 
+		if(g_Config.m_SvTeeHistorianCompression == CTeeHistorianCompressor::CODEC_ZLIB)
+		{
+			m_pTeeHistorianCompressor = std::make_unique<CTeeHistorianCompressor>();
+			if(!m_pTeeHistorianCompressor->Init(TeeHistorianWrite, this))
+			{
+				dbg_msg("teehistorian", "failed to initialize compression");
+				Server()->SetErrorShutdown("teehistorian compression error");
+				return;
+			}
+		}
+
 		char aFilename[IO_MAX_PATH_LENGTH];
-		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aGameUuid);
+		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian%s", aGameUuid, m_pTeeHistorianCompressor ? ".gz" : "");
 
 		IOHANDLE THFile = Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 		if(!THFile)
@@ -4333,7 +4389,10 @@ void CGameContext::OnInit(const void *pPersistentData)
 			mem_zero(&GameInfo.m_PrevGameUuid, sizeof(GameInfo.m_PrevGameUuid));
 		}
 
-		m_TeeHistorian.Reset(&GameInfo, TeeHistorianWrite, this);
+		if(m_pTeeHistorianCompressor)
+			m_TeeHistorian.Reset(&GameInfo, CTeeHistorianCompressor::WriteCallback, m_pTeeHistorianCompressor.get());
+		else
+			m_TeeHistorian.Reset(&GameInfo, TeeHistorianWrite, this);
 	}
 
 	Server()->DemoRecorder_HandleAutoStart();
@@ -4593,6 +4652,16 @@ bool CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 	return true;
 }
 
+void CGameContext::OnMapPreload(IMap *pMap)
+{
+	// unpacks the tile data of the physics layers, which the collision
+	// initialization in OnInit would otherwise do on the main thread
+	CLayers Layers;
+	Layers.Init(pMap, false, false);
+	CCollision Collision;
+	Collision.Init(&Layers);
+}
+
 void CGameContext::OnShutdown(void *pPersistentData)
 {
 	CPersistentData *pPersistent = (CPersistentData *)pPersistentData;
@@ -4608,6 +4677,11 @@ void CGameContext::OnShutdown(void *pPersistentData)
 	if(m_TeeHistorianActive)
 	{
 		m_TeeHistorian.Finish();
+		if(m_pTeeHistorianCompressor)
+		{
+			m_pTeeHistorianCompressor->Finish();
+			m_pTeeHistorianCompressor = nullptr;
+		}
 		aio_close(m_pTeeHistorianFile);
 		aio_wait(m_pTeeHistorianFile);
 		int Error = aio_error(m_pTeeHistorianFile);
@@ -4693,7 +4767,7 @@ void CGameContext::OnSnap(int ClientId, bool GlobalSnap, bool RecordingDemo)
 	if(ClientId > -1)
 		m_apPlayers[ClientId]->FakeSnap();
 
-	m_World.Snap(ClientId);
+	SnapWorld(ClientId);
 
 	// events are only sent on global snapshots
 	if(GlobalSnap)
@@ -4702,6 +4776,80 @@ void CGameContext::OnSnap(int ClientId, bool GlobalSnap, bool RecordingDemo)
 	}
 }
 
+std::optional<CGameContext::CSharedWorldSnap::CKey> CGameContext::SharedWorldSnapKey(int ClientId) const
+{
+	if(ClientId < 0 || !m_apPlayers[ClientId])
+		return std::nullopt;
+
+	// Only spectators without a character are considered. The entities
+	// then don't treat the snapping client as their owner and, apart from
+	// the ones snapped per client, only depend on the client's view and
+	// spectating settings. Clients with a translated id map also receive
+	// client specific ids.
+	const CPlayer *pPlayer = m_apPlayers[ClientId];
+	if(pPlayer->GetTeam() != TEAM_SPECTATORS || pPlayer->GetCharacter() || !Server()->ClientSupportsServerMaxClients(ClientId))
+		return std::nullopt;
+
+	CSharedWorldSnap::CKey Key;
+	Key.m_ViewPos = pPlayer->m_ViewPos;
+	Key.m_NetworkClipRadius = pPlayer->m_NetworkClipRadius;
+	Key.m_ShowAll = pPlayer->m_ShowAll;
+	Key.m_ShowOthers = pPlayer->m_ShowOthers;
+	Key.m_SpecTeam = pPlayer->m_SpecTeam;
+	Key.m_SpectatorId = pPlayer->SpectatorId();
+	Key.m_DDRaceTeam = m_pController->Teams().m_Core.Team(ClientId);
+	Key.m_Solo = m_pController->Teams().m_Core.GetSolo(ClientId);
+	Key.m_ClientVersion = GetClientVersion(ClientId);
+	Key.m_Sixup = Server()->IsSixup(ClientId);
+	return Key;
+}
+
+void CGameContext::SnapWorld(int ClientId)
+{
+	std::optional<CSharedWorldSnap::CKey> Key;
+	if(Config()->m_SvSharedSpectatorSnapshots)
+		Key = SharedWorldSnapKey(ClientId);
+	if(!Key)
+	{
+		m_World.Snap(ClientId);
+		return;
+	}
+
+	if(m_SharedWorldSnapTick != Server()->Tick())
+	{
+		m_SharedWorldSnapTick = Server()->Tick();
+		m_NumSharedWorldSnaps = 0;
+	}
+
+	bool Replayed = false;
+	for(int i = 0; i < m_NumSharedWorldSnaps; i++)
+	{
+		if(m_aSharedWorldSnaps[i].m_Key == *Key)
+		{
+			Server()->SnapReplay(m_aSharedWorldSnaps[i].m_vItems);
+			Replayed = true;
+			break;
+		}
+	}
+
+	if(!Replayed)
+	{
+		if(m_NumSharedWorldSnaps == MAX_SHARED_WORLD_SNAPS)
+		{
+			m_World.Snap(ClientId);
+			return;
+		}
+
+		CSharedWorldSnap &Shared = m_aSharedWorldSnaps[m_NumSharedWorldSnaps++];
+		Shared.m_Key = *Key;
+		Server()->SnapStartRecording(&Shared.m_vItems);
+		m_World.Snap(ClientId, CGameWorld::ESnapPart::SHARED);
+		Server()->SnapStopRecording();
+	}
+
+	m_World.Snap(ClientId, CGameWorld::ESnapPart::PER_CLIENT);
+}
+
 void CGameContext::OnPostGlobalSnap()
 {
 	for(auto &pPlayer : m_apPlayers)
@@ -129,6 +129,7 @@ class CGameContext : public IGameServer
 
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
+	std::unique_ptr<CTeeHistorianCompressor> m_pTeeHistorianCompressor;
 	ASYNCIO *m_pTeeHistorianFile;
 	CUuid m_GameUuid;
 	CMapBugs m_MapBugs;
@@ -136,6 +137,44 @@ class CGameContext : public IGameServer
 
 	bool m_Resetting;
 
+	// Snapshot items of the game world shared between spectators that have
+	// the same view, see `sv_shared_spectator_snapshots`. The key contains
+	// what the shared entities' `Snap` functions depend on for such clients,
+	// the entities that depend on the client id itself are snapped per
+	// client, see `CGameWorld::SnapsPerClient`.
+	class CSharedWorldSnap
+	{
+	public:
+		class CKey
+		{
+		public:
+			vec2 m_ViewPos;
+			vec2 m_NetworkClipRadius;
+			bool m_ShowAll;
+			int m_ShowOthers;
+			bool m_SpecTeam;
+			int m_SpectatorId;
+			int m_DDRaceTeam;
+			bool m_Solo;
+			int m_ClientVersion;
+			bool m_Sixup;
+
+			bool operator==(const CKey &Other) const = default;
+		};
+
+		CKey m_Key;
+		std::vector<int> m_vItems;
+	};
+	enum
+	{
+		MAX_SHARED_WORLD_SNAPS = 16,
+	};
+	CSharedWorldSnap m_aSharedWorldSnaps[MAX_SHARED_WORLD_SNAPS];
+	int m_NumSharedWorldSnaps = 0;
+	int m_SharedWorldSnapTick = -1;
+	std::optional<CSharedWorldSnap::CKey> SharedWorldSnapKey(int ClientId) const;
+	void SnapWorld(int ClientId);
+
 	static std::optional<std::vector<int>> ClientsForVictim(int ClientId, const char *pVictim, void *pUser);
 	static void CommandCallback(int ClientId, int FlagMask, const char *pCmd, IConsole::IResult *pResult, void *pUser);
 	static void TeeHistorianWrite(const void *pData, int DataSize, void *pUser);
@@ -174,6 +213,7 @@ class CGameContext : public IGameServer
 	static void ConDrySave(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpAntibot(IConsole::IResult *pResult, void *pUserData);
 	static void ConAntibot(IConsole::IResult *pResult, void *pUserData);
+	static void ConScoreCacheStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSettingUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainPracticeByDefaultUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -205,6 +245,7 @@ public:
 	IStorage *Storage() { return m_pStorage; }
 	IMap *Map() override { return m_pMap.get(); }
 	const IMap *Map() const override { return m_pMap.get(); }
+	void SwapMap(std::unique_ptr<IMap> &pMap) override { std::swap(pMap, m_pMap); }
 	CCollision *Collision() { return &m_Collision; }
 	CTuningParams *GlobalTuning() { return &m_aTuningList[0]; }
 	CTuningParams *TuningList() { return m_aTuningList; }
@@ -350,6 +391,7 @@ public:
 	void RegisterDDRaceCommands();
 	void RegisterChatCommands();
 	[[nodiscard]] bool OnMapChange(char *pNewMapName, int MapNameSize) override;
+	void OnMapPreload(IMap *pMap) override;
 	void OnShutdown(void *pPersistentData) override;
 
 	void OnTick() override;
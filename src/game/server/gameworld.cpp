@@ -7,6 +7,7 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include "gamecontroller.h"
+#include "player.h"
 
 #include <engine/shared/config.h>
 
@@ -49,6 +50,123 @@ void CGameWorld::Init(CCollision *pCollision, CTuningParams *pTuningList)
 {
 	m_Core.InitSwitchers(pCollision->m_HighestSwitchNumber);
 	m_pTuningList = pTuningList;
+
+	// size the grid to the map, entities outside of the map are kept in
+	// the border cells
+	const int Width = pCollision->GetWidth() * 32;
+	const int Height = pCollision->GetHeight() * 32;
+	m_GridCellSize = GRID_MIN_CELL_SIZE;
+	while((int64_t)(Width / m_GridCellSize + 1) * (Height / m_GridCellSize + 1) > GRID_MAX_CELLS)
+		m_GridCellSize *= 2;
+	m_GridWidth = Width / m_GridCellSize + 1;
+	m_GridHeight = Height / m_GridCellSize + 1;
+
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		m_avpGridCells[Type].assign((size_t)m_GridWidth * m_GridHeight, nullptr);
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			pEnt->m_GridCell = -1;
+			GridInsert(pEnt);
+		}
+	}
+}
+
+int CGameWorld::GridCoord(float Value, int Size) const
+{
+	// also catches NaN
+	if(!(Value >= 0.0f))
+		return 0;
+	const float Coord = Value / m_GridCellSize;
+	if(Coord >= Size)
+		return Size - 1;
+	return (int)Coord;
+}
+
+int CGameWorld::GridCell(vec2 Pos) const
+{
+	return GridCoord(Pos.y, m_GridHeight) * m_GridWidth + GridCoord(Pos.x, m_GridWidth);
+}
+
+void CGameWorld::GridInsert(CEntity *pEnt)
+{
+	if(m_GridWidth == 0)
+		return;
+
+	const int Cell = GridCell(pEnt->m_Pos);
+	CEntity *&pFirst = m_avpGridCells[pEnt->m_ObjType][Cell];
+	if(pFirst)
+		pFirst->m_pPrevCellEntity = pEnt;
+	pEnt->m_pNextCellEntity = pFirst;
+	pEnt->m_pPrevCellEntity = nullptr;
+	pFirst = pEnt;
+	pEnt->m_GridCell = Cell;
+}
+
+void CGameWorld::GridRemove(CEntity *pEnt)
+{
+	if(pEnt->m_GridCell < 0)
+		return;
+
+	if(pEnt->m_pPrevCellEntity)
+		pEnt->m_pPrevCellEntity->m_pNextCellEntity = pEnt->m_pNextCellEntity;
+	else
+		m_avpGridCells[pEnt->m_ObjType][pEnt->m_GridCell] = pEnt->m_pNextCellEntity;
+	if(pEnt->m_pNextCellEntity)
+		pEnt->m_pNextCellEntity->m_pPrevCellEntity = pEnt->m_pPrevCellEntity;
+
+	pEnt->m_pNextCellEntity = nullptr;
+	pEnt->m_pPrevCellEntity = nullptr;
+	pEnt->m_GridCell = -1;
+}
+
+void CGameWorld::UpdateEntityPos(CEntity *pEnt)
+{
+	// not in the world (yet)
+	if(pEnt->m_GridCell < 0)
+		return;
+
+	m_SnapIndexValid = false;
+	if(GridCell(pEnt->m_Pos) == pEnt->m_GridCell)
+		return;
+
+	GridRemove(pEnt);
+	GridInsert(pEnt);
+}
+
+const std::vector<CEntity *> &CGameWorld::QueryCandidates(vec2 Min, vec2 Max, int Type)
+{
+	m_vpQueryCandidates.clear();
+
+	// one unit of margin so rounding can't drop entities that are exactly
+	// on the edge of the queried area
+	Min -= vec2(1.0f, 1.0f);
+	Max += vec2(1.0f, 1.0f);
+	const int MinX = GridCoord(Min.x, m_GridWidth);
+	const int MaxX = GridCoord(Max.x, m_GridWidth);
+	const int MinY = GridCoord(Min.y, m_GridHeight);
+	const int MaxY = GridCoord(Max.y, m_GridHeight);
+	const int64_t NumCells = (int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1);
+
+	// walking the type list is cheaper if the area covers more cells than
+	// there are entities of this type
+	if(m_GridWidth == 0 || NumCells > m_aNumEntities[Type])
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			m_vpQueryCandidates.push_back(pEnt);
+		return m_vpQueryCandidates;
+	}
+
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
+			for(CEntity *pEnt = m_avpGridCells[Type][y * m_GridWidth + x]; pEnt; pEnt = pEnt->m_pNextCellEntity)
+				m_vpQueryCandidates.push_back(pEnt);
+
+	// restore the order of the type list
+	std::sort(m_vpQueryCandidates.begin(), m_vpQueryCandidates.end(), [](const CEntity *pA, const CEntity *pB) {
+		return pA->m_InsertIndex > pB->m_InsertIndex;
+	});
+	return m_vpQueryCandidates;
 }
 
 CEntity *CGameWorld::FindFirst(int Type)
@@ -61,8 +179,9 @@ int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max,
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
+	const float Range = Radius + m_aMaxProximityRadius[Type];
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	for(CEntity *pEnt : QueryCandidates(Pos - vec2(Range, Range), Pos + vec2(Range, Range), Type))
 	{
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
@@ -90,6 +209,12 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = nullptr;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	pEnt->m_InsertIndex = m_NextInsertIndex++;
+	m_aNumEntities[pEnt->m_ObjType]++;
+	m_aMaxProximityRadius[pEnt->m_ObjType] = std::max(m_aMaxProximityRadius[pEnt->m_ObjType], pEnt->m_ProximityRadius);
+	GridInsert(pEnt);
+	m_SnapIndexValid = false;
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
@@ -112,30 +237,136 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
+
+	m_aNumEntities[pEnt->m_ObjType]--;
+	GridRemove(pEnt);
+	m_SnapIndexValid = false;
 }
 
-//
-void CGameWorld::Snap(int SnappingClient)
+void CGameWorld::UpdateSnapIndex()
 {
-	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
-	{
-		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-		pEnt->Snap(SnappingClient);
-		pEnt = m_pNextTraverseEntity;
-	}
+	if(m_SnapIndexValid && m_SnapIndexTick == Server()->Tick())
+		return;
+	m_SnapIndexValid = true;
+	m_SnapIndexTick = Server()->Tick();
 
+	struct SCellRange
+	{
+		CEntity *m_pEnt;
+		int m_MinX, m_MaxX, m_MinY, m_MaxY;
+	};
+	std::vector<SCellRange> vRanges;
+	m_vpSnapAlways.clear();
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 	{
 		if(i == ENTTYPE_CHARACTER)
 			continue;
 
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			vec2 Min, Max;
+			if(!pEnt->GetSnapBounds(Min, Max))
+			{
+				m_vpSnapAlways.push_back(pEnt);
+				continue;
+			}
+			SCellRange Range = {pEnt, GridCoord(Min.x, m_GridWidth), GridCoord(Max.x, m_GridWidth), GridCoord(Min.y, m_GridHeight), GridCoord(Max.y, m_GridHeight)};
+			if((Range.m_MaxX - Range.m_MinX + 1) * (Range.m_MaxY - Range.m_MinY + 1) > SNAP_MAX_CELL_SPAN)
+				m_vpSnapAlways.push_back(pEnt);
+			else
+				vRanges.push_back(Range);
+		}
+	}
+
+	// counting sort into one array for all cells
+	m_vSnapCellStart.assign((size_t)m_GridWidth * m_GridHeight + 1, 0);
+	for(const SCellRange &Range : vRanges)
+		for(int y = Range.m_MinY; y <= Range.m_MaxY; y++)
+			for(int x = Range.m_MinX; x <= Range.m_MaxX; x++)
+				m_vSnapCellStart[y * m_GridWidth + x + 1]++;
+	for(size_t i = 1; i < m_vSnapCellStart.size(); i++)
+		m_vSnapCellStart[i] += m_vSnapCellStart[i - 1];
+	m_vpSnapCellEntities.resize(m_vSnapCellStart.back());
+	std::vector<int> vFill(m_vSnapCellStart.begin(), m_vSnapCellStart.end() - 1);
+	for(const SCellRange &Range : vRanges)
+		for(int y = Range.m_MinY; y <= Range.m_MaxY; y++)
+			for(int x = Range.m_MinX; x <= Range.m_MaxX; x++)
+				m_vpSnapCellEntities[vFill[y * m_GridWidth + x]++] = Range.m_pEnt;
+}
+
+//
+void CGameWorld::Snap(int SnappingClient, ESnapPart Part)
+{
+	const auto &&InPart = [Part](int Type) {
+		return Part == ESnapPart::ALL || SnapsPerClient(Type) == (Part == ESnapPart::PER_CLIENT);
+	};
+
+	if(InPart(ENTTYPE_CHARACTER))
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 			pEnt->Snap(SnappingClient);
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
+
+	if(m_GridWidth == 0 || SnappingClient == SERVER_DEMO_CLIENT || GameServer()->m_apPlayers[SnappingClient]->m_ShowAll)
+	{
+		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			if(i == ENTTYPE_CHARACTER || !InPart(i))
+				continue;
+
+			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
+			{
+				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				pEnt->Snap(SnappingClient);
+				pEnt = m_pNextTraverseEntity;
+			}
+		}
+		return;
+	}
+
+	UpdateSnapIndex();
+
+	// the square covers the areas checked by both NetworkClipped and
+	// NetworkClippedLine, the entities check their exact visibility
+	const CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
+	const float ClipRadius = std::max(pPlayer->m_NetworkClipRadius.x, pPlayer->m_NetworkClipRadius.y) + 1.0f;
+	const int MinX = GridCoord(pPlayer->m_ViewPos.x - ClipRadius, m_GridWidth);
+	const int MaxX = GridCoord(pPlayer->m_ViewPos.x + ClipRadius, m_GridWidth);
+	const int MinY = GridCoord(pPlayer->m_ViewPos.y - ClipRadius, m_GridHeight);
+	const int MaxY = GridCoord(pPlayer->m_ViewPos.y + ClipRadius, m_GridHeight);
+
+	m_SnapQueryStamp++;
+	m_vpSnapCandidates = m_vpSnapAlways;
+	for(int y = MinY; y <= MaxY; y++)
+	{
+		for(int x = MinX; x <= MaxX; x++)
+		{
+			const int Cell = y * m_GridWidth + x;
+			for(int i = m_vSnapCellStart[Cell]; i < m_vSnapCellStart[Cell + 1]; i++)
+			{
+				CEntity *pEnt = m_vpSnapCellEntities[i];
+				if(pEnt->m_SnapQueryStamp != m_SnapQueryStamp)
+				{
+					pEnt->m_SnapQueryStamp = m_SnapQueryStamp;
+					m_vpSnapCandidates.push_back(pEnt);
+				}
+			}
+		}
+	}
+
+	// snap in the same order as walking the type lists
+	std::sort(m_vpSnapCandidates.begin(), m_vpSnapCandidates.end(), [](const CEntity *pA, const CEntity *pB) {
+		if(pA->m_ObjType != pB->m_ObjType)
+			return pA->m_ObjType < pB->m_ObjType;
+		return pA->m_InsertIndex > pB->m_InsertIndex;
+	});
+	for(CEntity *pEnt : m_vpSnapCandidates)
+		if(InPart(pEnt->m_ObjType))
+			pEnt->Snap(SnappingClient);
 }
 
 void CGameWorld::Reset()
@@ -202,6 +433,8 @@ void CGameWorld::RemoveEntities()
 
 void CGameWorld::Tick()
 {
+	m_SnapIndexValid = false;
+
 	if(m_ResetRequested)
 		Reset();
 
@@ -254,6 +487,12 @@ void CGameWorld::Tick()
 
 	RemoveEntities();
 
+#ifdef CONF_DEBUG
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			dbg_assert(pEnt->m_GridCell < 0 || pEnt->m_GridCell == GridCell(pEnt->m_Pos), "entity moved without CEntity::SetPos");
+#endif
+
 	// find the characters' strong/weak id
 	int StrongWeakId = 0;
 	for(CCharacter *pChar = (CCharacter *)FindFirst(ENTTYPE_CHARACTER); pChar; pChar = (CCharacter *)pChar->TypeNext())
@@ -300,8 +539,13 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
+	const float Range = Radius + m_aMaxProximityRadius[Type];
+	const vec2 Min = vec2(std::min(Pos0.x, Pos1.x), std::min(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(std::max(Pos0.x, Pos1.x), std::max(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	for(CEntity *pEntity : QueryCandidates(Min, Max, Type))
 	{
 		if(pEntity == pNotThis)
 			continue;
@@ -338,9 +582,10 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 	float ClosestRange = Radius * 2;
 	CCharacter *pClosest = nullptr;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	const float Range = Radius + m_aMaxProximityRadius[ENTTYPE_CHARACTER];
+	for(CEntity *pEnt : QueryCandidates(Pos - vec2(Range, Range), Pos + vec2(Range, Range), ENTTYPE_CHARACTER))
 	{
+		CCharacter *p = (CCharacter *)pEnt;
 		if(p == pNotThis)
 			continue;
 
@@ -361,9 +606,12 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
+	const float Range = Radius + m_aMaxProximityRadius[ENTTYPE_CHARACTER];
+	const vec2 Min = vec2(std::min(Pos0.x, Pos1.x), std::min(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(std::max(Pos0.x, Pos1.x), std::max(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	for(CEntity *pEnt : QueryCandidates(Min, Max, ENTTYPE_CHARACTER))
 	{
+		CCharacter *pChr = (CCharacter *)pEnt;
 		if(pChr == pNotThis)
 			continue;
 
@@ -38,6 +38,48 @@ private:
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// Uniform grid over the map used to speed up the position based
+	// queries. Each cell holds an intrusive list per entity type. The type
+	// lists stay authoritative for the order of the query results: entities
+	// are prepended on insertion, so the list order is the descending order
+	// of the insertion index.
+	enum
+	{
+		GRID_MIN_CELL_SIZE = 256,
+		GRID_MAX_CELLS = 1 << 16,
+	};
+	int m_GridCellSize = GRID_MIN_CELL_SIZE;
+	int m_GridWidth = 0;
+	int m_GridHeight = 0;
+	std::vector<CEntity *> m_avpGridCells[NUM_ENTTYPES];
+	int m_aNumEntities[NUM_ENTTYPES] = {};
+	float m_aMaxProximityRadius[NUM_ENTTYPES] = {};
+	int64_t m_NextInsertIndex = 0;
+	std::vector<CEntity *> m_vpQueryCandidates;
+
+	int GridCoord(float Value, int Size) const;
+	int GridCell(vec2 Pos) const;
+	void GridInsert(CEntity *pEnt);
+	void GridRemove(CEntity *pEnt);
+	const std::vector<CEntity *> &QueryCandidates(vec2 Min, vec2 Max, int Type);
+
+	// Snap culling index, rebuilt on the first Snap of a tick. Entities
+	// are added to all cells overlapped by their snap bounds, entities
+	// without bounds or with very large ones are snapped for every client.
+	enum
+	{
+		SNAP_MAX_CELL_SPAN = 64,
+	};
+	bool m_SnapIndexValid = false;
+	int m_SnapIndexTick = -1;
+	int m_SnapQueryStamp = 0;
+	std::vector<int> m_vSnapCellStart;
+	std::vector<CEntity *> m_vpSnapCellEntities;
+	std::vector<CEntity *> m_vpSnapAlways;
+	std::vector<CEntity *> m_vpSnapCandidates;
+
+	void UpdateSnapIndex();
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -144,9 +186,30 @@ public:
 	*/
 	void RemoveEntity(CEntity *pEntity);
 
+	/*
+		Function: UpdateEntityPos
+			Moves an entity to the grid cell of its current position.
+			Called by CEntity::SetPos.
+
+		Arguments:
+			pEntity - Entity that has been moved
+	*/
+	void UpdateEntityPos(CEntity *pEntity);
+
 	void RemoveEntitiesFromPlayer(int PlayerId);
 	void RemoveEntitiesFromPlayers(int PlayerIds[], int NumPlayers);
 
+	// Entities that can be snapped separately. Projectiles filter on a mask
+	// of client ids that is only refreshed while their owner is alive, so
+	// their items can differ between clients with the same view.
+	enum class ESnapPart
+	{
+		ALL,
+		SHARED,
+		PER_CLIENT,
+	};
+	static bool SnapsPerClient(int Type) { return Type == ENTTYPE_PROJECTILE; }
+
 	/*
 		Function: Snap
 			Calls Snap on all the entities in the world to create
@@ -155,8 +218,9 @@ public:
 		Arguments:
 			SnappingClient - ID of the client which snapshot
 			is being created.
+			Part - Which of the entities to snap.
 	*/
-	void Snap(int SnappingClient);
+	void Snap(int SnappingClient, ESnapPart Part = ESnapPart::ALL);
 
 	/*
 		Function: Tick
@@ -57,6 +57,115 @@ void CScorePlayerResult::SetVariant(Variant v)
 	}
 }
 
+void CScoreResultCache::FormatKey(EQuery Query, const CSqlPlayerRequest *pRequest, char *pBuf, int BufSize)
+{
+	// only include the request fields the query result depends on, so that
+	// e.g. /top5 is shared between all players
+	const bool PerPlayer = Query == QUERY_MAP_INFO || Query == QUERY_RANK;
+	const bool PerOffset = Query == QUERY_TOP || Query == QUERY_TEAM_TOP5 || Query == QUERY_TOP_POINTS;
+	str_format(pBuf, BufSize, "%d\x1f%s\x1f%s\x1f%s\x1f%s\x1f%d\x1f%d\x1f%d",
+		(int)Query,
+		pRequest->m_aMap,
+		PerPlayer ? pRequest->m_aName : "",
+		PerPlayer ? pRequest->m_aRequestingPlayer : "",
+		pRequest->m_aServer,
+		PerOffset ? pRequest->m_Offset : 0,
+		g_Config.m_SvRegionalRankings,
+		g_Config.m_SvHideScore);
+}
+
+bool CScoreResultCache::Get(EQuery Query, const CSqlPlayerRequest *pRequest, CScorePlayerResult *pResult, uint64_t *pGeneration)
+{
+	char aKey[MAX_MAP_LENGTH * 2 + MAX_NAME_LENGTH + 64];
+	FormatKey(Query, pRequest, aKey, sizeof(aKey));
+
+	CLockScope ls(m_Lock);
+	*pGeneration = m_Generation;
+	if(g_Config.m_SvSqlCacheTtl <= 0)
+		return false;
+
+	auto It = m_Entries.find(aKey);
+	if(It == m_Entries.end() || It->second.m_Expiry < time_get_impl())
+	{
+		m_NumMisses++;
+		return false;
+	}
+	pResult->m_MessageKind = It->second.m_MessageKind;
+	pResult->m_Data = It->second.m_Data;
+	m_NumHits++;
+	return true;
+}
+
+void CScoreResultCache::Put(EQuery Query, const CSqlPlayerRequest *pRequest, const CScorePlayerResult *pResult, uint64_t Generation)
+{
+	if(g_Config.m_SvSqlCacheTtl <= 0)
+		return;
+
+	char aKey[MAX_MAP_LENGTH * 2 + MAX_NAME_LENGTH + 64];
+	FormatKey(Query, pRequest, aKey, sizeof(aKey));
+	const int64_t Now = time_get_impl();
+
+	CLockScope ls(m_Lock);
+	if(Generation != m_Generation)
+		return;
+
+	if(m_Entries.size() >= MAX_ENTRIES)
+	{
+		std::erase_if(m_Entries, [Now](const auto &Entry) { return Entry.second.m_Expiry < Now; });
+		// still full of fresh entries, start over instead of tracking the LRU order
+		if(m_Entries.size() >= MAX_ENTRIES)
+			m_Entries.clear();
+	}
+
+	CEntry &Entry = m_Entries[aKey];
+	Entry.m_Map = pRequest->m_aMap;
+	Entry.m_Expiry = Now + g_Config.m_SvSqlCacheTtl * time_freq();
+	Entry.m_MessageKind = pResult->m_MessageKind;
+	Entry.m_Data = pResult->m_Data;
+}
+
+void CScoreResultCache::Invalidate(const char *pMap)
+{
+	CLockScope ls(m_Lock);
+	m_Generation++;
+	std::erase_if(m_Entries, [pMap](const auto &Entry) { return Entry.second.m_Map == pMap; });
+}
+
+void CScoreResultCache::Clear()
+{
+	CLockScope ls(m_Lock);
+	m_Generation++;
+	m_Entries.clear();
+	m_NumHits = 0;
+	m_NumMisses = 0;
+}
+
+int CScoreResultCache::NumEntries()
+{
+	CLockScope ls(m_Lock);
+	return m_Entries.size();
+}
+
+CScoreResultCache &CScoreWorker::ResultCache()
+{
+	static CScoreResultCache s_Cache;
+	return s_Cache;
+}
+
+static bool CachedPlayerQuery(CScoreResultCache::EQuery Query, CDbConnectionPool::FRead pfnQuery, IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
+
+	uint64_t Generation;
+	if(CScoreWorker::ResultCache().Get(Query, pData, pResult, &Generation))
+		return true;
+	if(!pfnQuery(pSqlServer, pGameData, pError, ErrorSize))
+		return false;
+	CScoreWorker::ResultCache().Put(Query, pData, pResult, Generation);
+	return true;
+}
+
 CTeamrank::CTeamrank() :
 	m_NumNames(0)
 {
@@ -367,7 +476,7 @@ bool CScoreWorker::MapVote(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	return true;
 }
 
-bool CScoreWorker::MapInfo(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+static bool MapInfoUncached(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -514,7 +623,12 @@ bool CScoreWorker::MapInfo(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	return true;
 }
 
-bool CScoreWorker::SaveScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+bool CScoreWorker::MapInfo(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return CachedPlayerQuery(CScoreResultCache::QUERY_MAP_INFO, MapInfoUncached, pSqlServer, pGameData, pError, ErrorSize);
+}
+
+static bool WriteScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlScoreData *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -636,44 +750,56 @@ bool CScoreWorker::SaveScore(IDbConnection *pSqlServer, const ISqlData *pGameDat
 	}
 
 	// save score. Can't fail, because no UNIQUE/PRIMARY KEY constrain is defined.
+	// The times are bound as text with the same precision they used to be
+	// formatted into the query with, so that the statement can be reused.
 	str_format(aBuf, sizeof(aBuf),
 		"%s INTO %s_race%s("
 		"	Map, Name, Timestamp, Time, Server, "
 		"	cp1, cp2, cp3, cp4, cp5, cp6, cp7, cp8, cp9, cp10, cp11, cp12, cp13, "
 		"	cp14, cp15, cp16, cp17, cp18, cp19, cp20, cp21, cp22, cp23, cp24, cp25, "
 		"	GameId, DDNet7) "
-		"VALUES (?, ?, %s, %.2f, ?, "
-		"	%.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, "
-		"	%.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, "
-		"	%.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, "
+		"VALUES (?, ?, %s, ?, ?, "
+		"	?, ?, ?, ?, ?, ?, ?, ?, ?, "
+		"	?, ?, ?, ?, ?, ?, ?, ?, ?, "
+		"	?, ?, ?, ?, ?, ?, ?, "
 		"	?, %s)",
 		pSqlServer->InsertIgnore(), pSqlServer->GetPrefix(),
 		w == Write::NORMAL ? "" : "_backup",
-		pSqlServer->InsertTimestampAsUtc(), pData->m_Time,
-		pData->m_aCurrentTimeCp[0], pData->m_aCurrentTimeCp[1], pData->m_aCurrentTimeCp[2],
-		pData->m_aCurrentTimeCp[3], pData->m_aCurrentTimeCp[4], pData->m_aCurrentTimeCp[5],
-		pData->m_aCurrentTimeCp[6], pData->m_aCurrentTimeCp[7], pData->m_aCurrentTimeCp[8],
-		pData->m_aCurrentTimeCp[9], pData->m_aCurrentTimeCp[10], pData->m_aCurrentTimeCp[11],
-		pData->m_aCurrentTimeCp[12], pData->m_aCurrentTimeCp[13], pData->m_aCurrentTimeCp[14],
-		pData->m_aCurrentTimeCp[15], pData->m_aCurrentTimeCp[16], pData->m_aCurrentTimeCp[17],
-		pData->m_aCurrentTimeCp[18], pData->m_aCurrentTimeCp[19], pData->m_aCurrentTimeCp[20],
-		pData->m_aCurrentTimeCp[21], pData->m_aCurrentTimeCp[22], pData->m_aCurrentTimeCp[23],
-		pData->m_aCurrentTimeCp[24], pSqlServer->False());
+		pSqlServer->InsertTimestampAsUtc(), pSqlServer->False());
 	if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
 	{
 		return false;
 	}
+	char aTime[32];
+	char aaTimeCp[NUM_CHECKPOINTS][32];
+	str_format(aTime, sizeof(aTime), "%.2f", pData->m_Time);
 	pSqlServer->BindString(1, pData->m_aMap);
 	pSqlServer->BindString(2, pData->m_aName);
 	pSqlServer->BindString(3, pData->m_aTimestamp);
-	pSqlServer->BindString(4, g_Config.m_SvSqlServerName);
-	pSqlServer->BindString(5, pData->m_aGameUuid);
+	pSqlServer->BindString(4, aTime);
+	pSqlServer->BindString(5, g_Config.m_SvSqlServerName);
+	for(int i = 0; i < NUM_CHECKPOINTS; i++)
+	{
+		str_format(aaTimeCp[i], sizeof(aaTimeCp[i]), "%.2f", pData->m_aCurrentTimeCp[i]);
+		pSqlServer->BindString(6 + i, aaTimeCp[i]);
+	}
+	pSqlServer->BindString(6 + NUM_CHECKPOINTS, pData->m_aGameUuid);
 	pSqlServer->Print();
 	int NumInserted;
 	return pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize);
 }
 
-bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+bool CScoreWorker::SaveScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	if(!WriteScore(pSqlServer, pGameData, w, pError, ErrorSize))
+		return false;
+	// only invalidate once the score is committed, a concurrent read could
+	// otherwise cache the old rankings again
+	ResultCache().Invalidate(dynamic_cast<const CSqlScoreData *>(pGameData)->m_aMap);
+	return true;
+}
+
+static bool WriteTeamScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlTeamScoreData *>(pGameData);
 
@@ -791,15 +917,18 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 			if(pData->m_Time < Time)
 			{
 				str_format(aBuf, sizeof(aBuf),
-					"UPDATE %s_teamrace SET Time=%.2f, Timestamp=%s, DDNet7=%s, GameId=? WHERE Id = ?",
-					pSqlServer->GetPrefix(), pData->m_Time, pSqlServer->InsertTimestampAsUtc(), pSqlServer->False());
+					"UPDATE %s_teamrace SET Time=?, Timestamp=%s, DDNet7=%s, GameId=? WHERE Id = ?",
+					pSqlServer->GetPrefix(), pSqlServer->InsertTimestampAsUtc(), pSqlServer->False());
 				if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
 				{
 					return false;
 				}
-				pSqlServer->BindString(1, pData->m_aTimestamp);
-				pSqlServer->BindString(2, pData->m_aGameUuid);
-				pSqlServer->BindBlob(3, Teamrank.m_TeamId.m_aData, sizeof(Teamrank.m_TeamId.m_aData));
+				char aTime[32];
+				str_format(aTime, sizeof(aTime), "%.2f", pData->m_Time);
+				pSqlServer->BindString(1, aTime);
+				pSqlServer->BindString(2, pData->m_aTimestamp);
+				pSqlServer->BindString(3, pData->m_aGameUuid);
+				pSqlServer->BindBlob(4, Teamrank.m_TeamId.m_aData, sizeof(Teamrank.m_TeamId.m_aData));
 				pSqlServer->Print();
 				int NumUpdated;
 				if(!pSqlServer->ExecuteUpdate(&NumUpdated, pError, ErrorSize))
@@ -813,15 +942,17 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 		}
 	}
 
+	char aTime[32];
+	str_format(aTime, sizeof(aTime), "%.2f", pData->m_Time);
 	for(unsigned int i = 0; i < pData->m_Size; i++)
 	{
 		// if no entry found... create a new one
 		str_format(aBuf, sizeof(aBuf),
 			"%s INTO %s_teamrace%s(Map, Name, Timestamp, Time, Id, GameId, DDNet7) "
-			"VALUES (?, ?, %s, %.2f, ?, ?, %s)",
+			"VALUES (?, ?, %s, ?, ?, ?, %s)",
 			pSqlServer->InsertIgnore(), pSqlServer->GetPrefix(),
 			w == Write::NORMAL ? "" : "_backup",
-			pSqlServer->InsertTimestampAsUtc(), pData->m_Time, pSqlServer->False());
+			pSqlServer->InsertTimestampAsUtc(), pSqlServer->False());
 		if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
 		{
 			return false;
@@ -829,10 +960,11 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 		pSqlServer->BindString(1, pData->m_aMap);
 		pSqlServer->BindString(2, pData->m_aaNames[i]);
 		pSqlServer->BindString(3, pData->m_aTimestamp);
+		pSqlServer->BindString(4, aTime);
 		// copy uuid, because mysql BindBlob doesn't support const buffers
 		CUuid TeamrankId = pData->m_TeamrankUuid;
-		pSqlServer->BindBlob(4, TeamrankId.m_aData, sizeof(TeamrankId.m_aData));
-		pSqlServer->BindString(5, pData->m_aGameUuid);
+		pSqlServer->BindBlob(5, TeamrankId.m_aData, sizeof(TeamrankId.m_aData));
+		pSqlServer->BindString(6, pData->m_aGameUuid);
 		pSqlServer->Print();
 		int NumInserted;
 		if(!pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize))
@@ -843,7 +975,17 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
-bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	if(!WriteTeamScore(pSqlServer, pGameData, w, pError, ErrorSize))
+		return false;
+	// only invalidate once the score is committed, a concurrent read could
+	// otherwise cache the old rankings again
+	ResultCache().Invalidate(dynamic_cast<const CSqlTeamScoreData *>(pGameData)->m_aMap);
+	return true;
+}
+
+static bool ShowRankUncached(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -962,6 +1104,11 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 	return true;
 }
 
+bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return CachedPlayerQuery(CScoreResultCache::QUERY_RANK, ShowRankUncached, pSqlServer, pGameData, pError, ErrorSize);
+}
+
 bool CScoreWorker::ShowTeamRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -1045,7 +1192,7 @@ bool CScoreWorker::ShowTeamRank(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
-bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+static bool ShowTopUncached(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -1171,7 +1318,12 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	return End;
 }
 
-bool CScoreWorker::ShowTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return CachedPlayerQuery(CScoreResultCache::QUERY_TOP, ShowTopUncached, pSqlServer, pGameData, pError, ErrorSize);
+}
+
+static bool ShowTeamTop5Uncached(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -1268,6 +1420,11 @@ bool CScoreWorker::ShowTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+bool CScoreWorker::ShowTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return CachedPlayerQuery(CScoreResultCache::QUERY_TEAM_TOP5, ShowTeamTop5Uncached, pSqlServer, pGameData, pError, ErrorSize);
+}
+
 bool CScoreWorker::ShowPlayerTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -1520,7 +1677,7 @@ bool CScoreWorker::ShowPoints(IDbConnection *pSqlServer, const ISqlData *pGameDa
 	return true;
 }
 
-bool CScoreWorker::ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+static bool ShowTopPointsUncached(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
@@ -1569,6 +1726,11 @@ bool CScoreWorker::ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
+bool CScoreWorker::ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return CachedPlayerQuery(CScoreResultCache::QUERY_TOP_POINTS, ShowTopPointsUncached, pSqlServer, pGameData, pError, ErrorSize);
+}
+
 bool CScoreWorker::RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlRandomMapRequest *>(pGameData);
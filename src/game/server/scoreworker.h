@@ -1,6 +1,7 @@
 #ifndef GAME_SERVER_SCOREWORKER_H
 #define GAME_SERVER_SCOREWORKER_H
 
+#include <base/lock.h>
 #include <base/str.h>
 
 #include <engine/map.h>
@@ -11,9 +12,11 @@
 #include <game/server/save.h>
 #include <game/voting.h>
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -289,8 +292,64 @@ struct CTeamrank
 	static bool GetSqlTop5Team(IDbConnection *pSqlServer, bool *pEnd, char *pError, int ErrorSize, char (*paMessages)[512], int *StartLine, int Count);
 };
 
+// Short-lived cache for the result sets of the read queries players spam the
+// most (/top5, /top5team, /toppoints, /mapinfo, /rank). Entries expire after
+// sv_sql_cache_ttl seconds and are dropped as soon as a score or team score
+// on the same map has been written. Shared by all read workers.
+class CScoreResultCache
+{
+public:
+	enum EQuery
+	{
+		QUERY_MAP_INFO,
+		QUERY_RANK,
+		QUERY_TOP,
+		QUERY_TEAM_TOP5,
+		QUERY_TOP_POINTS,
+	};
+
+	enum
+	{
+		MAX_ENTRIES = 512,
+	};
+
+	// Copies a cached result into pResult if there is one that hasn't
+	// expired yet. Always sets pGeneration, which has to be passed to Put
+	// after querying the database on a miss.
+	bool Get(EQuery Query, const CSqlPlayerRequest *pRequest, CScorePlayerResult *pResult, uint64_t *pGeneration);
+	// Stores the result unless the map was invalidated since Get returned
+	// Generation, so that results read before a concurrent score write
+	// can't be cached.
+	void Put(EQuery Query, const CSqlPlayerRequest *pRequest, const CScorePlayerResult *pResult, uint64_t Generation);
+	void Invalidate(const char *pMap);
+	void Clear();
+
+	uint64_t NumHits() const { return m_NumHits; }
+	uint64_t NumMisses() const { return m_NumMisses; }
+	int NumEntries();
+
+private:
+	struct CEntry
+	{
+		std::string m_Map;
+		int64_t m_Expiry;
+		CScorePlayerResult::Variant m_MessageKind;
+		decltype(CScorePlayerResult::m_Data) m_Data;
+	};
+
+	static void FormatKey(EQuery Query, const CSqlPlayerRequest *pRequest, char *pBuf, int BufSize);
+
+	CLock m_Lock;
+	std::unordered_map<std::string, CEntry> m_Entries GUARDED_BY(m_Lock);
+	uint64_t m_Generation GUARDED_BY(m_Lock) = 0;
+	std::atomic<uint64_t> m_NumHits = 0;
+	std::atomic<uint64_t> m_NumMisses = 0;
+};
+
 struct CScoreWorker
 {
+	static CScoreResultCache &ResultCache();
+
 	static bool LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
 	static bool RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
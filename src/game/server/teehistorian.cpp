@@ -12,6 +12,8 @@
 
 #include <game/gamecore.h>
 
+#include <zlib.h>
+
 class CTeehistorianPacker : public CAbstractPacker
 {
 public:
@@ -880,3 +882,72 @@ void CTeeHistorian::Finish()
 
 	Write(Buffer.Data(), Buffer.Size());
 }
+
+CTeeHistorianCompressor::CTeeHistorianCompressor() = default;
+
+CTeeHistorianCompressor::~CTeeHistorianCompressor()
+{
+	if(m_pStream)
+		deflateEnd(m_pStream.get());
+}
+
+bool CTeeHistorianCompressor::Init(CTeeHistorian::WRITE_CALLBACK pfnWriteCallback, void *pUser)
+{
+	dbg_assert(!m_pStream, "teehistorian compressor already initialized");
+	m_pStream = std::make_unique<z_stream>();
+	mem_zero(m_pStream.get(), sizeof(z_stream));
+	// 16 + MAX_WBITS writes a gzip header, so that the output can be read with common tools
+	if(deflateInit2(m_pStream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		m_pStream = nullptr;
+		return false;
+	}
+	m_pfnWriteCallback = pfnWriteCallback;
+	m_pWriteCallbackUserdata = pUser;
+	return true;
+}
+
+void CTeeHistorianCompressor::Deflate(const void *pData, int DataSize, int FlushMode)
+{
+	m_pStream->next_in = (Bytef *)pData;
+	m_pStream->avail_in = DataSize;
+	do
+	{
+		m_pStream->next_out = m_aOutput;
+		m_pStream->avail_out = sizeof(m_aOutput);
+		const int Result = deflate(m_pStream.get(), FlushMode);
+		dbg_assert(Result != Z_STREAM_ERROR, "teehistorian compression failed");
+		const int OutputSize = sizeof(m_aOutput) - m_pStream->avail_out;
+		if(OutputSize > 0)
+			m_pfnWriteCallback(m_aOutput, OutputSize, m_pWriteCallbackUserdata);
+	} while(m_pStream->avail_out == 0);
+}
+
+void CTeeHistorianCompressor::Write(const void *pData, int DataSize)
+{
+	if(DataSize <= 0)
+		return;
+	Deflate(pData, DataSize, Z_NO_FLUSH);
+	m_Pending = true;
+}
+
+void CTeeHistorianCompressor::Flush()
+{
+	if(!m_Pending)
+		return;
+	Deflate(nullptr, 0, Z_SYNC_FLUSH);
+	m_Pending = false;
+}
+
+void CTeeHistorianCompressor::Finish()
+{
+	Deflate(nullptr, 0, Z_FINISH);
+	deflateEnd(m_pStream.get());
+	m_pStream = nullptr;
+	m_Pending = false;
+}
+
+void CTeeHistorianCompressor::WriteCallback(const void *pData, int DataSize, void *pUser)
+{
+	static_cast<CTeeHistorianCompressor *>(pUser)->Write(pData, DataSize);
+}
@@ -9,10 +9,12 @@
 #include <generated/protocol.h>
 
 #include <ctime>
+#include <memory>
 
 class CConfig;
 class CTuningParams;
 class CUuidManager;
+struct z_stream_s;
 
 class CTeeHistorian
 {
@@ -150,4 +152,39 @@ private:
 	CTeam m_aPrevTeams[MAX_CLIENTS];
 };
 
+/**
+ * Streaming gzip compression of the teehistorian output, placed between
+ * `CTeeHistorian` and the file. `Flush` completes the deflate block, so that
+ * a partially written file can be decompressed up to the last flush.
+ */
+class CTeeHistorianCompressor
+{
+public:
+	enum
+	{
+		CODEC_NONE = 0,
+		CODEC_ZLIB,
+	};
+
+	CTeeHistorianCompressor();
+	~CTeeHistorianCompressor();
+
+	bool Init(CTeeHistorian::WRITE_CALLBACK pfnWriteCallback, void *pUser);
+	void Write(const void *pData, int DataSize);
+	void Flush();
+	void Finish();
+
+	// to be passed to `CTeeHistorian::Reset` with the compressor as user data
+	static void WriteCallback(const void *pData, int DataSize, void *pUser);
+
+private:
+	void Deflate(const void *pData, int DataSize, int FlushMode);
+
+	std::unique_ptr<z_stream_s> m_pStream;
+	bool m_Pending = false;
+	CTeeHistorian::WRITE_CALLBACK m_pfnWriteCallback = nullptr;
+	void *m_pWriteCallbackUserdata = nullptr;
+	unsigned char m_aOutput[16 * 1024];
+};
+
 #endif // GAME_SERVER_TEEHISTORIAN_H
@@ -0,0 +1,113 @@
+#include <base/str.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <gtest/gtest.h>
+
+class CCommandCall
+{
+public:
+	int m_NumCalls = 0;
+	int m_NumArguments = -1;
+	char m_aLastArgument[64] = "";
+};
+
+static void CommandCallback(IConsole::IResult *pResult, void *pUserData)
+{
+	CCommandCall *pCall = static_cast<CCommandCall *>(pUserData);
+	pCall->m_NumCalls++;
+	pCall->m_NumArguments = pResult->NumArguments();
+	if(pResult->NumArguments() > 0)
+		str_copy(pCall->m_aLastArgument, pResult->GetString(pResult->NumArguments() - 1));
+}
+
+TEST(Console, FindCommandIgnoresCase)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	CCommandCall Call;
+	pConsole->Register("test_command", "i[number]", CFGFLAG_SERVER, CommandCallback, &Call, "");
+
+	pConsole->ExecuteLine("test_command 1", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("TEST_Command 2", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("test_command_ 3", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("test_comman 4", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Call.m_NumCalls, 2);
+	EXPECT_STREQ(Call.m_aLastArgument, "2");
+
+	ASSERT_NE(pConsole->GetCommandInfo("Test_Command", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("Test_Command", CFGFLAG_SERVER, false)->Name(), "test_command");
+	EXPECT_EQ(pConsole->GetCommandInfo("test_command", CFGFLAG_CLIENT, false), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, true), nullptr);
+}
+
+TEST(Console, FindCommandByFlags)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	CCommandCall ClientCall;
+	CCommandCall ServerCall;
+	pConsole->Register("shared_name", "", CFGFLAG_CLIENT, CommandCallback, &ClientCall, "");
+	pConsole->Register("shared_name", "", CFGFLAG_SERVER, CommandCallback, &ServerCall, "");
+
+	pConsole->ExecuteLine("shared_name", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ClientCall.m_NumCalls, 0);
+	EXPECT_EQ(ServerCall.m_NumCalls, 1);
+
+	pConsole->ExecuteLineFlag("shared_name", CFGFLAG_CLIENT, IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ClientCall.m_NumCalls, 1);
+	EXPECT_EQ(ServerCall.m_NumCalls, 1);
+
+	// registering again replaces the callback of the existing command
+	CCommandCall ReplacedCall;
+	pConsole->Register("SHARED_NAME", "", CFGFLAG_SERVER, CommandCallback, &ReplacedCall, "");
+	pConsole->ExecuteLine("shared_name", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ServerCall.m_NumCalls, 1);
+	EXPECT_EQ(ReplacedCall.m_NumCalls, 1);
+}
+
+TEST(Console, TempCommands)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	pConsole->RegisterTemp("temp_a", "s[text]", CFGFLAG_SERVER, "");
+	pConsole->RegisterTemp("temp_b", "", CFGFLAG_SERVER, "");
+	EXPECT_NE(pConsole->GetCommandInfo("TEMP_A", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, false), nullptr);
+
+	// the removed command is recycled for the next one
+	pConsole->DeregisterTemp("temp_a");
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	pConsole->RegisterTemp("temp_c", "i[number]", CFGFLAG_SERVER, "");
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	ASSERT_NE(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true)->Params(), "i[number]");
+
+	pConsole->DeregisterTempAll();
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("echo", CFGFLAG_SERVER, false), nullptr);
+}
+
+TEST(Console, ParseArguments)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	CCommandCall Call;
+	pConsole->Register("args", "i[number] ?f[decimal] ?r[rest of the line]", CFGFLAG_SERVER, CommandCallback, &Call, "");
+
+	EXPECT_TRUE(pConsole->LineIsValid("args 1"));
+	EXPECT_TRUE(pConsole->LineIsValid("args 1 2.5"));
+	EXPECT_TRUE(pConsole->LineIsValid("args 1 2.5 more words"));
+	EXPECT_FALSE(pConsole->LineIsValid("args"));
+	EXPECT_FALSE(pConsole->LineIsValid("args number"));
+	EXPECT_FALSE(pConsole->LineIsValid("args 1 decimal"));
+
+	pConsole->ExecuteLine("args 1", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Call.m_NumArguments, 1);
+	pConsole->ExecuteLine("args 1 2.5 more words", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Call.m_NumArguments, 3);
+	EXPECT_STREQ(Call.m_aLastArgument, "more words");
+	pConsole->ExecuteLine("args \"1\" \"2.5\"", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Call.m_NumArguments, 2);
+	EXPECT_STREQ(Call.m_aLastArgument, "2.5");
+	EXPECT_EQ(Call.m_NumCalls, 3);
+}
@@ -1,5 +1,9 @@
 #include "test.h"
 
+#include <base/io.h>
+#include <base/mem.h>
+#include <base/str.h>
+
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
@@ -8,6 +12,8 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +118,110 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, DataCache)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+	char aCacheDirectory[IO_MAX_PATH_LENGTH];
+	Info.Filename(aCacheDirectory, sizeof(aCacheDirectory), "_cache");
+
+	std::vector<int> vLargeData(64 * 1024);
+	for(size_t i = 0; i < vLargeData.size(); i++)
+		vLargeData[i] = i * 7;
+	const int LargeSize = vLargeData.size() * sizeof(int);
+
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		EXPECT_EQ(Writer.AddData(LargeSize, vLargeData.data()), 0);
+		EXPECT_EQ(Writer.AddDataString("Abc"), 1);
+		Writer.Finish();
+	}
+
+	const auto ListCacheFiles = [&]() {
+		std::vector<std::string> vFiles;
+		pStorage->ListDirectory(IStorage::TYPE_SAVE, aCacheDirectory, [](const char *pName, int IsDir, int, void *pUser) {
+			if(!IsDir)
+				static_cast<std::vector<std::string> *>(pUser)->emplace_back(pName);
+			return 0;
+		},
+			&vFiles);
+		return vFiles;
+	};
+
+	{
+		CDataFileReader Reader1;
+		ASSERT_TRUE(Reader1.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		Reader1.SetDataCache(pStorage.get(), aCacheDirectory);
+		int *pData1 = static_cast<int *>(Reader1.GetData(0));
+		ASSERT_TRUE(pData1);
+		ASSERT_EQ(Reader1.GetDataSize(0), LargeSize);
+		EXPECT_EQ(mem_comp(pData1, vLargeData.data(), LargeSize), 0);
+		EXPECT_STREQ(Reader1.GetDataString(1), "Abc");
+
+		// only the large data is cached
+		EXPECT_EQ(ListCacheFiles().size(), 1u);
+
+		// the second reader maps the cached data, writes stay private
+		pData1[0] = -1;
+		CDataFileReader Reader2;
+		ASSERT_TRUE(Reader2.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		Reader2.SetDataCache(pStorage.get(), aCacheDirectory);
+		const int *pData2 = static_cast<const int *>(Reader2.GetData(0));
+		ASSERT_TRUE(pData2);
+		ASSERT_EQ(Reader2.GetDataSize(0), LargeSize);
+		EXPECT_EQ(mem_comp(pData2, vLargeData.data(), LargeSize), 0);
+
+		Reader2.UnloadData(0);
+		EXPECT_EQ(Reader2.GetDataSize(0), LargeSize);
+		Reader1.Close();
+		Reader2.Close();
+	}
+
+	const auto ReadCachedData = [&]() {
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		Reader.SetDataCache(pStorage.get(), aCacheDirectory);
+		const void *pData = Reader.GetData(0);
+		ASSERT_TRUE(pData);
+		ASSERT_EQ(Reader.GetDataSize(0), LargeSize);
+		EXPECT_EQ(mem_comp(pData, vLargeData.data(), LargeSize), 0);
+	};
+
+	// corrupted and truncated cache files are replaced
+	for(int Truncate = 0; Truncate <= 1; Truncate++)
+	{
+		const std::vector<std::string> vFiles = ListCacheFiles();
+		ASSERT_EQ(vFiles.size(), 1u);
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", aCacheDirectory, vFiles[0].c_str());
+		void *pFileData;
+		unsigned FileSize;
+		ASSERT_TRUE(pStorage->ReadFile(aPath, IStorage::TYPE_SAVE, &pFileData, &FileSize));
+		static_cast<unsigned char *>(pFileData)[100] ^= 1;
+		IOHANDLE File = pStorage->OpenFile(aPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		EXPECT_EQ(io_write(File, pFileData, Truncate ? FileSize / 2 : FileSize), Truncate ? FileSize / 2 : FileSize);
+		io_close(File);
+		free(pFileData);
+
+		ReadCachedData();
+		ReadCachedData();
+		EXPECT_EQ(ListCacheFiles().size(), 1u);
+	}
+
+	if(!HasFailure())
+	{
+		for(const std::string &File : ListCacheFiles())
+		{
+			char aPath[IO_MAX_PATH_LENGTH];
+			str_format(aPath, sizeof(aPath), "%s/%s", aCacheDirectory, File.c_str());
+			pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE);
+		}
+		pStorage->RemoveFolder(aCacheDirectory, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
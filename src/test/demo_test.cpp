@@ -0,0 +1,155 @@
+#include "test.h"
+
+#include <base/bytes.h>
+#include <base/io.h>
+#include <base/mem.h>
+#include <base/str.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <gtest/gtest.h>
+
+static void RecordDemo(IStorage *pStorage, const char *pFilename, int AsyncBufferSize, int *pNumStalls)
+{
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecorder Recorder(&SnapshotDelta, true);
+	Recorder.SetAsyncBufferSize(AsyncBufferSize);
+
+	// the map data is not written by recorders without map data
+	SHA256_DIGEST Sha256 = {};
+	unsigned char aMapData[1] = {0};
+	ASSERT_EQ(Recorder.Start(pStorage, nullptr, pFilename, "0.6 626fce9a778df4d4", "test", Sha256, 0, "server", 0, aMapData, nullptr, nullptr, nullptr), 0);
+
+	for(int Tick = 1; Tick <= 1000; Tick++)
+	{
+		CSnapshotBuilder Builder;
+		Builder.Init();
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			// some characters stand still, so that deltas are not all the same size
+			CNetObj_Character Character;
+			mem_zero(&Character, sizeof(Character));
+			Character.m_Tick = Tick;
+			Character.m_X = i * 32 + (i % 3 ? Tick : 0);
+			Character.m_Y = i * 64;
+			Character.m_Health = 10;
+			Character.m_Weapon = i % NUM_WEAPONS;
+			ASSERT_TRUE(Builder.NewItem(NETOBJTYPE_CHARACTER, i, &Character, sizeof(Character)));
+		}
+		CSnapshotBuffer Buffer;
+		const int Size = Builder.Finish(&Buffer);
+		Recorder.RecordSnapshot(Tick, Buffer.AsSnapshot(), Size);
+
+		if(Tick % 7 == 0)
+		{
+			char aMessage[64];
+			str_format(aMessage, sizeof(aMessage), "message at tick %d", Tick);
+			Recorder.RecordMessage(aMessage, str_length(aMessage) + 1);
+		}
+		if(Tick % 250 == 0)
+			Recorder.AddDemoMarker(Tick);
+	}
+
+	EXPECT_EQ(Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE), 0);
+	*pNumStalls = Recorder.NumAsyncStalls();
+}
+
+TEST(Demo, AsyncRecordingIsIdentical)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	int NumStalls = -1;
+	RecordDemo(pStorage.get(), "sync.demo", 0, &NumStalls);
+	EXPECT_EQ(NumStalls, 0);
+	// the smallest possible buffer, which has to wrap around many times
+	RecordDemo(pStorage.get(), "async.demo", 1, &NumStalls);
+	// the writer must have waited for the thread instead of falling back
+	EXPECT_GT(NumStalls, 0);
+
+	void *pSync;
+	unsigned SyncSize;
+	void *pAsync;
+	unsigned AsyncSize;
+	ASSERT_TRUE(pStorage->ReadFile("sync.demo", IStorage::TYPE_SAVE, &pSync, &SyncSize));
+	ASSERT_TRUE(pStorage->ReadFile("async.demo", IStorage::TYPE_SAVE, &pAsync, &AsyncSize));
+	ASSERT_EQ(SyncSize, AsyncSize);
+	ASSERT_GT(SyncSize, sizeof(CDemoHeader));
+
+	// the recording timestamps may differ
+	mem_zero(((CDemoHeader *)pSync)->m_aTimestamp, sizeof(CDemoHeader::m_aTimestamp));
+	mem_zero(((CDemoHeader *)pAsync)->m_aTimestamp, sizeof(CDemoHeader::m_aTimestamp));
+	EXPECT_EQ(mem_comp(pSync, pAsync, SyncSize), 0);
+
+	free(pSync);
+	free(pAsync);
+}
+
+TEST(Demo, KeyFrameIndex)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	// the chunks are only decompressed correctly with initialized huffman tables
+	CNetBase::Init();
+	int NumStalls = -1;
+	RecordDemo(pStorage.get(), "indexed.demo", 0, &NumStalls);
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoPlayer Player(&SnapshotDelta, &SnapshotDelta, false);
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "indexed.demo", IStorage::TYPE_SAVE), 0);
+	EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 1);
+	EXPECT_EQ(Player.BaseInfo()->m_LastTick, 1000);
+	ASSERT_TRUE(Player.SaveIndex(pStorage.get()));
+	Player.Stop();
+
+	char aIndexFilename[IO_MAX_PATH_LENGTH];
+	CDemoPlayer::IndexFilename("indexed.demo", aIndexFilename, sizeof(aIndexFilename));
+	EXPECT_STREQ(aIndexFilename, "indexed.demo.idx");
+
+	// the ticks come from the index, which is only used if it matches the demo
+	void *pIndex;
+	unsigned IndexSize;
+	ASSERT_TRUE(pStorage->ReadFile(aIndexFilename, IStorage::TYPE_SAVE, &pIndex, &IndexSize));
+	const unsigned LastTickOffset = 8 + 4 + 8 + 4;
+	ASSERT_GT(IndexSize, LastTickOffset + 4);
+	unsigned char *pLastTick = (unsigned char *)pIndex + LastTickOffset;
+	EXPECT_EQ(bytes_be_to_uint(pLastTick), 1000u);
+	uint_to_bytes_be(pLastTick, 1010);
+	IOHANDLE File = pStorage->OpenFile(aIndexFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, pIndex, IndexSize), IndexSize);
+	EXPECT_EQ(io_close(File), 0);
+	free(pIndex);
+
+	// the index is next to the demo, whichever storage type finds it
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "indexed.demo", IStorage::TYPE_ALL), 0);
+	EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 1);
+	EXPECT_EQ(Player.BaseInfo()->m_LastTick, 1010);
+
+	// seeking uses the keyframes of the index
+	EXPECT_TRUE(Player.SetPos(600)) << Player.ErrorMessage();
+	EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, 599);
+	EXPECT_TRUE(Player.SetPos(20));
+	EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, 19);
+	Player.Stop();
+
+	// an index of a different version of the demo is ignored
+	File = pStorage->OpenFile("indexed.demo", IOFLAG_APPEND, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	const unsigned char Padding = 0;
+	EXPECT_EQ(io_write(File, &Padding, sizeof(Padding)), sizeof(Padding));
+	EXPECT_EQ(io_close(File), 0);
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "indexed.demo", IStorage::TYPE_SAVE), 0);
+	EXPECT_EQ(Player.BaseInfo()->m_LastTick, 1000);
+	Player.Stop();
+}
@@ -0,0 +1,146 @@
+#include "test.h"
+
+#include <base/mem.h>
+
+#include <engine/map.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static const int NUM_CHARACTERS = MAX_CLIENTS;
+static const int NUM_TICKS = 1000;
+
+class CCoreWorld
+{
+public:
+	CWorldCore m_Core;
+	CTeamsCore m_Teams;
+	CCharacterCore m_aCharacters[NUM_CHARACTERS];
+
+	void Init(CCollision *pCollision, const std::vector<vec2> &vSpawns, bool NoBroadphase)
+	{
+		m_Core.m_NoBroadphase = NoBroadphase;
+		m_Teams.Reset();
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CCharacterCore &Character = m_aCharacters[i];
+			Character.Reset();
+			Character.Init(&m_Core, pCollision, &m_Teams);
+			Character.m_Id = i;
+			// two characters per spawn, overlapping, so that they push each other apart
+			Character.m_Pos = vSpawns[i / 2 % vSpawns.size()] + vec2(i % 2 ? 6.0f : -6.0f, 0.0f);
+			mem_zero(&Character.m_Input, sizeof(Character.m_Input));
+			Character.m_Input.m_TargetY = -1;
+			m_Core.m_apCharacters[i] = &Character;
+		}
+	}
+
+	void Tick(const CNetObj_PlayerInput *pInputs)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			m_aCharacters[i].m_Input = pInputs[i];
+			m_aCharacters[i].Tick(true);
+		}
+		for(auto &Character : m_aCharacters)
+		{
+			Character.Move();
+			Character.Quantize();
+		}
+	}
+};
+
+TEST(GameCore, BroadphaseIsDeterministic)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+	std::unique_ptr<IMap> pMap = CreateMap();
+	ASSERT_TRUE(pMap->Load(pStorage.get(), "maps/coverage.map", IStorage::TYPE_ALL));
+
+	CLayers Layers;
+	Layers.Init(pMap.get(), true, false);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	// free tiles around the spawns, to start in a crowd
+	std::vector<vec2> vSpawns;
+	for(int y = 1; y < Collision.GetHeight() - 1; y++)
+	{
+		for(int x = 1; x < Collision.GetWidth() - 1; x++)
+		{
+			const int Entity = Collision.GetTileIndex(y * Collision.GetWidth() + x) - ENTITY_OFFSET;
+			if(Entity == ENTITY_SPAWN || Entity == ENTITY_SPAWN_RED || Entity == ENTITY_SPAWN_BLUE)
+			{
+				for(int Dx = -3; Dx <= 3; Dx++)
+				{
+					const vec2 Pos = vec2((x + Dx) * 32.0f + 16.0f, y * 32.0f + 16.0f);
+					if(!Collision.CheckPoint(Pos))
+						vSpawns.push_back(Pos);
+				}
+			}
+		}
+	}
+	ASSERT_FALSE(vSpawns.empty());
+
+	// both worlds are heap allocated because of the tuning of every character
+	std::unique_ptr<CCoreWorld> pExhaustive = std::make_unique<CCoreWorld>();
+	std::unique_ptr<CCoreWorld> pBroadphase = std::make_unique<CCoreWorld>();
+	pExhaustive->Init(&Collision, vSpawns, true);
+	pBroadphase->Init(&Collision, vSpawns, false);
+
+	// record the inputs once, aiming at other players to hook them
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x5eed, 0x1234};
+	Prng.Seed(aSeed);
+	std::vector<CNetObj_PlayerInput> vInputs(NUM_TICKS * NUM_CHARACTERS);
+	for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_PlayerInput &Input = vInputs[Tick * NUM_CHARACTERS + i];
+			mem_zero(&Input, sizeof(Input));
+			Input.m_Direction = (int)(Prng.RandomBits() % 3) - 1;
+			Input.m_TargetX = (int)(Prng.RandomBits() % 401) - 200;
+			Input.m_TargetY = (int)(Prng.RandomBits() % 401) - 200;
+			if(Input.m_TargetX == 0 && Input.m_TargetY == 0)
+				Input.m_TargetY = -1;
+			Input.m_Jump = Prng.RandomBits() % 6 == 0;
+			Input.m_Hook = Prng.RandomBits() % 3 != 0;
+		}
+	}
+
+	int NumPlayerHooks = 0;
+	for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		pExhaustive->Tick(&vInputs[Tick * NUM_CHARACTERS]);
+		pBroadphase->Tick(&vInputs[Tick * NUM_CHARACTERS]);
+
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			const CCharacterCore &Expected = pExhaustive->m_aCharacters[i];
+			const CCharacterCore &Actual = pBroadphase->m_aCharacters[i];
+			CNetObj_CharacterCore ExpectedObj = {};
+			CNetObj_CharacterCore ActualObj = {};
+			Expected.Write(&ExpectedObj);
+			Actual.Write(&ActualObj);
+			ASSERT_EQ(mem_comp(&ExpectedObj, &ActualObj, sizeof(ExpectedObj)), 0) << "character " << i << " differs at tick " << Tick;
+			ASSERT_EQ(Expected.m_Pos, Actual.m_Pos) << "character " << i << " differs at tick " << Tick;
+			ASSERT_EQ(Expected.m_Vel, Actual.m_Vel) << "character " << i << " differs at tick " << Tick;
+			ASSERT_EQ(Expected.m_TriggeredEvents, Actual.m_TriggeredEvents) << "character " << i << " differs at tick " << Tick;
+			if(Expected.m_TriggeredEvents & COREEVENT_HOOK_ATTACH_PLAYER)
+				NumPlayerHooks++;
+		}
+	}
+	// make sure that the inputs actually test player interactions
+	EXPECT_GT(NumPlayerHooks, 0);
+}
@@ -16,7 +16,13 @@
 
 #include <generated/protocol.h>
 
+#include <game/collision.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
 #include <game/server/entities/character.h>
+#include <game/server/entities/light.h>
+#include <game/server/entities/pickup.h>
+#include <game/server/entities/projectile.h>
 #include <game/server/gamecontext.h>
 #include <game/server/gamecontroller.h>
 #include <game/server/gameworld.h>
@@ -25,9 +31,12 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <thread>
+#include <vector>
 
 bool IsInterrupted()
 {
@@ -239,7 +248,7 @@ TEST_F(GameWorld, IntersectEntity)
 
 	vec2 CloserToFromButTooFarFromLine = vec2(11, 11 + Radius + pChrLeft->GetProximityRadius());
 	pChrLeft->SetPosition(CloserToFromButTooFarFromLine);
-	pChrLeft->m_Pos = CloserToFromButTooFarFromLine;
+	pChrLeft->SetPos(CloserToFromButTooFarFromLine);
 
 	pIntersectedChar = (CCharacter *)GameServer()->m_World.IntersectEntity(
 		vec2(10, 10), // intersect from
@@ -253,6 +262,283 @@ TEST_F(GameWorld, IntersectEntity)
 	EXPECT_EQ(pIntersectedChar, pChrRight);
 }
 
+static float RandomFloat(CPrng &Prng, float Min, float Max)
+{
+	return Min + (Prng.RandomBits() % 100001) / 100000.0f * (Max - Min);
+}
+
+// reference implementation of CGameWorld::FindEntities walking the type list
+static int FindEntitiesLinear(CGameWorld &World, vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
+{
+	int Num = 0;
+	for(CEntity *pEnt = World.FindFirst(Type); pEnt && Num < Max; pEnt = pEnt->TypeNext())
+	{
+		if(distance(pEnt->GetPos(), Pos) < Radius + pEnt->GetProximityRadius())
+			ppEnts[Num++] = pEnt;
+	}
+	return Num;
+}
+
+TEST_F(GameWorld, SpatialIndexMatchesTypeList)
+{
+	CGameWorld &World = GameServer()->m_World;
+	const vec2 MapSize = vec2(GameServer()->Collision()->GetWidth() * 32.0f, GameServer()->Collision()->GetHeight() * 32.0f);
+	uint64_t aSeed[2] = {1, 2};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+	auto RandomPos = [&]() {
+		// also place entities outside of the map
+		return vec2(RandomFloat(Prng, -500.0f, MapSize.x + 500.0f), RandomFloat(Prng, -500.0f, MapSize.y + 500.0f));
+	};
+
+	CNetObj_PlayerInput Input = {};
+	std::vector<CEntity *> vpCharacters;
+	for(int i = 0; i < 48; i++)
+	{
+		CCharacter *pChr = new(i) CCharacter(&World, Input);
+		pChr->m_Pos = RandomPos();
+		World.InsertEntity(pChr);
+		vpCharacters.push_back(pChr);
+	}
+	std::vector<CEntity *> vpPickups;
+	for(int i = 0; i < 400; i++)
+	{
+		CPickup *pPickup = new CPickup(&World, POWERUP_HEALTH, 0, 0, 0, 0);
+		pPickup->SetPos(RandomPos());
+		vpPickups.push_back(pPickup);
+	}
+
+	for(int Iteration = 0; Iteration < 2000; Iteration++)
+	{
+		// move, remove and re-insert some entities
+		for(int i = 0; i < 8; i++)
+		{
+			CEntity *pEnt = (Prng.RandomBits() % 2) ? vpCharacters[Prng.RandomBits() % vpCharacters.size()] : vpPickups[Prng.RandomBits() % vpPickups.size()];
+			if(Prng.RandomBits() % 4 == 0)
+			{
+				World.RemoveEntity(pEnt);
+				pEnt->m_Pos = RandomPos();
+				World.InsertEntity(pEnt);
+			}
+			else
+			{
+				pEnt->SetPos(pEnt->GetPos() + vec2(RandomFloat(Prng, -300.0f, 300.0f), RandomFloat(Prng, -300.0f, 300.0f)));
+			}
+		}
+
+		const vec2 Pos = RandomPos();
+		const vec2 To = Pos + vec2(RandomFloat(Prng, -1000.0f, 1000.0f), RandomFloat(Prng, -1000.0f, 1000.0f));
+		const float Radius = RandomFloat(Prng, 0.0f, 800.0f);
+		const int Max = 1 + Prng.RandomBits() % 16;
+
+		for(int Type : {(int)CGameWorld::ENTTYPE_CHARACTER, (int)CGameWorld::ENTTYPE_PICKUP})
+		{
+			CEntity *apExpected[16];
+			CEntity *apFound[16];
+			const int NumExpected = FindEntitiesLinear(World, Pos, Radius, apExpected, Max, Type);
+			const int NumFound = World.FindEntities(Pos, Radius, apFound, Max, Type);
+			ASSERT_EQ(NumFound, NumExpected);
+			for(int i = 0; i < NumFound; i++)
+				EXPECT_EQ(apFound[i], apExpected[i]);
+		}
+
+		// closest hit along the line, first one in list order on ties
+		CEntity *pExpectedHit = nullptr;
+		vec2 ExpectedHitPos = vec2(0, 0);
+		float ClosestLen = distance(Pos, To) * 100.0f;
+		std::vector<CCharacter *> vpExpectedIntersected;
+		for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		{
+			vec2 IntersectPos;
+			if(closest_point_on_line(Pos, To, pEnt->GetPos(), IntersectPos) && distance(pEnt->GetPos(), IntersectPos) < pEnt->GetProximityRadius() + Radius / 8.0f)
+			{
+				vpExpectedIntersected.push_back((CCharacter *)pEnt);
+				if(distance(Pos, IntersectPos) < ClosestLen)
+				{
+					ClosestLen = distance(Pos, IntersectPos);
+					ExpectedHitPos = IntersectPos;
+					pExpectedHit = pEnt;
+				}
+			}
+		}
+		vec2 HitPos = vec2(0, 0);
+		EXPECT_EQ(World.IntersectCharacter(Pos, To, Radius / 8.0f, HitPos), pExpectedHit);
+		if(pExpectedHit)
+		{
+			EXPECT_EQ(HitPos, ExpectedHitPos);
+		}
+		EXPECT_EQ(World.IntersectedCharacters(Pos, To, Radius / 8.0f), vpExpectedIntersected);
+
+		CEntity *pExpectedClosest = nullptr;
+		float ClosestRange = Radius * 2;
+		for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		{
+			const float Len = distance(Pos, pEnt->GetPos());
+			if(Len < pEnt->GetProximityRadius() + Radius && Len < ClosestRange)
+			{
+				ClosestRange = Len;
+				pExpectedClosest = pEnt;
+			}
+		}
+		EXPECT_EQ(World.ClosestCharacter(Pos, Radius, nullptr), pExpectedClosest);
+	}
+}
+
+// Only measures, run it with `--gtest_also_run_disabled_tests`.
+TEST_F(GameWorld, DISABLED_SpatialIndexBenchmark)
+{
+	CGameWorld &World = GameServer()->m_World;
+	const vec2 MapSize = vec2(GameServer()->Collision()->GetWidth() * 32.0f, GameServer()->Collision()->GetHeight() * 32.0f);
+	uint64_t aSeed[2] = {3, 4};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+
+	for(int i = 0; i < 500; i++)
+	{
+		CPickup *pPickup = new CPickup(&World, POWERUP_HEALTH, 0, 0, 0, 0);
+		pPickup->SetPos(vec2(RandomFloat(Prng, 0.0f, MapSize.x), RandomFloat(Prng, 0.0f, MapSize.y)));
+	}
+
+	const int NumQueries = 20000;
+	std::vector<vec2> vQueries;
+	for(int i = 0; i < NumQueries; i++)
+		vQueries.emplace_back(RandomFloat(Prng, 0.0f, MapSize.x), RandomFloat(Prng, 0.0f, MapSize.y));
+
+	CEntity *apEnts[MAX_CLIENTS];
+	int NumLinear = 0;
+	const int64_t StartLinear = time_get_impl();
+	for(const vec2 &Pos : vQueries)
+		NumLinear += FindEntitiesLinear(World, Pos, 64.0f, apEnts, std::size(apEnts), CGameWorld::ENTTYPE_PICKUP);
+	const int64_t TimeLinear = time_get_impl() - StartLinear;
+
+	int NumGrid = 0;
+	const int64_t StartGrid = time_get_impl();
+	for(const vec2 &Pos : vQueries)
+		NumGrid += World.FindEntities(Pos, 64.0f, apEnts, std::size(apEnts), CGameWorld::ENTTYPE_PICKUP);
+	const int64_t TimeGrid = time_get_impl() - StartGrid;
+
+	EXPECT_EQ(NumGrid, NumLinear);
+	log_info("gameworld", "FindEntities with 500 pickups, %d queries: type list %.3fms, grid %.3fms",
+		NumQueries, TimeLinear * 1000.0 / time_freq(), TimeGrid * 1000.0 / time_freq());
+}
+
+TEST_F(GameWorld, SnapCullingMatchesFullSnap)
+{
+	CGameWorld &World = GameServer()->m_World;
+	const vec2 MapSize = vec2(GameServer()->Collision()->GetWidth() * 32.0f, GameServer()->Collision()->GetHeight() * 32.0f);
+	uint64_t aSeed[2] = {5, 6};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+	auto RandomPos = [&]() {
+		return vec2(RandomFloat(Prng, -500.0f, MapSize.x + 500.0f), RandomFloat(Prng, -500.0f, MapSize.y + 500.0f));
+	};
+
+	int ClientId = 0;
+	CPlayer *pPlayer = GameServer()->CreatePlayer(ClientId, TEAM_SPECTATORS, false, -1);
+	std::vector<CEntity *> vpPickups;
+	for(int i = 0; i < 300; i++)
+	{
+		CPickup *pPickup = new CPickup(&World, POWERUP_HEALTH, 0, 0, 0, 0);
+		pPickup->SetPos(RandomPos());
+		vpPickups.push_back(pPickup);
+	}
+	for(int i = 0; i < 50; i++)
+		new CLight(&World, RandomPos(), RandomFloat(Prng, 0.0f, 2 * pi), 32 + Prng.RandomBits() % 1000, LAYER_GAME, 0);
+
+	CSnapshotBuffer Buffer;
+	for(int Iteration = 0; Iteration < 200; Iteration++)
+	{
+		for(int i = 0; i < 8; i++)
+			vpPickups[Prng.RandomBits() % vpPickups.size()]->SetPos(RandomPos());
+		pPlayer->m_ViewPos = RandomPos();
+		pPlayer->m_NetworkClipRadius = vec2(RandomFloat(Prng, 100.0f, 2000.0f), RandomFloat(Prng, 100.0f, 2000.0f));
+
+		std::vector<int> vCulled;
+		m_pServer->m_SnapshotBuilder.Init();
+		m_pServer->SnapStartRecording(&vCulled);
+		World.Snap(ClientId);
+		m_pServer->SnapStopRecording();
+		m_pServer->m_SnapshotBuilder.Finish(&Buffer);
+
+		// reference: every entity in type list order
+		std::vector<int> vFull;
+		m_pServer->m_SnapshotBuilder.Init();
+		m_pServer->SnapStartRecording(&vFull);
+		for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+			for(CEntity *pEnt = World.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+				pEnt->Snap(ClientId);
+		m_pServer->SnapStopRecording();
+		m_pServer->m_SnapshotBuilder.Finish(&Buffer);
+
+		EXPECT_EQ(vCulled, vFull);
+	}
+}
+
+TEST_F(GameWorld, SharedSpectatorSnapshotsMatchOwnSnapshots)
+{
+	// the grenade must not explode on its first tick
+	const CCollision &Collision = *GameServer()->Collision();
+	vec2 Pos = vec2(-1.0f, -1.0f);
+	for(int y = 8; y < Collision.GetHeight() - 8 && Pos.x < 0.0f; y++)
+		for(int x = 8; x < Collision.GetWidth() - 8 && Pos.x < 0.0f; x++)
+			if(!Collision.CheckPoint(vec2(x, y) * 32.0f) && !Collision.IntersectLine(vec2(x, y) * 32.0f, vec2(x + 8, y) * 32.0f, nullptr, nullptr))
+				Pos = vec2(x, y) * 32.0f;
+	ASSERT_GE(Pos.x, 0.0f);
+
+	const int aSpectators[] = {0, 1};
+	for(int ClientId : aSpectators)
+	{
+		m_pServer->m_aClients[ClientId].m_DDNetVersion = VERSION_DDNET_128_PLAYERS;
+		CPlayer *pPlayer = GameServer()->CreatePlayer(ClientId, TEAM_SPECTATORS, false, -1);
+		pPlayer->m_ViewPos = Pos;
+		pPlayer->m_NetworkClipRadius = vec2(1000.0f, 1000.0f);
+	}
+
+	// the owner is in another team than the spectators, only the first one
+	// sees its grenade when it is fired
+	const int Owner = 2;
+	CPlayer *pOwner = GameServer()->CreatePlayer(Owner, TEAM_GAME, false, -1);
+	pOwner->ForceSpawn(Pos);
+	ASSERT_NE(pOwner->GetCharacter(), nullptr);
+	GameServer()->m_pController->Teams().SetForceCharacterTeam(Owner, 1);
+	GameServer()->m_apPlayers[0]->m_SpecTeam = false;
+	GameServer()->m_apPlayers[1]->m_SpecTeam = true;
+	CProjectile *pProjectile = new CProjectile(&GameServer()->m_World, WEAPON_GRENADE, Owner, Pos, vec2(1.0f, 0.0f), 100, false, true, SOUND_GRENADE_EXPLODE, vec2(1.0f, 0.0f));
+	pProjectile->Tick();
+
+	// both spectators have the same view now, but the grenade keeps the
+	// client mask computed when it was fired
+	GameServer()->m_apPlayers[0]->m_SpecTeam = true;
+
+	CSnapshotBuffer aaBuffers[2][std::size(aSpectators)];
+	for(int Shared = 0; Shared < 2; Shared++)
+	{
+		m_pServer->Config()->m_SvSharedSpectatorSnapshots = Shared;
+		for(int ClientId : aSpectators)
+		{
+			m_pServer->m_SnapshotBuilder.Init();
+			GameServer()->OnSnap(ClientId, true, false);
+			m_pServer->m_SnapshotBuilder.Finish(&aaBuffers[Shared][ClientId]);
+		}
+	}
+
+	// only the first spectator receives the grenade
+	EXPECT_NE(aaBuffers[0][0].AsSnapshot()->NumItems(), aaBuffers[0][1].AsSnapshot()->NumItems());
+	for(int ClientId : aSpectators)
+	{
+		const CSnapshot *pOwn = aaBuffers[0][ClientId].AsSnapshot();
+		const CSnapshot *pShared = aaBuffers[1][ClientId].AsSnapshot();
+		ASSERT_EQ(pOwn->NumItems(), pShared->NumItems()) << "ClientId=" << ClientId;
+		for(int i = 0; i < pOwn->NumItems(); i++)
+		{
+			const int Index = pShared->GetItemIndex(pOwn->GetItem(i)->Key());
+			ASSERT_GE(Index, 0) << "ClientId=" << ClientId;
+			ASSERT_EQ(pOwn->GetItemSize(i), pShared->GetItemSize(Index));
+			EXPECT_EQ(mem_comp(pOwn->GetItem(i)->Data(), pShared->GetItem(Index)->Data(), pOwn->GetItemSize(i)), 0) << "ClientId=" << ClientId;
+		}
+	}
+}
+
 TEST_F(GameWorld, BasicTick)
 {
 	int ClientId = 0;
@@ -309,6 +595,276 @@ TEST_F(GameWorld, CharacterEmote)
 	ASSERT_EQ(pChr->DetermineEyeEmote(), EMOTE_ANGRY);
 }
 
+// per-pixel samplers that the tile walker in CCollision replaced
+static int IntersectLineSampled(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int IntersectLineTeleHookSampled(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	int dx = 0, dy = 0;
+	ThroughOffset(Pos0, Pos1, &dx, &dy);
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		int Index = Collision.GetPureMapIndex(Pos);
+		*pTeleNr = g_Config.m_SvOldTeleportHook ? Collision.IsTeleport(Index) : Collision.IsTeleportHook(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINHOOK;
+		}
+		int Hit = 0;
+		if(Collision.CheckPoint(ix, iy))
+		{
+			if(!Collision.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+				Hit = Collision.GetCollisionAt(ix, iy);
+		}
+		else if(Collision.IsHookBlocker(ix, iy, Pos0, Pos1))
+		{
+			Hit = TILE_NOHOOK;
+		}
+		if(Hit)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Hit;
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int IntersectLineTeleWeaponSampled(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		int Index = Collision.GetPureMapIndex(Pos);
+		*pTeleNr = g_Config.m_SvOldTeleportWeapons ? Collision.IsTeleport(Index) : Collision.IsTeleportWeapon(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINWEAPON;
+		}
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int IntersectNoLaserSampled(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, Collision.GetWidth() - 1);
+		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, Collision.GetHeight() - 1);
+		if(Collision.GetIndex(Nx, Ny) == TILE_SOLID || Collision.GetIndex(Nx, Ny) == TILE_NOHOOK || Collision.GetIndex(Nx, Ny) == TILE_NOLASER || Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+				return Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+			return Collision.GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static std::vector<int> GetMapIndicesSampled(const CCollision &Collision, vec2 PrevPos, vec2 Pos, unsigned MaxIndices)
+{
+	std::vector<int> vIndices;
+	float d = distance(PrevPos, Pos);
+	int End(d + 1);
+	if(!d)
+		return Collision.GetMapIndices(PrevPos, Pos, MaxIndices);
+	int LastIndex = 0;
+	for(int i = 0; i < End; i++)
+	{
+		float a = i / d;
+		vec2 Tmp = mix(PrevPos, Pos, a);
+		int Nx = std::clamp((int)Tmp.x / 32, 0, Collision.GetWidth() - 1);
+		int Ny = std::clamp((int)Tmp.y / 32, 0, Collision.GetHeight() - 1);
+		int Index = Ny * Collision.GetWidth() + Nx;
+		if(Collision.TileExists(Index) && LastIndex != Index)
+		{
+			if(MaxIndices && vIndices.size() > MaxIndices)
+				return vIndices;
+			vIndices.push_back(Index);
+			LastIndex = Index;
+		}
+	}
+	return vIndices;
+}
+
+static void RandomLine(CPrng &Prng, vec2 MapSize, vec2 *pPos0, vec2 *pPos1)
+{
+	auto RandomCoord = [&](float Max) {
+		switch(Prng.RandomBits() % 4)
+		{
+		case 0: return (float)(32 * (int)(Prng.RandomBits() % (int)(Max / 32)));
+		case 1: return 32 * (int)(Prng.RandomBits() % (int)(Max / 32)) + 0.5f;
+		case 2: return 32 * (int)(Prng.RandomBits() % (int)(Max / 32)) - 0.5f;
+		default: return RandomFloat(Prng, -500.0f, Max + 500.0f);
+		}
+	};
+	*pPos0 = vec2(RandomCoord(MapSize.x), RandomCoord(MapSize.y));
+	switch(Prng.RandomBits() % 4)
+	{
+	case 0: // axis aligned
+		*pPos1 = *pPos0 + ((Prng.RandomBits() % 2) ? vec2(RandomFloat(Prng, -1000.0f, 1000.0f), 0.0f) : vec2(0.0f, RandomFloat(Prng, -1000.0f, 1000.0f)));
+		break;
+	case 1: // diagonal
+	{
+		const float Length = RandomFloat(Prng, -800.0f, 800.0f);
+		*pPos1 = *pPos0 + vec2(Length, (Prng.RandomBits() % 2) ? Length : -Length);
+		break;
+	}
+	case 2: // short
+		*pPos1 = *pPos0 + vec2(RandomFloat(Prng, -40.0f, 40.0f), RandomFloat(Prng, -40.0f, 40.0f));
+		break;
+	default:
+		*pPos1 = vec2(RandomCoord(MapSize.x), RandomCoord(MapSize.y));
+		break;
+	}
+}
+
+TEST_F(GameWorld, IntersectLineMatchesSampler)
+{
+	CCollision &Collision = *GameServer()->Collision();
+	const vec2 MapSize = vec2(Collision.GetWidth() * 32.0f, Collision.GetHeight() * 32.0f);
+	uint64_t aSeed[2] = {7, 8};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+
+	// sprinkle collision, through and hook blocker tiles over the map
+	const int aTiles[] = {TILE_AIR, TILE_SOLID, TILE_NOHOOK, TILE_NOLASER, TILE_THROUGH, TILE_THROUGH_ALL, TILE_THROUGH_CUT, TILE_FREEZE};
+	for(int i = 0; i < Collision.GetWidth() * Collision.GetHeight() / 40; i++)
+		Collision.SetCollisionAt(RandomFloat(Prng, 0.0f, MapSize.x), RandomFloat(Prng, 0.0f, MapSize.y), aTiles[Prng.RandomBits() % std::size(aTiles)]);
+
+	const int OldTeleportHook = g_Config.m_SvOldTeleportHook;
+	const int OldTeleportWeapons = g_Config.m_SvOldTeleportWeapons;
+	for(int Iteration = 0; Iteration < 20000; Iteration++)
+	{
+		g_Config.m_SvOldTeleportHook = Iteration % 2;
+		g_Config.m_SvOldTeleportWeapons = Iteration % 2;
+		vec2 Pos0, Pos1;
+		RandomLine(Prng, MapSize, &Pos0, &Pos1);
+
+		vec2 Collision0, Before0, Collision1, Before1;
+		int TeleNr0 = 0, TeleNr1 = 0;
+		EXPECT_EQ(Collision.IntersectLine(Pos0, Pos1, &Collision0, &Before0), IntersectLineSampled(Collision, Pos0, Pos1, &Collision1, &Before1));
+		EXPECT_EQ(Collision0, Collision1);
+		EXPECT_EQ(Before0, Before1);
+
+		EXPECT_EQ(Collision.IntersectLineTeleHook(Pos0, Pos1, &Collision0, &Before0, &TeleNr0), IntersectLineTeleHookSampled(Collision, Pos0, Pos1, &Collision1, &Before1, &TeleNr1));
+		EXPECT_EQ(Collision0, Collision1);
+		EXPECT_EQ(Before0, Before1);
+		EXPECT_EQ(TeleNr0, TeleNr1);
+
+		EXPECT_EQ(Collision.IntersectLineTeleWeapon(Pos0, Pos1, &Collision0, &Before0, &TeleNr0), IntersectLineTeleWeaponSampled(Collision, Pos0, Pos1, &Collision1, &Before1, &TeleNr1));
+		EXPECT_EQ(Collision0, Collision1);
+		EXPECT_EQ(Before0, Before1);
+		EXPECT_EQ(TeleNr0, TeleNr1);
+
+		EXPECT_EQ(Collision.IntersectNoLaser(Pos0, Pos1, &Collision0, &Before0), IntersectNoLaserSampled(Collision, Pos0, Pos1, &Collision1, &Before1));
+		EXPECT_EQ(Collision0, Collision1);
+		EXPECT_EQ(Before0, Before1);
+
+		const unsigned MaxIndices = Prng.RandomBits() % 8;
+		EXPECT_EQ(Collision.GetMapIndices(Pos0, Pos1, MaxIndices), GetMapIndicesSampled(Collision, Pos0, Pos1, MaxIndices));
+	}
+	g_Config.m_SvOldTeleportHook = OldTeleportHook;
+	g_Config.m_SvOldTeleportWeapons = OldTeleportWeapons;
+}
+
+// Only measures, run it with `--gtest_also_run_disabled_tests`.
+TEST_F(GameWorld, DISABLED_IntersectLineBenchmark)
+{
+	const CCollision &Collision = *GameServer()->Collision();
+	const vec2 MapSize = vec2(Collision.GetWidth() * 32.0f, Collision.GetHeight() * 32.0f);
+	uint64_t aSeed[2] = {9, 10};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+
+	// hook length sized lines
+	const int NumLines = 50000;
+	std::vector<std::pair<vec2, vec2>> vLines;
+	for(int i = 0; i < NumLines; i++)
+	{
+		const vec2 Pos = vec2(RandomFloat(Prng, 0.0f, MapSize.x), RandomFloat(Prng, 0.0f, MapSize.y));
+		vLines.emplace_back(Pos, Pos + direction(RandomFloat(Prng, 0.0f, 2 * pi)) * 700.0f);
+	}
+
+	vec2 Out, Before;
+	int HitsSampled = 0;
+	const int64_t StartSampled = time_get_impl();
+	for(const auto &[Pos0, Pos1] : vLines)
+		HitsSampled += IntersectLineSampled(Collision, Pos0, Pos1, &Out, &Before) != 0;
+	const int64_t TimeSampled = time_get_impl() - StartSampled;
+
+	int Hits = 0;
+	const int64_t Start = time_get_impl();
+	for(const auto &[Pos0, Pos1] : vLines)
+		Hits += Collision.IntersectLine(Pos0, Pos1, &Out, &Before) != 0;
+	const int64_t Time = time_get_impl() - Start;
+
+	EXPECT_EQ(Hits, HitsSampled);
+	log_info("gameworld", "IntersectLine with %d lines of length 700: per-pixel sampler %.3fms, tile walker %.3fms",
+		NumLines, TimeSampled * 1000.0 / time_freq(), Time * 1000.0 / time_freq());
+}
+
 TEST(Tunings, OutOfRangeBecomesIntMin)
 {
 	const float IntMin = std::numeric_limits<int>::min() / 100.0f;
@@ -149,6 +149,48 @@ TEST(Io, SyncWorks)
 	EXPECT_FALSE(fs_remove(Info.m_aFilename));
 }
 
+TEST(Io, Map)
+{
+	CTestInfo Info;
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_FALSE(io_close(File));
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	int64_t Size = -1;
+	EXPECT_FALSE(io_map(File, &Size));
+	EXPECT_EQ(Size, -1);
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, "0123456789", 10), 10);
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	char *pData = static_cast<char *>(io_map(File, &Size));
+	EXPECT_FALSE(io_close(File));
+	ASSERT_TRUE(pData);
+	EXPECT_EQ(Size, 10);
+	EXPECT_EQ(mem_comp(pData, "0123456789", 10), 0);
+
+	// writes must not change the file
+	pData[0] = 'X';
+	EXPECT_EQ(pData[0], 'X');
+	io_unmap(pData, Size);
+
+	char aBuf[16];
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_read(File, aBuf, sizeof(aBuf)), 10);
+	EXPECT_EQ(mem_comp(aBuf, "0123456789", 10), 0);
+	EXPECT_FALSE(io_close(File));
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
 TEST(Io, WriteTruncatesFile)
 {
 	CTestInfo Info;
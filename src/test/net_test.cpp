@@ -1,6 +1,7 @@
 #include <base/mem.h>
 #include <base/net.h>
 #include <base/secure.h>
+#include <base/str.h>
 
 #include <gtest/gtest.h>
 
@@ -54,3 +55,67 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+TEST(Net, SendBatch)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4 | NETTYPE_IPV6;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR TargetV4;
+	NETADDR TargetV6;
+	ASSERT_FALSE(net_addr_from_str(&TargetV4, "127.0.0.1"));
+	ASSERT_FALSE(net_addr_from_str(&TargetV6, "[::1]"));
+	TargetV4.port = Bindaddr.port;
+	TargetV6.port = Bindaddr.port;
+
+	// more packets than fit into one queue, alternating between the IPv4 and
+	// the IPv6 socket
+	const int NumPackets = 300;
+	NETSTATS StatsStart;
+	net_stats(&StatsStart);
+	net_udp_send_batch_begin(Socket2);
+	for(int i = 0; i < NumPackets; i++)
+	{
+		char aBuf[16];
+		str_format(aBuf, sizeof(aBuf), "%d", i);
+		EXPECT_EQ(net_udp_send(Socket2, i % 2 ? &TargetV6 : &TargetV4, aBuf, str_length(aBuf)), str_length(aBuf));
+	}
+	net_udp_send_batch_end(Socket2);
+	NETSTATS StatsEnd;
+	net_stats(&StatsEnd);
+	EXPECT_EQ(StatsEnd.sent_packets - StatsStart.sent_packets, (uint64_t)NumPackets);
+#if defined(CONF_PLATFORM_LINUX)
+	// one sendmmsg per socket and full queue
+	EXPECT_LE(StatsEnd.sent_syscalls - StatsStart.sent_syscalls, 6u);
+#else
+	EXPECT_EQ(StatsEnd.sent_syscalls - StatsStart.sent_syscalls, (uint64_t)NumPackets);
+#endif
+
+	// the packets of each address family arrive in order
+	int aNext[2] = {0, 1};
+	for(int Received = 0; Received < NumPackets; Received++)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		while((Bytes = net_udp_recv(Socket1, &Addr, &pData)) <= 0)
+			ASSERT_EQ(net_socket_read_wait(Socket1, 10s), 1);
+		const int Family = (Addr.type & NETTYPE_IPV6) ? 1 : 0;
+		char aExpected[16];
+		str_format(aExpected, sizeof(aExpected), "%d", aNext[Family]);
+		ASSERT_EQ(Bytes, str_length(aExpected));
+		EXPECT_EQ(mem_comp(pData, aExpected, Bytes), 0);
+		aNext[Family] += 2;
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
@@ -0,0 +1,211 @@
+#include "test.h"
+
+#include <base/io.h>
+#include <base/str.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+class CTestNetBan : public CNetBan
+{
+public:
+	using CNetBan::m_BanAddrPool;
+	using CNetBan::m_BanRangePool;
+
+	int m_NumBansLoaded = 0;
+	void OnBansLoaded() override { m_NumBansLoaded++; }
+};
+
+class NetBan : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	std::unique_ptr<IStorage> m_pStorage;
+	std::unique_ptr<IConsole> m_pConsole;
+	CTestNetBan m_NetBan;
+
+	void SetUp() override
+	{
+		m_Info.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_Info.CreateTestStorage();
+		ASSERT_TRUE(m_pStorage);
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pConsole->StoreCommands(false);
+		m_NetBan.Init(m_pConsole.get(), m_pStorage.get());
+	}
+
+	static NETADDR Addr(const char *pStr)
+	{
+		NETADDR Addr;
+		EXPECT_EQ(net_addr_from_str(&Addr, pStr), 0) << pStr;
+		return Addr;
+	}
+
+	static CNetRange Range(const char *pLB, const char *pUB)
+	{
+		CNetRange Range;
+		Range.m_LB = Addr(pLB);
+		Range.m_UB = Addr(pUB);
+		return Range;
+	}
+
+	bool IsBanned(const char *pAddr, char *pReason = nullptr, unsigned ReasonSize = 0)
+	{
+		const NETADDR Address = Addr(pAddr);
+		char aBuf[256];
+		return m_NetBan.IsBanned(&Address, pReason ? pReason : aBuf, pReason ? ReasonSize : sizeof(aBuf));
+	}
+};
+
+TEST_F(NetBan, Addr)
+{
+	const NETADDR Banned = Addr("1.2.3.4");
+	EXPECT_EQ(m_NetBan.BanAddr(&Banned, 0, "reason", false), 0);
+	EXPECT_EQ(m_NetBan.BanAddr(&Banned, 60, "reason", false), 1);
+	EXPECT_TRUE(IsBanned("1.2.3.4"));
+	EXPECT_TRUE(IsBanned("1.2.3.4:8303"));
+	EXPECT_FALSE(IsBanned("1.2.3.5"));
+	EXPECT_FALSE(IsBanned("[::102:304]"));
+
+	EXPECT_EQ(m_NetBan.UnbanByAddr(&Banned), 0);
+	EXPECT_FALSE(IsBanned("1.2.3.4"));
+	EXPECT_EQ(m_NetBan.UnbanByAddr(&Banned), -1);
+}
+
+TEST_F(NetBan, Localhost)
+{
+	const NETADDR Localhost = Addr("127.0.0.1");
+	EXPECT_EQ(m_NetBan.BanAddr(&Localhost, 0, "reason", false), -1);
+	const CNetRange LocalhostRange = Range("127.0.0.0", "127.0.0.255");
+	EXPECT_EQ(m_NetBan.BanRange(&LocalhostRange, 0, "reason"), -1);
+	EXPECT_FALSE(IsBanned("127.0.0.1"));
+}
+
+TEST_F(NetBan, ManyAddrs)
+{
+	// more than the previous limit of 2048 bans
+	for(int i = 0; i < 5000; i++)
+	{
+		char aAddr[NETADDR_MAXSTRSIZE];
+		str_format(aAddr, sizeof(aAddr), "10.%d.%d.1", i / 256, i % 256);
+		const NETADDR Banned = Addr(aAddr);
+		ASSERT_EQ(m_NetBan.BanAddr(&Banned, 0, "reason", false), 0);
+	}
+	EXPECT_EQ(m_NetBan.m_BanAddrPool.Num(), 5000);
+	EXPECT_TRUE(IsBanned("10.0.0.1"));
+	EXPECT_TRUE(IsBanned("10.19.135.1"));
+	EXPECT_FALSE(IsBanned("10.19.136.1"));
+	EXPECT_FALSE(IsBanned("10.0.0.2"));
+}
+
+TEST_F(NetBan, Range)
+{
+	// not aligned to any prefix
+	const CNetRange BannedV4 = Range("1.2.3.77", "1.2.5.3");
+	EXPECT_EQ(m_NetBan.BanRange(&BannedV4, 0, "reason"), 0);
+	EXPECT_FALSE(IsBanned("1.2.3.76"));
+	EXPECT_TRUE(IsBanned("1.2.3.77"));
+	EXPECT_TRUE(IsBanned("1.2.3.255"));
+	EXPECT_TRUE(IsBanned("1.2.4.0"));
+	EXPECT_TRUE(IsBanned("1.2.5.3"));
+	EXPECT_FALSE(IsBanned("1.2.5.4"));
+	EXPECT_FALSE(IsBanned("[102:34d::]"));
+
+	const CNetRange BannedV6 = Range("[2001:db8::ff]", "[2001:db8:0:1::]");
+	EXPECT_EQ(m_NetBan.BanRange(&BannedV6, 0, "reason"), 0);
+	EXPECT_FALSE(IsBanned("[2001:db8::fe]"));
+	EXPECT_TRUE(IsBanned("[2001:db8::ff]"));
+	EXPECT_TRUE(IsBanned("[2001:db8::ffff:ffff:ffff:ffff]"));
+	EXPECT_TRUE(IsBanned("[2001:db8:0:1::]"));
+	EXPECT_FALSE(IsBanned("[2001:db8:0:1::1]"));
+
+	EXPECT_EQ(m_NetBan.UnbanByRange(&BannedV4), 0);
+	EXPECT_FALSE(IsBanned("1.2.3.77"));
+	EXPECT_FALSE(IsBanned("1.2.4.0"));
+	EXPECT_TRUE(IsBanned("[2001:db8::ff]"));
+	EXPECT_EQ(m_NetBan.UnbanByRange(&BannedV6), 0);
+	EXPECT_FALSE(IsBanned("[2001:db8::ff]"));
+}
+
+TEST_F(NetBan, OverlappingRanges)
+{
+	const CNetRange Outer = Range("5.0.0.0", "5.255.255.255");
+	const CNetRange Inner = Range("5.1.1.0", "5.1.1.255");
+	EXPECT_EQ(m_NetBan.BanRange(&Outer, 0, "outer"), 0);
+	EXPECT_EQ(m_NetBan.BanRange(&Inner, 0, "inner"), 0);
+
+	// the most specific range is reported
+	char aReason[256];
+	EXPECT_TRUE(IsBanned("5.1.1.1", aReason, sizeof(aReason)));
+	EXPECT_TRUE(str_find(aReason, "inner"));
+	EXPECT_TRUE(IsBanned("5.1.2.1", aReason, sizeof(aReason)));
+	EXPECT_TRUE(str_find(aReason, "outer"));
+
+	EXPECT_EQ(m_NetBan.UnbanByRange(&Inner), 0);
+	EXPECT_TRUE(IsBanned("5.1.1.1", aReason, sizeof(aReason)));
+	EXPECT_TRUE(str_find(aReason, "outer"));
+	m_NetBan.UnbanAll();
+	EXPECT_FALSE(IsBanned("5.1.1.1"));
+}
+
+TEST_F(NetBan, ExpiryOrder)
+{
+	const NETADDR Permanent1 = Addr("1.1.1.1");
+	const NETADDR Permanent2 = Addr("2.2.2.2");
+	const NETADDR Long = Addr("3.3.3.3");
+	const NETADDR Short = Addr("4.4.4.4");
+	m_NetBan.BanAddr(&Permanent1, 0, "", false);
+	m_NetBan.BanAddr(&Long, 3600, "", false);
+	m_NetBan.BanAddr(&Permanent2, 0, "", false);
+	m_NetBan.BanAddr(&Short, 60, "", false);
+
+	// timed bans first, the newest permanent ban before the older ones
+	const NETADDR *apExpected[] = {&Short, &Long, &Permanent2, &Permanent1};
+	auto *pBan = m_NetBan.m_BanAddrPool.First();
+	for(const NETADDR *pExpected : apExpected)
+	{
+		ASSERT_NE(pBan, nullptr);
+		EXPECT_EQ(NetComp(&pBan->m_Data, pExpected), 0);
+		pBan = pBan->m_pNext;
+	}
+	EXPECT_EQ(pBan, nullptr);
+
+	m_NetBan.UnbanByIndex(1);
+	EXPECT_FALSE(IsBanned("3.3.3.3"));
+	EXPECT_EQ(NetComp(&m_NetBan.m_BanAddrPool.First()->m_pNext->m_Data, &Permanent2), 0);
+}
+
+TEST_F(NetBan, SaveLoad)
+{
+	const NETADDR Banned = Addr("1.2.3.4");
+	const CNetRange BannedRange = Range("8.8.0.0", "8.8.255.255");
+	m_NetBan.BanAddr(&Banned, 0, "some reason", false);
+	m_NetBan.BanRange(&BannedRange, 600, "range reason");
+	m_pConsole->ExecuteLine("bans_save bans.cfg", IConsole::CLIENT_ID_UNSPECIFIED);
+
+	IOHANDLE File = m_pStorage->OpenFile("bans.cfg", IOFLAG_APPEND, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	const char aInvalid[] = "ban not_an_address 10 reason";
+	io_write(File, aInvalid, str_length(aInvalid));
+	io_write_newline(File);
+	io_close(File);
+
+	m_NetBan.UnbanAll();
+	EXPECT_FALSE(IsBanned("1.2.3.4"));
+	m_pConsole->ExecuteLine("bans_load bans.cfg", IConsole::CLIENT_ID_UNSPECIFIED);
+	// lets the server drop the clients matching the loaded bans
+	EXPECT_EQ(m_NetBan.m_NumBansLoaded, 1);
+
+	char aReason[256];
+	EXPECT_TRUE(IsBanned("1.2.3.4", aReason, sizeof(aReason)));
+	EXPECT_TRUE(str_find(aReason, "some reason"));
+	EXPECT_TRUE(IsBanned("8.8.8.8", aReason, sizeof(aReason)));
+	EXPECT_TRUE(str_find(aReason, "range reason"));
+	EXPECT_EQ(m_NetBan.m_BanAddrPool.Num(), 1);
+	EXPECT_EQ(m_NetBan.m_BanRangePool.Num(), 1);
+	EXPECT_NE(m_NetBan.m_BanRangePool.First()->m_Info.m_Expires, -1);
+}
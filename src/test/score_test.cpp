@@ -1,4 +1,8 @@
+#include "test.h"
+
 #include <base/detect.h>
+#include <base/fs.h>
+#include <base/log.h>
 #include <base/str.h>
 #include <base/time.h>
 
@@ -12,6 +16,10 @@
 #include <gtest/gtest.h>
 #include <sqlite3.h>
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #if defined(CONF_TEST_MYSQL)
 int DummyMysqlInit = (MysqlInit(), 1);
 #endif
@@ -25,6 +33,8 @@ struct Score : public testing::TestWithParam<IDbConnection *> // NOLINT(readabil
 {
 	Score()
 	{
+		// cached results of earlier tests refer to the deleted entries
+		CScoreWorker::ResultCache().Clear();
 		Connect();
 		LoadBestTime();
 		InsertMap("Kobra 3", "Zerodin", "Novice", 5, 5);
@@ -274,6 +284,122 @@ TEST_P(SingleScore, TimesDoesntExist)
 	ExpectLines(m_pPlayerResult, {"There are no times in the specified range"});
 }
 
+TEST_P(SingleScore, PreparedStatementRebind)
+{
+	InsertRank(200.0, false, "second tee");
+	InsertRank(300.0, false, "third tee");
+
+	char aQuery[128];
+	str_format(aQuery, sizeof(aQuery), "SELECT Time FROM %s_race WHERE Name=?", m_pConn->GetPrefix());
+	char aOrdered[128];
+	str_format(aOrdered, sizeof(aOrdered), "SELECT Name FROM %s_race ORDER BY Time", m_pConn->GetPrefix());
+	const char *apNames[] = {"third tee", "nameless tee", "second tee", "third tee"};
+	const float aTimes[] = {300.0f, 100.0f, 200.0f, 300.0f};
+	for(int CacheSize : {1, (int)IDbConnection::DEFAULT_STATEMENT_CACHE_SIZE})
+	{
+		m_pConn->SetStatementCacheSize(CacheSize);
+		for(int i = 0; i < (int)std::size(apNames); i++)
+		{
+			bool End;
+			ASSERT_TRUE(m_pConn->PrepareStatement(aQuery, m_aError, sizeof(m_aError))) << m_aError;
+			m_pConn->BindString(1, apNames[i]);
+			ASSERT_TRUE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+			ASSERT_FALSE(End);
+			EXPECT_EQ(m_pConn->GetFloat(1), aTimes[i]);
+
+			// only read the first row, a reused statement has to start over
+			ASSERT_TRUE(m_pConn->PrepareStatement(aOrdered, m_aError, sizeof(m_aError))) << m_aError;
+			ASSERT_TRUE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+			ASSERT_FALSE(End);
+			char aName[MAX_NAME_LENGTH];
+			m_pConn->GetString(1, aName, sizeof(aName));
+			EXPECT_STREQ(aName, "nameless tee");
+		}
+	}
+	m_pConn->SetStatementCacheSize(IDbConnection::DEFAULT_STATEMENT_CACHE_SIZE);
+}
+
+struct ResultCache : public SingleScore // NOLINT(readability-identifier-naming)
+{
+	int m_OldCacheTtl;
+
+	ResultCache()
+	{
+		g_Config.m_SvRegionalRankings = false;
+		m_OldCacheTtl = g_Config.m_SvSqlCacheTtl;
+		g_Config.m_SvSqlCacheTtl = 60;
+		CScoreWorker::ResultCache().Clear();
+	}
+
+	~ResultCache() override
+	{
+		g_Config.m_SvSqlCacheTtl = m_OldCacheTtl;
+		CScoreWorker::ResultCache().Clear();
+	}
+
+	void ExpectStats(uint64_t Hits, uint64_t Misses)
+	{
+		EXPECT_EQ(CScoreWorker::ResultCache().NumHits(), Hits);
+		EXPECT_EQ(CScoreWorker::ResultCache().NumMisses(), Misses);
+	}
+};
+
+TEST_P(ResultCache, TopHit)
+{
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(0, 1);
+
+	// the top list doesn't depend on the requesting player
+	m_pPlayerResult->SetVariant(CScorePlayerResult::DIRECT);
+	str_copy(m_PlayerRequest.m_aRequestingPlayer, "nameless tee");
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(1, 1);
+	ExpectLines(m_pPlayerResult,
+		{"------------ Global Top ------------",
+			"1. nameless tee Time: 01:40.00",
+			"-----------------------------------------"});
+
+	m_PlayerRequest.m_Offset = 5;
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(1, 2);
+}
+
+TEST_P(ResultCache, TopInvalidatedBySaveScore)
+{
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	InsertRank(50.0, false, "brainless tee");
+	EXPECT_EQ(CScoreWorker::ResultCache().NumEntries(), 0);
+
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(0, 2);
+	ExpectLines(m_pPlayerResult,
+		{"------------ Global Top ------------",
+			"1. brainless tee Time: 50.00",
+			"2. nameless tee Time: 01:40.00",
+			"-----------------------------------------"});
+}
+
+TEST_P(ResultCache, RankPerRequestingPlayer)
+{
+	ASSERT_TRUE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_TRUE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(1, 1);
+
+	str_copy(m_PlayerRequest.m_aRequestingPlayer, "nameless tee");
+	ASSERT_TRUE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(1, 2);
+	ExpectLines(m_pPlayerResult, {"nameless tee - 01:40.00 - better than 100%", "Global rank 1"}, true);
+}
+
+TEST_P(ResultCache, Disabled)
+{
+	g_Config.m_SvSqlCacheTtl = 0;
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectStats(0, 0);
+	EXPECT_EQ(CScoreWorker::ResultCache().NumEntries(), 0);
+}
+
 struct TeamScore : public Score // NOLINT(readability-identifier-naming)
 {
 	void SetUp() override
@@ -637,6 +763,181 @@ TEST_P(RandomMap, UnfinishedDoesntExist)
 	EXPECT_STREQ(m_pRandomMapResult->m_aMessage, "nameless tee has no more unfinished maps on this server!");
 }
 
+struct CPoolTestResult : ISqlResult
+{
+	int m_Count = -1;
+};
+
+struct CPoolTestData : ISqlData
+{
+	CPoolTestData(std::shared_ptr<CPoolTestResult> pResult, int Value) :
+		ISqlData(std::move(pResult)), m_Value(Value)
+	{
+	}
+	int m_Value;
+};
+
+static bool PoolTestInsert(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CPoolTestData *>(pGameData);
+	if(!pSqlServer->PrepareStatement("INSERT INTO pool_test(Value) VALUES (?)", pError, ErrorSize))
+		return false;
+	pSqlServer->BindInt(1, pData->m_Value);
+	int NumInserted;
+	return pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize);
+}
+
+static bool PoolTestCount(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	auto *pResult = dynamic_cast<CPoolTestResult *>(pGameData->m_pResult.get());
+	if(!pSqlServer->PrepareStatement("SELECT COUNT(*) FROM pool_test", pError, ErrorSize))
+		return false;
+	bool End;
+	if(!pSqlServer->Step(&End, pError, ErrorSize) || End)
+		return false;
+	pResult->m_Count = pSqlServer->GetInt(1);
+	return true;
+}
+
+TEST(DbConnectionPool, ReadWorkersAndOrderedWrites)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFilename, sizeof(aFilename), ".sqlite");
+	{
+		auto pConn = CreateSqliteConnection(aFilename, true);
+		char aError[256];
+		ASSERT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+		ASSERT_TRUE(pConn->PrepareStatement("CREATE TABLE pool_test (Id INTEGER PRIMARY KEY AUTOINCREMENT, Value INTEGER)", aError, sizeof(aError))) << aError;
+		int NumUpdated;
+		ASSERT_TRUE(pConn->ExecuteUpdate(&NumUpdated, aError, sizeof(aError))) << aError;
+		pConn->Disconnect();
+	}
+
+	const int NumQueries = 200;
+	const int OldReadWorkers = g_Config.m_SvSqlReadWorkers;
+	const int OldReadQueueSize = g_Config.m_SvSqlReadQueueSize;
+	g_Config.m_SvSqlReadWorkers = 4;
+	g_Config.m_SvSqlReadQueueSize = NumQueries;
+	std::vector<std::shared_ptr<CPoolTestResult>> vpResults;
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, aFilename);
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, aFilename);
+		for(int i = 0; i < NumQueries; i++)
+		{
+			auto pWriteResult = std::make_shared<CPoolTestResult>();
+			vpResults.push_back(pWriteResult);
+			Pool.ExecuteWrite(PoolTestInsert, std::make_unique<CPoolTestData>(pWriteResult, i), "pool test insert");
+			auto pReadResult = std::make_shared<CPoolTestResult>();
+			vpResults.push_back(pReadResult);
+			Pool.Execute(PoolTestCount, std::make_unique<CPoolTestData>(pReadResult, i), "pool test count");
+		}
+		// fail instead of hanging if a query gets lost
+		const int64_t Deadline = time_get_impl() + 30 * time_freq();
+		for(const auto &pResult : vpResults)
+		{
+			while(!pResult->m_Completed.load() && time_get_impl() < Deadline)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			if(!pResult->m_Completed.load())
+			{
+				ADD_FAILURE() << "query didn't complete within 30 seconds";
+				break;
+			}
+			EXPECT_TRUE(pResult->m_Success);
+		}
+		Pool.PrintStats();
+		Pool.OnShutdown();
+	}
+	g_Config.m_SvSqlReadWorkers = OldReadWorkers;
+	g_Config.m_SvSqlReadQueueSize = OldReadQueueSize;
+
+	// the write lane keeps the order of the writes
+	auto pConn = CreateSqliteConnection(aFilename, false);
+	char aError[256];
+	ASSERT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+	ASSERT_TRUE(pConn->PrepareStatement("SELECT Value FROM pool_test ORDER BY Id", aError, sizeof(aError))) << aError;
+	bool End;
+	for(int i = 0; i < NumQueries; i++)
+	{
+		ASSERT_TRUE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+		ASSERT_FALSE(End);
+		EXPECT_EQ(pConn->GetInt(1), i);
+	}
+	ASSERT_TRUE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+	EXPECT_TRUE(End);
+	pConn->Disconnect();
+
+	// reads run concurrently to the writes and can see any number of rows
+	for(size_t i = 1; i < vpResults.size(); i += 2)
+	{
+		EXPECT_GE(vpResults[i]->m_Count, 0);
+		EXPECT_LE(vpResults[i]->m_Count, NumQueries);
+	}
+	EXPECT_EQ(fs_remove(aFilename), 0);
+}
+
+static int64_t BenchmarkSaveScore(const char *pFilename, int CacheSize, int NumSaves)
+{
+	auto pConn = CreateSqliteConnection(pFilename, true);
+	pConn->SetStatementCacheSize(CacheSize);
+	char aError[256];
+	EXPECT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+	// measure the statements instead of the disk
+	int NumUpdated;
+	EXPECT_TRUE(pConn->PrepareStatement("PRAGMA synchronous=OFF", aError, sizeof(aError))) << aError;
+	EXPECT_TRUE(pConn->ExecuteUpdate(&NumUpdated, aError, sizeof(aError))) << aError;
+	EXPECT_TRUE(pConn->PrepareStatement("INSERT INTO record_maps(Map, Server, Mapper, Points, Stars) VALUES ('Kobra 3', 'Novice', 'Zerodin', 5, 5)", aError, sizeof(aError))) << aError;
+	EXPECT_TRUE(pConn->ExecuteUpdate(&NumUpdated, aError, sizeof(aError))) << aError;
+
+	str_copy(g_Config.m_SvSqlServerName, "USA");
+	CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+	str_copy(ScoreData.m_aMap, "Kobra 3");
+	str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320");
+	str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08");
+	str_copy(ScoreData.m_aRequestingPlayer, "deen");
+	ScoreData.m_ClientId = 0;
+
+	const int64_t Start = time_get_impl();
+	for(int i = 0; i < NumSaves; i++)
+	{
+		// the first finish of each player also awards points
+		str_format(ScoreData.m_aName, sizeof(ScoreData.m_aName), "tee %d", i % 64);
+		ScoreData.m_Time = 100.0f + i;
+		for(int Cp = 0; Cp < NUM_CHECKPOINTS; Cp++)
+			ScoreData.m_aCurrentTimeCp[Cp] = Cp + i;
+		EXPECT_TRUE(CScoreWorker::SaveScore(pConn.get(), &ScoreData, Write::NORMAL, aError, sizeof(aError))) << aError;
+	}
+	const int64_t Time = time_get_impl() - Start;
+
+	EXPECT_TRUE(pConn->PrepareStatement("SELECT COUNT(*) FROM record_race", aError, sizeof(aError))) << aError;
+	bool End;
+	EXPECT_TRUE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+	EXPECT_EQ(pConn->GetInt(1), NumSaves);
+	pConn->Disconnect();
+	return Time;
+}
+
+// Only measures, run it with `--gtest_also_run_disabled_tests`.
+TEST(PreparedStatementCache, DISABLED_SaveScoreBenchmark)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	const int NumSaves = 2000;
+	int64_t aTimes[2];
+	const int aCacheSizes[2] = {1, IDbConnection::DEFAULT_STATEMENT_CACHE_SIZE};
+	for(int i = 0; i < 2; i++)
+	{
+		char aExt[32];
+		str_format(aExt, sizeof(aExt), "-%d.sqlite", aCacheSizes[i]);
+		Info.Filename(aFilename, sizeof(aFilename), aExt);
+		aTimes[i] = BenchmarkSaveScore(aFilename, aCacheSizes[i], NumSaves);
+		EXPECT_EQ(fs_remove(aFilename), 0);
+	}
+	log_info("sql", "SaveScore on SQLite, %d saves: uncached %.3fus/save, cached %.3fus/save",
+		NumSaves, aTimes[0] * 1000000.0 / time_freq() / NumSaves, aTimes[1] * 1000000.0 / time_freq() / NumSaves);
+}
+
 static auto g_pSqliteConn = CreateSqliteConnection(":memory:", true);
 #if defined(CONF_TEST_MYSQL)
 CMysqlConfig gMysqlConfig{
@@ -671,6 +972,7 @@ static auto g_TestValues{
 		})
 
 INSTANTIATE(SingleScore);
+INSTANTIATE(ResultCache);
 INSTANTIATE(TeamScore);
 INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
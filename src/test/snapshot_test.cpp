@@ -6,6 +6,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 TEST(Snapshot, CrcOneInt)
 {
 	CSnapshotBuilder Builder;
@@ -96,3 +98,47 @@ TEST(Snapshot, StorageGet)
 	EXPECT_EQ(Storage.Get(5, nullptr, nullptr, nullptr), -1);
 	EXPECT_EQ(Storage.Get(25, nullptr, nullptr, nullptr), -1);
 }
+
+TEST(Snapshot, StorageRingBuffer)
+{
+	CSnapshotStorage Storage;
+
+	// Keep a sliding window of snapshots of varying size, the storage has to
+	// wrap around and grow without losing any of them.
+	char aData[CSnapshot::MAX_SIZE];
+	const int Window = 150;
+	for(int Tick = 1; Tick <= 5000; Tick++)
+	{
+		const size_t Size = 4 + (Tick * 7919) % 4000;
+		std::fill(aData, aData + Size, Tick % 256);
+		Storage.Add(Tick, Tick * 10, Size, aData, Tick % 3 ? 0 : 8, aData);
+		Storage.PurgeUntil(Tick - Window);
+
+		for(int Check : {Tick, Tick - Window / 2, Tick - Window})
+		{
+			if(Check < 1)
+				continue;
+			int64_t Tagtime = -1;
+			const CSnapshot *pData = nullptr;
+			const CSnapshot *pAltData = nullptr;
+			const size_t CheckSize = 4 + (Check * 7919) % 4000;
+			ASSERT_EQ(Storage.Get(Check, &Tagtime, &pData, &pAltData), (int)CheckSize);
+			EXPECT_EQ(Tagtime, Check * 10);
+			const unsigned char *pBytes = reinterpret_cast<const unsigned char *>(pData);
+			EXPECT_EQ(pBytes[0], Check % 256);
+			EXPECT_EQ(pBytes[CheckSize - 1], Check % 256);
+			EXPECT_EQ(pAltData != nullptr, Check % 3 == 0);
+		}
+		EXPECT_EQ(Storage.Get(Tick - Window - 1, nullptr, nullptr, nullptr), -1);
+	}
+
+	// Once the buffer holds the whole window, no more memory is allocated.
+	EXPECT_LE(Storage.NumAllocations(), 5);
+
+	Storage.PurgeAll();
+	EXPECT_EQ(Storage.Get(5000, nullptr, nullptr, nullptr), -1);
+	const int64_t Allocations = Storage.NumAllocations();
+	Storage.Add(5001, 0, 4, aData, 0, nullptr);
+	EXPECT_EQ(Storage.Get(5001, nullptr, nullptr, nullptr), 4);
+	EXPECT_EQ(Storage.NumAllocations(), Allocations);
+}
@@ -0,0 +1,72 @@
+#include <engine/client/sound_mix.h>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+static void ExpectSameAsScalar(int Channels, unsigned Frames, int VolumeL, int VolumeR)
+{
+	std::vector<short> vIn(Frames * Channels);
+	for(size_t i = 0; i < vIn.size(); i++)
+		vIn[i] = (short)((i * 7919 + 13) % 65536 - 32768);
+
+	std::vector<int> vExpected(Frames * 2);
+	for(size_t i = 0; i < vExpected.size(); i++)
+		vExpected[i] = (int)(i * 31) - 1000;
+	std::vector<int> vOut = vExpected;
+
+	MixVoiceScalar(vExpected.data(), vIn.data(), Channels, Frames, VolumeL, VolumeR);
+	MixVoice(vOut.data(), vIn.data(), Channels, Frames, VolumeL, VolumeR);
+	EXPECT_EQ(vOut, vExpected) << "Channels=" << Channels << " Frames=" << Frames << " VolumeL=" << VolumeL << " VolumeR=" << VolumeR;
+}
+
+TEST(SoundMix, Scalar)
+{
+	const short aMono[] = {100, -200, 300};
+	int aOut[6] = {1, 2, 3, 4, 5, 6};
+	MixVoiceScalar(aOut, aMono, 1, 3, 2, 3);
+	const int aExpectedMono[] = {201, 302, -397, -596, 605, 906};
+	for(int i = 0; i < 6; i++)
+		EXPECT_EQ(aOut[i], aExpectedMono[i]);
+
+	const short aStereo[] = {100, -200, 300, 400};
+	int aOutStereo[4] = {0, 0, 0, 0};
+	MixVoiceScalar(aOutStereo, aStereo, 2, 2, 255, 0);
+	const int aExpectedStereo[] = {25500, 0, 76500, 0};
+	for(int i = 0; i < 4; i++)
+		EXPECT_EQ(aOutStereo[i], aExpectedStereo[i]);
+}
+
+TEST(SoundMix, SameAsScalar)
+{
+	for(int Channels = 1; Channels <= 2; Channels++)
+	{
+		for(unsigned Frames = 0; Frames <= 37; Frames++)
+		{
+			ExpectSameAsScalar(Channels, Frames, 255, 255);
+			ExpectSameAsScalar(Channels, Frames, 0, 128);
+			ExpectSameAsScalar(Channels, Frames, 77, 1);
+		}
+		ExpectSameAsScalar(Channels, 1024, 200, 13);
+		ExpectSameAsScalar(Channels, 1000, std::numeric_limits<short>::max(), std::numeric_limits<short>::min());
+		// volumes that do not fit into 16 bits
+		ExpectSameAsScalar(Channels, 64, 40000, -40000);
+	}
+}
+
+TEST(SoundMix, ToOutput)
+{
+	const int aIn[] = {0, 256 * 100, -256 * 100, 1 << 30 >> 6, -(1 << 30 >> 6)};
+	short aOut[5];
+	MixToOutput(aOut, aIn, 5, 101);
+	EXPECT_EQ(aOut[0], 0);
+	EXPECT_EQ(aOut[1], 100);
+	EXPECT_EQ(aOut[2], -100);
+	EXPECT_EQ(aOut[3], std::numeric_limits<short>::max());
+	EXPECT_EQ(aOut[4], std::numeric_limits<short>::min());
+
+	MixToOutput(aOut, aIn, 5, 0);
+	for(short Sample : aOut)
+		EXPECT_EQ(Sample, 0);
+}
@@ -0,0 +1,180 @@
+#include <engine/client/sound_stream.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+// returns the frame number in the first and its negation in the second channel
+class CTestDecoder : public ISoundStreamDecoder
+{
+public:
+	int m_Channels;
+	int m_NumFrames;
+	int m_PacketFrames = 960;
+	int m_Position = 0;
+	std::vector<int> m_vSeeks;
+	bool m_FailSeek = false;
+
+	CTestDecoder(int Channels, int NumFrames) :
+		m_Channels(Channels), m_NumFrames(NumFrames)
+	{
+	}
+
+	bool Seek(int Frame) override
+	{
+		m_vSeeks.push_back(Frame);
+		if(m_FailSeek)
+			return false;
+		m_Position = Frame;
+		return true;
+	}
+
+	int Read(short *pBuffer, int MaxFrames) override
+	{
+		const int Frames = std::min({MaxFrames, m_PacketFrames, m_NumFrames - m_Position});
+		for(int i = 0; i < Frames; i++)
+		{
+			pBuffer[i * m_Channels] = m_Position + i;
+			if(m_Channels == 2)
+				pBuffer[i * m_Channels + 1] = -(m_Position + i);
+		}
+		m_Position += Frames;
+		return Frames;
+	}
+};
+
+static void ExpectFrames(const short *pFrames, int Channels, unsigned NumFrames, int FirstFrame)
+{
+	ASSERT_NE(pFrames, nullptr);
+	for(unsigned i = 0; i < NumFrames; i++)
+	{
+		EXPECT_EQ(pFrames[i * Channels], FirstFrame + (int)i) << "Frame " << i;
+		if(Channels == 2)
+		{
+			EXPECT_EQ(pFrames[i * Channels + 1], -(FirstFrame + (int)i)) << "Frame " << i;
+		}
+	}
+}
+
+TEST(SoundStream, Sequential)
+{
+	for(int Channels = 1; Channels <= 2; Channels++)
+	{
+		CTestDecoder Decoder(Channels, 10000);
+		CSoundStreamBuffer Buffer;
+		Buffer.Init(Channels, 48000, 48000, 10000, 512, 960, 0);
+		for(int Tick = 0; Tick + 512 <= 10000; Tick += 512)
+			ExpectFrames(Buffer.Frames(Decoder, Tick, 512), Channels, 512, Tick);
+		EXPECT_TRUE(Decoder.m_vSeeks.empty());
+	}
+}
+
+TEST(SoundStream, ReuseMixedFrames)
+{
+	CTestDecoder Decoder(2, 10000);
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(2, 48000, 48000, 10000, 512, 960, 0);
+	ExpectFrames(Buffer.Frames(Decoder, 0, 100), 2, 100, 0);
+	// overlapping and repeated requests are served from the buffer
+	ExpectFrames(Buffer.Frames(Decoder, 50, 100), 2, 100, 50);
+	ExpectFrames(Buffer.Frames(Decoder, 50, 512), 2, 512, 50);
+	ExpectFrames(Buffer.Frames(Decoder, 562, 512), 2, 512, 562);
+	EXPECT_TRUE(Decoder.m_vSeeks.empty());
+}
+
+TEST(SoundStream, Seek)
+{
+	CTestDecoder Decoder(2, 10000);
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(2, 48000, 48000, 10000, 512, 960, 0);
+	ExpectFrames(Buffer.Frames(Decoder, 0, 512), 2, 512, 0);
+
+	// new time offset
+	ExpectFrames(Buffer.Frames(Decoder, 5000, 512), 2, 512, 5000);
+	ASSERT_EQ(Decoder.m_vSeeks.size(), 1u);
+	EXPECT_EQ(Decoder.m_vSeeks[0], 5000);
+
+	// looped back to the loop start
+	ExpectFrames(Buffer.Frames(Decoder, 1000, 512), 2, 512, 1000);
+	ASSERT_EQ(Decoder.m_vSeeks.size(), 2u);
+	EXPECT_EQ(Decoder.m_vSeeks[1], 1000);
+
+	Decoder.m_FailSeek = true;
+	EXPECT_EQ(Buffer.Frames(Decoder, 0, 512), nullptr);
+	// the position of the decoder is unknown after failing
+	Decoder.m_FailSeek = false;
+	ExpectFrames(Buffer.Frames(Decoder, 0, 512), 2, 512, 0);
+	EXPECT_EQ(Decoder.m_vSeeks.size(), 4u);
+}
+
+TEST(SoundStream, DecoderNotAtStart)
+{
+	CTestDecoder Decoder(1, 10000);
+	Decoder.m_Position = 3000;
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(1, 48000, 48000, 10000, 512, 960, -1);
+	ExpectFrames(Buffer.Frames(Decoder, 0, 512), 1, 512, 0);
+	ASSERT_EQ(Decoder.m_vSeeks.size(), 1u);
+	EXPECT_EQ(Decoder.m_vSeeks[0], 0);
+}
+
+TEST(SoundStream, ReusedDecoder)
+{
+	// the decoder of a stopped voice is handed to the next voice as it is
+	CTestDecoder Decoder(2, 10000);
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(2, 48000, 48000, 10000, 512, 960, 0);
+	for(int Tick = 0; Tick < 3000; Tick += 500)
+		ExpectFrames(Buffer.Frames(Decoder, Tick, 500), 2, 500, Tick);
+	EXPECT_TRUE(Decoder.m_vSeeks.empty());
+	ASSERT_NE(Decoder.m_Position, 0);
+
+	CSoundStreamBuffer NextBuffer;
+	NextBuffer.Init(2, 48000, 48000, 10000, 512, 960, Decoder.m_Position);
+	ExpectFrames(NextBuffer.Frames(Decoder, 0, 512), 2, 512, 0);
+	ASSERT_EQ(Decoder.m_vSeeks.size(), 1u);
+	EXPECT_EQ(Decoder.m_vSeeks[0], 0);
+
+	// continuing where the decoder is doesn't seek
+	CSoundStreamBuffer ContinueBuffer;
+	ContinueBuffer.Init(2, 48000, 48000, 10000, 512, 960, Decoder.m_Position);
+	const int Position = Decoder.m_Position;
+	ExpectFrames(ContinueBuffer.Frames(Decoder, Position, 512), 2, 512, Position);
+	EXPECT_EQ(Decoder.m_vSeeks.size(), 1u);
+}
+
+TEST(SoundStream, RateConversion)
+{
+	CTestDecoder Decoder(2, 10000);
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(2, 48000, 44100, 10000, 512, 960, 0);
+	for(int Tick = 0; Tick + 512 <= 9000; Tick += 512)
+	{
+		const short *pFrames = Buffer.Frames(Decoder, Tick, 512);
+		ASSERT_NE(pFrames, nullptr);
+		for(int i = 0; i < 512; i++)
+		{
+			const int Expected = (int)((int64_t)(Tick + i) * 48000 / 44100);
+			EXPECT_EQ(pFrames[i * 2], Expected);
+			EXPECT_EQ(pFrames[i * 2 + 1], -Expected);
+		}
+	}
+	EXPECT_TRUE(Decoder.m_vSeeks.empty());
+}
+
+TEST(SoundStream, SilenceAtEnd)
+{
+	// the decoder ends before the expected number of frames
+	CTestDecoder Decoder(2, 700);
+	CSoundStreamBuffer Buffer;
+	Buffer.Init(2, 48000, 48000, 1000, 512, 960, 0);
+	ExpectFrames(Buffer.Frames(Decoder, 0, 512), 2, 512, 0);
+	const short *pFrames = Buffer.Frames(Decoder, 512, 488);
+	ExpectFrames(pFrames, 2, 188, 512);
+	for(int i = 188 * 2; i < 488 * 2; i++)
+		EXPECT_EQ(pFrames[i], 0);
+
+	EXPECT_EQ(Buffer.Frames(Decoder, 0, 0), nullptr);
+	EXPECT_EQ(Buffer.Frames(Decoder, 1000, 10), nullptr);
+}
@@ -11,6 +11,9 @@
 
 #include <gtest/gtest.h>
 
+#include <zlib.h>
+
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,6 +29,8 @@ protected:
 	CTeeHistorian::CGameInfo m_GameInfo;
 
 	std::vector<unsigned char> m_vBuffer;
+	std::unique_ptr<CTeeHistorianCompressor> m_pCompressor;
+	std::vector<unsigned char> m_vCompressed;
 
 	enum
 	{
@@ -107,6 +112,48 @@ protected:
 		m_State = STATE_NONE;
 	}
 
+	static void WriteCompressed(const void *pData, int DataSize, void *pUser)
+	{
+		TeeHistorian *pThis = (TeeHistorian *)pUser;
+		WriteBuffer(pThis->m_vCompressed, pData, DataSize);
+	}
+
+	void ResetCompressed()
+	{
+		m_vBuffer.clear();
+		m_vCompressed.clear();
+		m_pCompressor = std::make_unique<CTeeHistorianCompressor>();
+		ASSERT_TRUE(m_pCompressor->Init(WriteCompressed, this));
+		m_TH.Reset(&m_GameInfo, CTeeHistorianCompressor::WriteCallback, m_pCompressor.get());
+		m_State = STATE_NONE;
+	}
+
+	// decompresses the output of the compressor into `m_vBuffer`
+	void Decompress(bool ExpectStreamEnd)
+	{
+		z_stream Stream;
+		mem_zero(&Stream, sizeof(Stream));
+		ASSERT_EQ(inflateInit2(&Stream, 16 + MAX_WBITS), Z_OK);
+		Stream.next_in = m_vCompressed.data();
+		Stream.avail_in = m_vCompressed.size();
+		m_vBuffer.clear();
+		int Result;
+		do
+		{
+			unsigned char aBuffer[1024];
+			Stream.next_out = aBuffer;
+			Stream.avail_out = sizeof(aBuffer);
+			Result = inflate(&Stream, Z_NO_FLUSH);
+			WriteBuffer(m_vBuffer, aBuffer, sizeof(aBuffer) - Stream.avail_out);
+		} while(Result == Z_OK);
+		inflateEnd(&Stream);
+		if(ExpectStreamEnd)
+			EXPECT_EQ(Result, Z_STREAM_END);
+		else
+			EXPECT_EQ(Result, Z_BUF_ERROR); // all input consumed, but no gzip trailer
+		EXPECT_EQ(Stream.avail_in, 0u);
+	}
+
 	void Expect(const unsigned char *pOutput, size_t OutputSize)
 	{
 		static const CUuid TEEHISTORIAN_UUID = CalculateUuid("teehistorian@ddnet.tw");
@@ -291,6 +338,45 @@ TEST_F(TeeHistorian, TickImplicitTwoTicks)
 	Expect(EXPECTED, sizeof(EXPECTED));
 }
 
+TEST_F(TeeHistorian, CompressedRoundTrip)
+{
+	const unsigned char EXPECTED[] = {
+		0x42, 0x00, 0x01, 0x02, // PLAYER_NEW cid=0 x=1 y=2
+		0x00, 0x01, 0x40, // PLAYER cid=0 dx=1 dy=-1
+		0x40, // FINISH
+	};
+	ResetCompressed();
+	Tick(1);
+	Player(0, 1, 2);
+	Tick(2);
+	Player(0, 2, 1);
+	Finish();
+	m_pCompressor->Finish();
+	Decompress(true);
+	Expect(EXPECTED, sizeof(EXPECTED));
+}
+
+TEST_F(TeeHistorian, CompressedFlushReadable)
+{
+	const unsigned char EXPECTED[] = {
+		0x42, 0x00, 0x01, 0x02, // PLAYER_NEW cid=0 x=1 y=2
+		0x40, // FINISH
+	};
+	ResetCompressed();
+	Tick(1);
+	Player(0, 1, 2);
+	Finish();
+
+	// without a flush, the data is still in the compressor
+	Decompress(false);
+	EXPECT_LT(m_vBuffer.size(), sizeof(EXPECTED));
+
+	// a file that ends after the flush can be read completely
+	m_pCompressor->Flush();
+	Decompress(false);
+	Expect(EXPECTED, sizeof(EXPECTED));
+}
+
 TEST_F(TeeHistorian, TickImplicitDescendingClientId)
 {
 	const unsigned char EXPECTED[] = {
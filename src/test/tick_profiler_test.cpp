@@ -0,0 +1,98 @@
+#include <engine/server/tick_profiler.h>
+
+#include <gtest/gtest.h>
+
+TEST(TickProfiler, HistogramEmpty)
+{
+	CDurationHistogram Histogram;
+	EXPECT_EQ(Histogram.Count(), 0);
+	EXPECT_EQ(Histogram.Percentile(50), 0);
+	EXPECT_EQ(Histogram.Percentile(99), 0);
+	EXPECT_EQ(Histogram.Max(), 0);
+}
+
+TEST(TickProfiler, HistogramSmallValuesExact)
+{
+	CDurationHistogram Histogram;
+	for(int i = 0; i < 8; i++)
+		Histogram.Add(i);
+	EXPECT_EQ(Histogram.Count(), 8);
+	EXPECT_EQ(Histogram.Total(), 28);
+	EXPECT_EQ(Histogram.Max(), 7);
+	EXPECT_EQ(Histogram.Percentile(50), 3);
+	EXPECT_EQ(Histogram.Percentile(100), 7);
+}
+
+TEST(TickProfiler, HistogramPercentiles)
+{
+	CDurationHistogram Histogram;
+	for(int i = 1; i <= 1000; i++)
+		Histogram.Add(i * 100);
+	EXPECT_EQ(Histogram.Max(), 100000);
+
+	// upper bounds of the buckets, within 25% of the exact percentile
+	const int64_t P50 = Histogram.Percentile(50);
+	EXPECT_GE(P50, 50000);
+	EXPECT_LE(P50, 62500);
+	const int64_t P99 = Histogram.Percentile(99);
+	EXPECT_GE(P99, 99000);
+	EXPECT_LE(P99, 100000);
+}
+
+TEST(TickProfiler, HistogramHugeValues)
+{
+	CDurationHistogram Histogram;
+	Histogram.Add(int64_t(1) << 40);
+	EXPECT_EQ(Histogram.Count(), 1);
+	EXPECT_EQ(Histogram.Percentile(50), int64_t(1) << 40);
+}
+
+TEST(TickProfiler, Loop)
+{
+	CTickProfiler Profiler;
+
+	// iteration without ticks, only counted in the phases
+	Profiler.BeginLoop();
+	Profiler.EndPhase(CTickProfiler::PHASE_NETWORK);
+	Profiler.EndPhase(CTickProfiler::PHASE_WAIT);
+	Profiler.EndLoop(0, 50);
+
+	Profiler.BeginLoop();
+	Profiler.EndPhase(CTickProfiler::PHASE_GAME_TICK);
+	Profiler.EndPhase(CTickProfiler::PHASE_SNAPSHOT);
+	Profiler.EndPhase(CTickProfiler::PHASE_NETWORK);
+	Profiler.EndPhase(CTickProfiler::PHASE_WAIT);
+	Profiler.EndLoop(3, 50);
+
+	const CTickProfiler::CStats &Stats = Profiler.Total();
+	EXPECT_EQ(Stats.m_aPhases[CTickProfiler::PHASE_NETWORK].Count(), 2);
+	EXPECT_EQ(Stats.m_aPhases[CTickProfiler::PHASE_WAIT].Count(), 2);
+	EXPECT_EQ(Stats.m_aPhases[CTickProfiler::PHASE_GAME_TICK].Count(), 1);
+	EXPECT_EQ(Stats.m_aPhases[CTickProfiler::PHASE_ANTIBOT].Count(), 0);
+	EXPECT_EQ(Stats.m_Work.Count(), 1);
+	EXPECT_EQ(Stats.m_Ticks, 3);
+	EXPECT_EQ(Stats.m_CatchUpTicks, 2);
+	EXPECT_EQ(Stats.m_Overruns, 0);
+
+	Profiler.Reset();
+	EXPECT_EQ(Profiler.Total().m_aPhases[CTickProfiler::PHASE_NETWORK].Count(), 0);
+	EXPECT_EQ(Profiler.Total().m_Ticks, 0);
+}
+
+TEST(TickProfiler, Snapshots)
+{
+	CTickProfiler Profiler;
+	Profiler.AddSnapshot(3, 100);
+	Profiler.AddSnapshot(3, 0);
+	Profiler.AddSnapshot(3, 300);
+	Profiler.AddSnapshot(5, 50);
+
+	const CTickProfiler::CClientSnapshots &Client = Profiler.Total().m_aClients[3];
+	EXPECT_EQ(Client.m_Snapshots, 3);
+	EXPECT_EQ(Client.m_Bytes, 400);
+	EXPECT_EQ(Client.m_MaxBytes, 300);
+
+	Profiler.ResetClient(3);
+	EXPECT_EQ(Profiler.Total().m_aClients[3].m_Snapshots, 0);
+	EXPECT_EQ(Profiler.Total().m_aClients[5].m_Snapshots, 1);
+}
@@ -0,0 +1,102 @@
+#include <base/io.h>
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char *TOOL_NAME = "console_bench";
+
+static void AddConfigVariable(const SConfigVariable *pVariable, void *pUserData)
+{
+	char aLine[IConsole::CMDLINE_LENGTH];
+	pVariable->Serialize(aLine, sizeof(aLine));
+	static_cast<std::vector<std::string> *>(pUserData)->emplace_back(aLine);
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s [repetitions=20] [config file]", TOOL_NAME);
+		return -1;
+	}
+	const int Repetitions = argc > 1 ? str_toint(argv[1]) : 20;
+	const char *pConfigPath = argc > 2 ? argv[2] : nullptr;
+	if(Repetitions <= 0)
+	{
+		log_error(TOOL_NAME, "Repetitions must be positive");
+		return -1;
+	}
+
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::BASIC, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+	// client and server variables, like a client and a server config
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_CLIENT).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+
+	std::vector<std::string> vLines;
+	if(pConfigPath)
+	{
+		CLineReader LineReader;
+		if(!LineReader.OpenFile(pStorage->OpenFile(pConfigPath, IOFLAG_READ, IStorage::TYPE_ALL_OR_ABSOLUTE)))
+		{
+			log_error(TOOL_NAME, "Failed to open config '%s' for reading", pConfigPath);
+			return -1;
+		}
+		while(const char *pLine = LineReader.Get())
+			vLines.emplace_back(pLine);
+	}
+	else
+	{
+		// all config variables with their default values, like a saved config
+		pConfigManager->PossibleConfigVariables("", CFGFLAG_SERVER | CFGFLAG_CLIENT, AddConfigVariable, &vLines);
+	}
+	if(vLines.empty())
+	{
+		log_error(TOOL_NAME, "Config is empty");
+		return -1;
+	}
+
+	std::vector<int64_t> vTimes;
+	vTimes.reserve(Repetitions);
+	for(int i = 0; i < Repetitions; i++)
+	{
+		const int64_t Start = time_get();
+		for(const std::string &Line : vLines)
+			pConsole->ExecuteLine(Line.c_str(), IConsole::CLIENT_ID_UNSPECIFIED);
+		vTimes.push_back(time_get() - Start);
+	}
+
+	std::sort(vTimes.begin(), vTimes.end());
+	const double UsPerTick = 1000000.0 / time_freq();
+	log_info(TOOL_NAME, "%d lines, %d repetitions", (int)vLines.size(), Repetitions);
+	log_info(TOOL_NAME, "per config: median %.2fus, min %.2fus, max %.2fus",
+		vTimes[Repetitions / 2] * UsPerTick, vTimes.front() * UsPerTick, vTimes.back() * UsPerTick);
+	log_info(TOOL_NAME, "per line: median %.3fus", vTimes[Repetitions / 2] * UsPerTick / vLines.size());
+	return 0;
+}
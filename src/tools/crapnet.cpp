@@ -5,6 +5,7 @@
 #include <base/mem.h>
 #include <base/net.h>
 #include <base/os.h>
+#include <base/str.h>
 #include <base/time.h>
 
 #include <cstdlib>
@@ -206,6 +207,19 @@ int main(int argc, const char **argv)
 	log_set_global_logger_default();
 	net_init();
 
+	if(argc > 1)
+	{
+		// a constant latency instead of the changing ping configs
+		const int Latency = str_toint(argv[1]);
+		if(argc > 2 || Latency < 0)
+		{
+			dbg_msg("crapnet", "usage: %s [latency in ms]", argv[0]);
+			return -1;
+		}
+		g_aConfigPings[0] = {Latency, 0, 0, 0, 0, 0};
+		g_ConfigNumpingconfs = 1;
+	}
+
 	NETADDR Addr = {NETTYPE_IPV4, {127, 0, 0, 1}, 8303};
 	Run(8302, Addr);
 	return 0;
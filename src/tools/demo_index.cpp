@@ -0,0 +1,67 @@
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <memory>
+
+static const char *TOOL_NAME = "demo_index";
+
+static bool IndexDemo(IStorage *pStorage, const char *pDemoFilename)
+{
+	// the keyframes can be found without decoding snapshots
+	CSnapshotDelta SnapshotDelta;
+	CDemoPlayer DemoPlayer(&SnapshotDelta, &SnapshotDelta, false);
+	if(DemoPlayer.Load(pStorage, nullptr, pDemoFilename, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
+	{
+		log_error(TOOL_NAME, "Demo file '%s' failed to load: %s", pDemoFilename, DemoPlayer.ErrorMessage());
+		return false;
+	}
+
+	const int FirstTick = DemoPlayer.Info()->m_Info.m_FirstTick;
+	const int LastTick = DemoPlayer.Info()->m_Info.m_LastTick;
+	const bool Saved = DemoPlayer.SaveIndex(pStorage);
+	char aIndexFilename[IO_MAX_PATH_LENGTH];
+	str_copy(aIndexFilename, DemoPlayer.IndexPath());
+	DemoPlayer.Stop();
+
+	if(!Saved)
+	{
+		log_error(TOOL_NAME, "Failed to write index file '%s'", aIndexFilename);
+		return false;
+	}
+	log_info(TOOL_NAME, "Wrote index file '%s' for ticks %d to %d", aIndexFilename, FirstTick, LastTick);
+	return true;
+}
+
+int main(int argc, const char *argv[])
+{
+	// Create storage before setting logger to avoid log messages from storage creation
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating local storage");
+		return -1;
+	}
+
+	if(argc < 2)
+	{
+		log_error(TOOL_NAME, "Usage: %s <demo_filename> [demo_filename ...]", TOOL_NAME);
+		return -1;
+	}
+
+	int Result = 0;
+	for(int i = 1; i < argc; i++)
+	{
+		if(!IndexDemo(pStorage.get(), argv[i]))
+			Result = -1;
+	}
+	return Result;
+}
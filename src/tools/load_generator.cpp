@@ -0,0 +1,694 @@
+#include <base/io.h>
+#include <base/logger.h>
+#include <base/mem.h>
+#include <base/net.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/message.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/shared/snapshot.h>
+#include <engine/shared/uuid_manager.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/prng.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const char *TOOL_NAME = "load_generator";
+
+static const int NUM_SENT_INPUTS = 64;
+
+class CInputStep
+{
+public:
+	int m_Ticks;
+	CNetObj_PlayerInput m_Input;
+};
+
+// measurements of all clients, reported at the end
+class CLoadStats
+{
+public:
+	std::vector<double> m_vConnectTimes;
+	std::vector<double> m_vInputRoundTrips;
+	std::vector<double> m_vSnapshotJitter;
+	std::vector<double> m_vSnapshotSizes;
+	std::vector<double> m_vUnpackedSnapshotSizes;
+	int m_NumSnapshots = 0;
+	int m_NumIncompleteSnapshots = 0;
+	int m_NumMissingDeltas = 0;
+	int m_NumBrokenSnapshots = 0;
+	int m_NumLateInputs = 0;
+	int m_NumInputs = 0;
+	int m_NumDisconnects = 0;
+};
+
+class CLoadClient
+{
+public:
+	enum class EState
+	{
+		CONNECTING,
+		LOADING,
+		INGAME,
+		OFFLINE,
+	};
+
+	int m_Id;
+	CNetClient m_NetClient;
+	EState m_State = EState::OFFLINE;
+	bool m_SentInfo = false;
+	int64_t m_ConnectStartTime = 0;
+
+	CSnapshotStorage m_SnapshotStorage;
+	std::unique_ptr<unsigned char[]> m_pSnapshotIncomingData;
+	uint64_t m_SnapshotParts = 0;
+	int m_SnapshotIncomingDataSize = 0;
+	int m_CurrentRecvTick = 0;
+	int m_AckGameTick = -1;
+	int m_LastSnapshotTick = -1;
+	int64_t m_LastSnapshotTime = 0;
+
+	int m_PredTick = 0;
+	int m_aSentInputTicks[NUM_SENT_INPUTS];
+	int64_t m_aSentInputTimes[NUM_SENT_INPUTS];
+	CNetObj_PlayerInput m_Input;
+	size_t m_ScriptStep = 0;
+	int m_ScriptTicksLeft = 0;
+};
+
+class CLoadGenerator
+{
+	CSnapshotDelta m_SnapshotDelta;
+	CPrng m_Prng;
+	std::vector<CInputStep> m_vScript;
+
+	void SendMsg(CLoadClient *pClient, CMsgPacker *pMsg, int Flags);
+	void SendInfo(CLoadClient *pClient);
+	void SendStartInfo(CLoadClient *pClient);
+	void OnSnapshot(CLoadClient *pClient, int Msg, CUnpacker *pUnpacker);
+	void ProcessPacket(CLoadClient *pClient, CNetChunk *pPacket);
+	void NextInput(CLoadClient *pClient);
+
+public:
+	CLoadStats m_Stats;
+	std::vector<std::unique_ptr<CLoadClient>> m_vpClients;
+
+	CLoadGenerator();
+	bool LoadScript(const char *pFilename);
+	bool Connect(CLoadClient *pClient, const NETADDR &ServerAddr);
+	void Pump(CLoadClient *pClient);
+	void SendInput(CLoadClient *pClient);
+	void Disconnect(CLoadClient *pClient);
+};
+
+CLoadGenerator::CLoadGenerator()
+{
+	CNetObjHandler NetObjHandler;
+	for(int i = 0; i < NUM_NETOBJTYPES; i++)
+		m_SnapshotDelta.SetStaticsize(i, NetObjHandler.GetObjSize(i));
+
+	// the same random inputs in every run, to compare server versions
+	uint64_t aSeed[2] = {1, 2};
+	m_Prng.Seed(aSeed);
+}
+
+bool CLoadGenerator::LoadScript(const char *pFilename)
+{
+	CLineReader LineReader;
+	if(!LineReader.OpenFile(io_open(pFilename, IOFLAG_READ)))
+	{
+		log_error(TOOL_NAME, "Failed to open input script '%s'", pFilename);
+		return false;
+	}
+	int Line = 0;
+	while(const char *pLine = LineReader.Get())
+	{
+		Line++;
+		pLine = str_skip_whitespaces_const(pLine);
+		if(pLine[0] == '\0' || pLine[0] == '#')
+			continue;
+
+		// ticks direction target_x target_y jump hook fire
+		CInputStep Step;
+		mem_zero(&Step, sizeof(Step));
+		int Jump, Hook, Fire;
+		if(sscanf(pLine, "%d %d %d %d %d %d %d", &Step.m_Ticks, &Step.m_Input.m_Direction, &Step.m_Input.m_TargetX, &Step.m_Input.m_TargetY, &Jump, &Hook, &Fire) != 7 || Step.m_Ticks <= 0)
+		{
+			log_error(TOOL_NAME, "Invalid input script line %d: '%s'", Line, pLine);
+			return false;
+		}
+		Step.m_Input.m_Direction = std::clamp(Step.m_Input.m_Direction, -1, 1);
+		Step.m_Input.m_Jump = Jump != 0;
+		Step.m_Input.m_Hook = Hook != 0;
+		Step.m_Input.m_Fire = Fire != 0;
+		m_vScript.push_back(Step);
+	}
+	if(m_vScript.empty())
+	{
+		log_error(TOOL_NAME, "Input script '%s' is empty", pFilename);
+		return false;
+	}
+	return true;
+}
+
+bool CLoadGenerator::Connect(CLoadClient *pClient, const NETADDR &ServerAddr)
+{
+	NETADDR BindAddr = NETADDR_ZEROED;
+	BindAddr.type = ServerAddr.type;
+	bool Opened = false;
+	if(ServerAddr.type == NETTYPE_IPV4 && ServerAddr.ip[0] == 127)
+	{
+		// every client from its own loopback address, to stay below the
+		// limits per address of the server
+		BindAddr.ip[0] = 127;
+		BindAddr.ip[1] = 2;
+		BindAddr.ip[2] = (pClient->m_Id >> 8) & 0xff;
+		BindAddr.ip[3] = pClient->m_Id & 0xff;
+		Opened = pClient->m_NetClient.Open(BindAddr);
+		mem_zero(BindAddr.ip, sizeof(BindAddr.ip));
+	}
+	if(!Opened && !pClient->m_NetClient.Open(BindAddr))
+	{
+		log_error(TOOL_NAME, "Client %d failed to open a socket", pClient->m_Id);
+		return false;
+	}
+
+	pClient->m_NetClient.Connect(&ServerAddr, 1);
+	pClient->m_State = CLoadClient::EState::CONNECTING;
+	pClient->m_SentInfo = false;
+	pClient->m_ConnectStartTime = time_get();
+	pClient->m_pSnapshotIncomingData = std::make_unique<unsigned char[]>(CSnapshot::MAX_SIZE);
+	pClient->m_SnapshotStorage.Init();
+	mem_zero(&pClient->m_Input, sizeof(pClient->m_Input));
+	pClient->m_Input.m_TargetY = -1;
+	for(int &Tick : pClient->m_aSentInputTicks)
+		Tick = -1;
+	pClient->m_ScriptStep = m_vScript.empty() ? 0 : pClient->m_Id % m_vScript.size();
+	return true;
+}
+
+void CLoadGenerator::Disconnect(CLoadClient *pClient)
+{
+	if(pClient->m_State == CLoadClient::EState::OFFLINE)
+		return;
+	pClient->m_NetClient.Disconnect("Load test finished");
+	pClient->m_NetClient.Close();
+	pClient->m_State = CLoadClient::EState::OFFLINE;
+}
+
+void CLoadGenerator::SendMsg(CLoadClient *pClient, CMsgPacker *pMsg, int Flags)
+{
+	CPacker Packer;
+	Packer.Reset();
+	if(pMsg->m_MsgId < OFFSET_UUID)
+	{
+		Packer.AddInt((pMsg->m_MsgId << 1) | (pMsg->m_System ? 1 : 0));
+	}
+	else
+	{
+		Packer.AddInt(pMsg->m_System ? 1 : 0); // NETMSG_EX, NETMSGTYPE_EX
+		g_UuidManager.PackUuid(pMsg->m_MsgId, &Packer);
+	}
+	Packer.AddRaw(pMsg->Data(), pMsg->Size());
+
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientId = 0;
+	Packet.m_pData = Packer.Data();
+	Packet.m_DataSize = Packer.Size();
+	if(Flags & MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags & MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+	pClient->m_NetClient.Send(&Packet);
+}
+
+void CLoadGenerator::SendInfo(CLoadClient *pClient)
+{
+	const CUuid ConnectionId = RandomUuid();
+	CMsgPacker MsgVer(NETMSG_CLIENTVER, true);
+	MsgVer.AddRaw(&ConnectionId, sizeof(ConnectionId));
+	MsgVer.AddInt(DDNET_VERSION_NUMBER);
+	MsgVer.AddString(GAME_NAME " " GAME_RELEASE_VERSION " (load generator)");
+	SendMsg(pClient, &MsgVer, MSGFLAG_VITAL);
+
+	CMsgPacker Msg(NETMSG_INFO, true);
+	Msg.AddString(GAME_NETVERSION);
+	Msg.AddString(g_Config.m_Password);
+	SendMsg(pClient, &Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+}
+
+void CLoadGenerator::SendStartInfo(CLoadClient *pClient)
+{
+	char aName[MAX_NAME_LENGTH];
+	str_format(aName, sizeof(aName), "load %d", pClient->m_Id);
+	CNetMsg_Cl_StartInfo Msg;
+	Msg.m_pName = aName;
+	Msg.m_pClan = "";
+	Msg.m_Country = -1;
+	Msg.m_pSkin = "default";
+	Msg.m_UseCustomColor = 0;
+	Msg.m_ColorBody = 0;
+	Msg.m_ColorFeet = 0;
+	CMsgPacker Packer(&Msg);
+	Msg.Pack(&Packer);
+	SendMsg(pClient, &Packer, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+}
+
+void CLoadGenerator::OnSnapshot(CLoadClient *pClient, int Msg, CUnpacker *pUnpacker)
+{
+	const int GameTick = pUnpacker->GetInt();
+	const int DeltaTick = GameTick - pUnpacker->GetInt();
+
+	int NumParts = 1;
+	int Part = 0;
+	if(Msg == NETMSG_SNAP)
+	{
+		NumParts = pUnpacker->GetInt();
+		Part = pUnpacker->GetInt();
+	}
+
+	unsigned int Crc = 0;
+	int PartSize = 0;
+	if(Msg != NETMSG_SNAPEMPTY)
+	{
+		Crc = pUnpacker->GetInt();
+		PartSize = pUnpacker->GetInt();
+	}
+
+	const char *pData = (const char *)pUnpacker->GetRaw(PartSize);
+	if(pUnpacker->Error() || NumParts < 1 || NumParts > CSnapshot::MAX_PARTS || Part < 0 || Part >= NumParts || PartSize < 0 || PartSize > MAX_SNAPSHOT_PACKSIZE)
+		return;
+	if(GameTick < pClient->m_CurrentRecvTick || GameTick <= pClient->m_AckGameTick)
+		return;
+
+	if(GameTick != pClient->m_CurrentRecvTick)
+	{
+		// parts of the previous snapshot never arrived
+		if(pClient->m_SnapshotParts != 0)
+			m_Stats.m_NumIncompleteSnapshots++;
+		pClient->m_SnapshotParts = 0;
+		pClient->m_CurrentRecvTick = GameTick;
+		pClient->m_SnapshotIncomingDataSize = 0;
+	}
+
+	mem_copy(pClient->m_pSnapshotIncomingData.get() + Part * MAX_SNAPSHOT_PACKSIZE, pData, std::clamp(PartSize, 0, CSnapshot::MAX_SIZE - Part * MAX_SNAPSHOT_PACKSIZE));
+	pClient->m_SnapshotParts |= (uint64_t)1 << Part;
+	if(Part == NumParts - 1)
+		pClient->m_SnapshotIncomingDataSize = (NumParts - 1) * MAX_SNAPSHOT_PACKSIZE + PartSize;
+
+	if(!((NumParts < CSnapshot::MAX_PARTS && pClient->m_SnapshotParts == (((uint64_t)1 << NumParts) - 1)) ||
+		   (NumParts == CSnapshot::MAX_PARTS && pClient->m_SnapshotParts == std::numeric_limits<uint64_t>::max())))
+		return;
+	pClient->m_SnapshotParts = 0;
+
+	const CSnapshot *pDeltaShot = CSnapshot::EmptySnapshot();
+	if(DeltaTick >= 0 && pClient->m_SnapshotStorage.Get(DeltaTick, nullptr, &pDeltaShot, nullptr) < 0)
+	{
+		// force the server to resync, like the client does
+		m_Stats.m_NumMissingDeltas++;
+		pClient->m_AckGameTick = -1;
+		return;
+	}
+
+	unsigned char aDeltaData[CSnapshot::MAX_SIZE];
+	const void *pDeltaData = m_SnapshotDelta.EmptyDelta();
+	int DeltaSize = sizeof(int) * 3;
+	if(pClient->m_SnapshotIncomingDataSize)
+	{
+		DeltaSize = CVariableInt::Decompress(pClient->m_pSnapshotIncomingData.get(), pClient->m_SnapshotIncomingDataSize, aDeltaData, sizeof(aDeltaData));
+		if(DeltaSize < 0)
+		{
+			m_Stats.m_NumBrokenSnapshots++;
+			return;
+		}
+		pDeltaData = aDeltaData;
+	}
+
+	CSnapshotBuffer SnapshotBuffer;
+	const int SnapSize = m_SnapshotDelta.UnpackDelta(pDeltaShot, &SnapshotBuffer, pDeltaData, DeltaSize);
+	if(SnapSize < 0 || !SnapshotBuffer.AsSnapshot()->IsValid(SnapSize) ||
+		(Msg != NETMSG_SNAPEMPTY && SnapshotBuffer.AsSnapshot()->Crc() != Crc))
+	{
+		m_Stats.m_NumBrokenSnapshots++;
+		return;
+	}
+
+	const int64_t Now = time_get();
+	pClient->m_SnapshotStorage.PurgeUntil(DeltaTick);
+	pClient->m_SnapshotStorage.Add(GameTick, Now, SnapSize, SnapshotBuffer.AsSnapshot(), 0, nullptr);
+	pClient->m_AckGameTick = GameTick;
+
+	m_Stats.m_NumSnapshots++;
+	m_Stats.m_vSnapshotSizes.push_back(pClient->m_SnapshotIncomingDataSize);
+	m_Stats.m_vUnpackedSnapshotSizes.push_back(SnapSize);
+	if(pClient->m_LastSnapshotTick >= 0)
+	{
+		// how much later than the ticks between them suggest the snapshot arrived
+		const int64_t Expected = (int64_t)(GameTick - pClient->m_LastSnapshotTick) * time_freq() / SERVER_TICK_SPEED;
+		m_Stats.m_vSnapshotJitter.push_back((Now - pClient->m_LastSnapshotTime - Expected) * 1000.0 / time_freq());
+	}
+	pClient->m_LastSnapshotTick = GameTick;
+	pClient->m_LastSnapshotTime = Now;
+
+	if(pClient->m_State != CLoadClient::EState::INGAME)
+	{
+		pClient->m_State = CLoadClient::EState::INGAME;
+		pClient->m_PredTick = GameTick + 2;
+		m_Stats.m_vConnectTimes.push_back((Now - pClient->m_ConnectStartTime) * 1000.0 / time_freq());
+	}
+}
+
+void CLoadGenerator::ProcessPacket(CLoadClient *pClient, CNetChunk *pPacket)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+	CMsgPacker Packer(NETMSG_EX, true);
+
+	int Msg;
+	bool Sys;
+	CUuid Uuid;
+	const int Result = UnpackMessageId(&Msg, &Sys, &Uuid, &Unpacker, &Packer);
+	if(Result == UNPACKMESSAGE_ERROR)
+		return;
+	else if(Result == UNPACKMESSAGE_ANSWER)
+		SendMsg(pClient, &Packer, MSGFLAG_VITAL);
+
+	// game messages are not needed to keep the connection alive
+	if(!Sys)
+		return;
+
+	if(Msg == NETMSG_MAP_CHANGE && (pPacket->m_Flags & NET_CHUNKFLAG_VITAL))
+	{
+		// the map itself is not needed, only the snapshots
+		pClient->m_State = CLoadClient::EState::LOADING;
+		pClient->m_SnapshotStorage.PurgeAll();
+		pClient->m_SnapshotParts = 0;
+		pClient->m_CurrentRecvTick = 0;
+		pClient->m_AckGameTick = -1;
+		pClient->m_LastSnapshotTick = -1;
+		CMsgPacker MsgReady(NETMSG_READY, true);
+		SendMsg(pClient, &MsgReady, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+	else if(Msg == NETMSG_CON_READY)
+	{
+		SendStartInfo(pClient);
+		CMsgPacker MsgEnter(NETMSG_ENTERGAME, true);
+		SendMsg(pClient, &MsgEnter, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+	else if(Msg == NETMSG_PING)
+	{
+		CMsgPacker MsgReply(NETMSG_PING_REPLY, true);
+		SendMsg(pClient, &MsgReply, MSGFLAG_FLUSH | ((pPacket->m_Flags & NET_CHUNKFLAG_VITAL) ? MSGFLAG_VITAL : 0));
+	}
+	else if(Msg == NETMSG_INPUTTIMING)
+	{
+		const int InputPredTick = Unpacker.GetInt();
+		const int TimeLeft = Unpacker.GetInt();
+		if(Unpacker.Error())
+			return;
+
+		const int Index = InputPredTick % NUM_SENT_INPUTS;
+		if(pClient->m_aSentInputTicks[Index] == InputPredTick)
+			m_Stats.m_vInputRoundTrips.push_back((time_get() - pClient->m_aSentInputTimes[Index]) * 1000.0 / time_freq());
+
+		// keep the inputs arriving shortly before the server needs them
+		if(TimeLeft < 0)
+		{
+			m_Stats.m_NumLateInputs++;
+			pClient->m_PredTick++;
+		}
+		else if(TimeLeft > 1000 / SERVER_TICK_SPEED * 3)
+		{
+			pClient->m_PredTick--;
+		}
+	}
+	else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+	{
+		if(pClient->m_State == CLoadClient::EState::CONNECTING)
+			return;
+		OnSnapshot(pClient, Msg, &Unpacker);
+	}
+}
+
+void CLoadGenerator::Pump(CLoadClient *pClient)
+{
+	if(pClient->m_State == CLoadClient::EState::OFFLINE)
+		return;
+
+	pClient->m_NetClient.Update();
+	if(pClient->m_NetClient.State() == NETSTATE_OFFLINE)
+	{
+		log_error(TOOL_NAME, "Client %d lost connection: %s", pClient->m_Id, pClient->m_NetClient.ErrorString());
+		m_Stats.m_NumDisconnects++;
+		pClient->m_NetClient.Close();
+		pClient->m_State = CLoadClient::EState::OFFLINE;
+		return;
+	}
+	if(!pClient->m_SentInfo && pClient->m_NetClient.State() == NETSTATE_ONLINE)
+	{
+		pClient->m_SentInfo = true;
+		SendInfo(pClient);
+	}
+
+	CNetChunk Packet;
+	SECURITY_TOKEN ResponseToken;
+	while(pClient->m_NetClient.Recv(&Packet, &ResponseToken, false))
+	{
+		if(Packet.m_ClientId != -1)
+			ProcessPacket(pClient, &Packet);
+	}
+}
+
+void CLoadGenerator::NextInput(CLoadClient *pClient)
+{
+	CNetObj_PlayerInput &Input = pClient->m_Input;
+	const int Fire = Input.m_Fire;
+	if(m_vScript.empty())
+	{
+		// random movement, changed a few times per second
+		if(m_Prng.RandomBits() % 8 == 0)
+		{
+			Input.m_Direction = (int)(m_Prng.RandomBits() % 3) - 1;
+			Input.m_TargetX = (int)(m_Prng.RandomBits() % 401) - 200;
+			Input.m_TargetY = (int)(m_Prng.RandomBits() % 401) - 200;
+			Input.m_Hook = m_Prng.RandomBits() % 3 == 0;
+		}
+		Input.m_Jump = m_Prng.RandomBits() % 10 == 0;
+		if(m_Prng.RandomBits() % 16 == 0)
+			Input.m_Fire = Fire + 1;
+	}
+	else
+	{
+		if(pClient->m_ScriptTicksLeft <= 0)
+		{
+			pClient->m_ScriptStep = (pClient->m_ScriptStep + 1) % m_vScript.size();
+			pClient->m_ScriptTicksLeft = m_vScript[pClient->m_ScriptStep].m_Ticks;
+		}
+		pClient->m_ScriptTicksLeft--;
+		const CNetObj_PlayerInput &Step = m_vScript[pClient->m_ScriptStep].m_Input;
+		Input = Step;
+		// the fire counter counts presses and releases
+		Input.m_Fire = (Fire & 1) != Step.m_Fire ? Fire + 1 : Fire;
+	}
+	if(Input.m_TargetX == 0 && Input.m_TargetY == 0)
+		Input.m_TargetY = -1;
+	Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
+}
+
+void CLoadGenerator::SendInput(CLoadClient *pClient)
+{
+	if(pClient->m_State != CLoadClient::EState::INGAME)
+		return;
+
+	NextInput(pClient);
+	pClient->m_PredTick++;
+
+	CMsgPacker Msg(NETMSG_INPUT, true);
+	Msg.AddInt(pClient->m_AckGameTick);
+	Msg.AddInt(pClient->m_PredTick);
+	Msg.AddInt(sizeof(pClient->m_Input));
+	const int *pData = (const int *)&pClient->m_Input;
+	for(size_t i = 0; i < sizeof(pClient->m_Input) / sizeof(int); i++)
+		Msg.AddInt(pData[i]);
+	SendMsg(pClient, &Msg, MSGFLAG_FLUSH);
+
+	const int Index = pClient->m_PredTick % NUM_SENT_INPUTS;
+	pClient->m_aSentInputTicks[Index] = pClient->m_PredTick;
+	pClient->m_aSentInputTimes[Index] = time_get();
+	m_Stats.m_NumInputs++;
+}
+
+static void LogDistribution(const char *pName, std::vector<double> &vValues, const char *pUnit)
+{
+	if(vValues.empty())
+	{
+		log_info(TOOL_NAME, "%s: no samples", pName);
+		return;
+	}
+	std::sort(vValues.begin(), vValues.end());
+	double Sum = 0.0;
+	for(double Value : vValues)
+		Sum += Value;
+	const auto Percentile = [&](int Percent) { return vValues[(vValues.size() - 1) * Percent / 100]; };
+	log_info(TOOL_NAME, "%s: avg %.2f%s, median %.2f%s, p90 %.2f%s, p99 %.2f%s, max %.2f%s (%d samples)",
+		pName, Sum / vValues.size(), pUnit, Percentile(50), pUnit, Percentile(90), pUnit, Percentile(99), pUnit, vValues.back(), pUnit, (int)vValues.size());
+}
+
+static double Percentage(uint64_t Part, uint64_t Total)
+{
+	return Total ? Part * 100.0 / Total : 0.0;
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc < 2 || argc > 5)
+	{
+		log_error(TOOL_NAME, "Usage: %s <server[:port]> [clients=64] [seconds=30] [input script]", TOOL_NAME);
+		log_error(TOOL_NAME, "Each line of the input script is 'ticks direction target_x target_y jump hook fire', without a script the inputs are random.");
+		log_error(TOOL_NAME, "On loopback, every client connects from its own 127.2.x.y address, otherwise raise sv_max_clients_per_ip and sv_connlimit.");
+		return -1;
+	}
+	const int NumClients = argc > 2 ? str_toint(argv[2]) : 64;
+	const int Seconds = argc > 3 ? str_toint(argv[3]) : 30;
+	if(NumClients <= 0 || Seconds <= 0)
+	{
+		log_error(TOOL_NAME, "Invalid arguments");
+		return -1;
+	}
+
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::BASIC, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+	// the network code reads its timeouts from the config
+	IConsole *pConsole = CreateConsole(CFGFLAG_CLIENT).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+
+	net_init();
+	CNetBase::Init();
+	NETADDR ServerAddr;
+	if(net_host_lookup(argv[1], &ServerAddr, NETTYPE_IPV4 | NETTYPE_IPV6))
+	{
+		log_error(TOOL_NAME, "Host lookup of '%s' failed", argv[1]);
+		return -1;
+	}
+	if(ServerAddr.port == 0)
+		ServerAddr.port = 8303;
+
+	CLoadGenerator Generator;
+	if(argc > 4 && !Generator.LoadScript(argv[4]))
+		return -1;
+	for(int i = 0; i < NumClients; i++)
+	{
+		Generator.m_vpClients.push_back(std::make_unique<CLoadClient>());
+		Generator.m_vpClients.back()->m_Id = i;
+	}
+
+	// connect gradually, the server handles one connection attempt per address and tick
+	const int64_t Freq = time_freq();
+	const int64_t TickTime = Freq / SERVER_TICK_SPEED;
+	const int64_t StartTime = time_get();
+	const int64_t EndTime = StartTime + Seconds * Freq;
+	int64_t NextTick = StartTime;
+	int64_t NextReport = StartTime + 5 * Freq;
+	int NumConnected = 0;
+	int64_t LongestPump = 0;
+	while(true)
+	{
+		const int64_t Now = time_get();
+		if(Now >= EndTime)
+			break;
+
+		const int64_t PumpStart = time_get();
+		for(auto &pClient : Generator.m_vpClients)
+			Generator.Pump(pClient.get());
+		LongestPump = std::max(LongestPump, time_get() - PumpStart);
+
+		if(Now >= NextTick)
+		{
+			if(NumConnected < NumClients && Generator.Connect(Generator.m_vpClients[NumConnected].get(), ServerAddr))
+				NumConnected++;
+			for(auto &pClient : Generator.m_vpClients)
+				Generator.SendInput(pClient.get());
+			// don't try to catch up after stalls, that would only send bursts of inputs
+			NextTick = std::max(NextTick + TickTime, Now);
+		}
+
+		if(Now >= NextReport)
+		{
+			int NumInGame = 0;
+			for(auto &pClient : Generator.m_vpClients)
+				NumInGame += pClient->m_State == CLoadClient::EState::INGAME;
+			log_info(TOOL_NAME, "%ds: %d of %d clients in game, %d snapshots, %d inputs",
+				(int)((Now - StartTime) / Freq), NumInGame, NumClients, Generator.m_Stats.m_NumSnapshots, Generator.m_Stats.m_NumInputs);
+			NextReport += 5 * Freq;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+
+	CNetConnectionStats Total;
+	int NumInGame = 0;
+	for(auto &pClient : Generator.m_vpClients)
+	{
+		NumInGame += pClient->m_State == CLoadClient::EState::INGAME;
+		const CNetConnectionStats &Stats = pClient->m_NetClient.Stats();
+		Total.m_SentPackets += Stats.m_SentPackets;
+		Total.m_RecvPackets += Stats.m_RecvPackets;
+		Total.m_ResentChunks += Stats.m_ResentChunks;
+		Total.m_ResendRequests += Stats.m_ResendRequests;
+		Generator.Disconnect(pClient.get());
+	}
+
+	CLoadStats &Stats = Generator.m_Stats;
+	const uint64_t NumSnapshotAttempts = Stats.m_NumSnapshots + Stats.m_NumIncompleteSnapshots + Stats.m_NumMissingDeltas + Stats.m_NumBrokenSnapshots;
+	log_info(TOOL_NAME, "%d of %d clients in game after %ds, %d lost their connection", NumInGame, NumClients, Seconds, Stats.m_NumDisconnects);
+	LogDistribution("connect time", Stats.m_vConnectTimes, "ms");
+	LogDistribution("input round trip", Stats.m_vInputRoundTrips, "ms");
+	LogDistribution("snapshot jitter", Stats.m_vSnapshotJitter, "ms");
+	LogDistribution("snapshot size", Stats.m_vSnapshotSizes, "B");
+	LogDistribution("unpacked snapshot size", Stats.m_vUnpackedSnapshotSizes, "B");
+	log_info(TOOL_NAME, "snapshots: %d received, %d incomplete, %d without delta, %d broken (%.2f%% lost)",
+		Stats.m_NumSnapshots, Stats.m_NumIncompleteSnapshots, Stats.m_NumMissingDeltas, Stats.m_NumBrokenSnapshots,
+		Percentage(NumSnapshotAttempts - Stats.m_NumSnapshots, NumSnapshotAttempts));
+	log_info(TOOL_NAME, "inputs: %d sent, %d late (%.2f%%)", Stats.m_NumInputs, Stats.m_NumLateInputs, Percentage(Stats.m_NumLateInputs, Stats.m_NumInputs));
+	log_info(TOOL_NAME, "packets: %" PRIu64 " sent, %" PRIu64 " received, %" PRIu64 " chunks resent (%.2f%%), %" PRIu64 " resends requested (%.2f%%)",
+		Total.m_SentPackets, Total.m_RecvPackets, Total.m_ResentChunks, Percentage(Total.m_ResentChunks, Total.m_SentPackets),
+		Total.m_ResendRequests, Percentage(Total.m_ResendRequests, Total.m_RecvPackets));
+	log_info(TOOL_NAME, "longest pump of all clients: %.2fms", LongestPump * 1000.0 / Freq);
+	return 0;
+}
@@ -0,0 +1,313 @@
+#include <base/logger.h>
+#include <base/mem.h>
+#include <base/net.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/message.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/shared/uuid_manager.h>
+#include <engine/storage.h>
+
+#include <game/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+static const char *TOOL_NAME = "map_download";
+
+// downloads the current map of a server once over the game protocol, like
+// the client does without HTTP map downloads
+class CMapDownload
+{
+	CNetClient m_NetClient;
+	int m_Window;
+	bool m_SentInfo = false;
+	bool m_WindowCapability = false;
+
+	int m_MapCrc = 0;
+	int m_MapSize = -1;
+	int m_NumMapChunks = 0;
+	int m_Chunk = 0;
+	int m_RequestedChunks = 0;
+	std::vector<unsigned char> m_vMapData;
+	int64_t m_StartTime = 0;
+
+	void SendMsg(CMsgPacker *pMsg, int Flags);
+	void SendInfo();
+	void RequestChunks(int Chunk, int NumChunks);
+	void ProcessPacket(CNetChunk *pPacket);
+
+public:
+	int m_NumRequests = 0;
+	int64_t m_Duration = -1;
+	bool m_Failed = false;
+
+	CMapDownload(int Window) :
+		m_Window(Window) {}
+
+	bool Connect(const NETADDR &ServerAddr);
+	void Pump();
+	void Disconnect();
+	bool Done() const { return m_Duration >= 0 || m_Failed; }
+	int MapSize() const { return m_MapSize; }
+	const CNetConnectionStats &Stats() const { return m_NetClient.Stats(); }
+};
+
+bool CMapDownload::Connect(const NETADDR &ServerAddr)
+{
+	NETADDR BindAddr = NETADDR_ZEROED;
+	BindAddr.type = ServerAddr.type;
+	if(!m_NetClient.Open(BindAddr))
+	{
+		log_error(TOOL_NAME, "Failed to open a socket");
+		return false;
+	}
+	m_NetClient.Connect(&ServerAddr, 1);
+	return true;
+}
+
+void CMapDownload::Disconnect()
+{
+	m_NetClient.Disconnect("Map download finished");
+	m_NetClient.Close();
+}
+
+void CMapDownload::SendMsg(CMsgPacker *pMsg, int Flags)
+{
+	CPacker Packer;
+	Packer.Reset();
+	Packer.AddInt((pMsg->m_MsgId << 1) | (pMsg->m_System ? 1 : 0));
+	Packer.AddRaw(pMsg->Data(), pMsg->Size());
+
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientId = 0;
+	Packet.m_pData = Packer.Data();
+	Packet.m_DataSize = Packer.Size();
+	if(Flags & MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags & MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+	m_NetClient.Send(&Packet);
+}
+
+void CMapDownload::SendInfo()
+{
+	// the server only sends its capabilities to DDNet clients
+	CMsgPacker MsgVer(NETMSG_CLIENTVER, true);
+	const CUuid ConnectionId = RandomUuid();
+	MsgVer.AddRaw(&ConnectionId, sizeof(ConnectionId));
+	MsgVer.AddInt(DDNET_VERSION_NUMBER);
+	MsgVer.AddString(GAME_NAME " " GAME_RELEASE_VERSION " (map download)");
+	SendMsg(&MsgVer, MSGFLAG_VITAL);
+
+	CMsgPacker Msg(NETMSG_INFO, true);
+	Msg.AddString(GAME_NETVERSION);
+	Msg.AddString(g_Config.m_Password);
+	SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+}
+
+void CMapDownload::RequestChunks(int Chunk, int NumChunks)
+{
+	CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA, true);
+	Msg.AddInt(Chunk);
+	if(m_Window > 0)
+		Msg.AddInt(NumChunks);
+	SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	m_NumRequests++;
+}
+
+void CMapDownload::ProcessPacket(CNetChunk *pPacket)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+	CMsgPacker Packer(NETMSG_EX, true);
+
+	int Msg;
+	bool Sys;
+	CUuid Uuid;
+	const int Result = UnpackMessageId(&Msg, &Sys, &Uuid, &Unpacker, &Packer);
+	if(Result == UNPACKMESSAGE_ERROR || !Sys)
+		return;
+	else if(Result == UNPACKMESSAGE_ANSWER)
+		SendMsg(&Packer, MSGFLAG_VITAL);
+
+	if(Msg == NETMSG_CAPABILITIES)
+	{
+		const int Version = Unpacker.GetInt();
+		const int Flags = Unpacker.GetInt();
+		m_WindowCapability = !Unpacker.Error() && Version >= 6 && (Flags & SERVERCAPFLAG_MAPDOWNLOADWINDOW);
+	}
+	else if(Msg == NETMSG_MAP_CHANGE && m_MapSize < 0)
+	{
+		const char *pMap = Unpacker.GetString(CUnpacker::SANITIZE_CC);
+		m_MapCrc = Unpacker.GetInt();
+		m_MapSize = Unpacker.GetInt();
+		if(Unpacker.Error() || m_MapSize <= 0)
+		{
+			log_error(TOOL_NAME, "Invalid map change message");
+			m_Failed = true;
+			return;
+		}
+		if(m_Window > 0 && !m_WindowCapability)
+		{
+			log_error(TOOL_NAME, "The server does not support windowed map downloads, use a window of 0");
+			m_Failed = true;
+			return;
+		}
+		log_info(TOOL_NAME, "Downloading map '%s' with %d bytes", pMap, m_MapSize);
+		m_vMapData.reserve(m_MapSize);
+		m_StartTime = time_get();
+		// the server sends chunks of this size, except for the last one
+		const int ChunkSize = NET_MAX_CHUNK_SIZE - 128;
+		m_NumMapChunks = (m_MapSize + ChunkSize - 1) / ChunkSize;
+		if(m_Window > 0)
+		{
+			m_RequestedChunks = std::min(m_Window, m_NumMapChunks);
+			RequestChunks(0, m_RequestedChunks);
+		}
+		else
+		{
+			RequestChunks(0, 1);
+		}
+	}
+	else if(Msg == NETMSG_MAP_DATA && m_MapSize > 0 && m_Duration < 0)
+	{
+		const int Last = Unpacker.GetInt();
+		const int MapCrc = Unpacker.GetInt();
+		const int Chunk = Unpacker.GetInt();
+		const int Size = Unpacker.GetInt();
+		const unsigned char *pData = Unpacker.GetRaw(Size);
+		if(Unpacker.Error() || Size <= 0 || MapCrc != m_MapCrc || Chunk != m_Chunk || (int)m_vMapData.size() + Size > m_MapSize)
+			return;
+
+		m_vMapData.insert(m_vMapData.end(), pData, pData + Size);
+		m_Chunk++;
+		if(Last)
+		{
+			m_Duration = time_get() - m_StartTime;
+			if((int)m_vMapData.size() != m_MapSize || (int)crc32(0, m_vMapData.data(), m_vMapData.size()) != m_MapCrc)
+			{
+				log_error(TOOL_NAME, "Downloaded map data is corrupt");
+				m_Failed = true;
+			}
+		}
+		else if(m_Window > 0)
+		{
+			// keep the window filled, one new chunk for every received one
+			if(m_RequestedChunks < m_NumMapChunks)
+			{
+				RequestChunks(m_RequestedChunks, 1);
+				m_RequestedChunks++;
+			}
+		}
+		else
+		{
+			RequestChunks(m_Chunk, 1);
+		}
+	}
+}
+
+void CMapDownload::Pump()
+{
+	m_NetClient.Update();
+	if(m_NetClient.State() == NETSTATE_OFFLINE)
+	{
+		log_error(TOOL_NAME, "Lost connection: %s", m_NetClient.ErrorString());
+		m_Failed = true;
+		return;
+	}
+	if(!m_SentInfo && m_NetClient.State() == NETSTATE_ONLINE)
+	{
+		m_SentInfo = true;
+		SendInfo();
+	}
+
+	CNetChunk Packet;
+	SECURITY_TOKEN ResponseToken;
+	while(!Done() && m_NetClient.Recv(&Packet, &ResponseToken, false))
+	{
+		if(Packet.m_ClientId != -1)
+			ProcessPacket(&Packet);
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc < 2 || argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s <server[:port]> [window=%d]", TOOL_NAME, (int)MAX_MAP_DOWNLOAD_WINDOW);
+		log_error(TOOL_NAME, "Downloads the current map of the server and prints the time it took.");
+		log_error(TOOL_NAME, "A window of 0 requests one chunk after another like clients without SERVERCAPFLAG_MAPDOWNLOADWINDOW.");
+		return -1;
+	}
+	const int Window = argc > 2 ? str_toint(argv[2]) : MAX_MAP_DOWNLOAD_WINDOW;
+	if(Window < 0 || Window > MAX_MAP_DOWNLOAD_WINDOW)
+	{
+		log_error(TOOL_NAME, "The window must be between 0 and %d", (int)MAX_MAP_DOWNLOAD_WINDOW);
+		return -1;
+	}
+
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::BASIC, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+	// the network code reads its timeouts from the config
+	IConsole *pConsole = CreateConsole(CFGFLAG_CLIENT).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+
+	net_init();
+	CNetBase::Init();
+	NETADDR ServerAddr;
+	if(net_host_lookup(argv[1], &ServerAddr, NETTYPE_IPV4 | NETTYPE_IPV6))
+	{
+		log_error(TOOL_NAME, "Host lookup of '%s' failed", argv[1]);
+		return -1;
+	}
+	if(ServerAddr.port == 0)
+		ServerAddr.port = 8303;
+
+	CMapDownload Download(Window);
+	if(!Download.Connect(ServerAddr))
+		return -1;
+	while(!Download.Done())
+	{
+		Download.Pump();
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	const uint64_t ResentChunks = Download.Stats().m_ResentChunks;
+	Download.Disconnect();
+	if(Download.m_Failed)
+		return -1;
+
+	const double Seconds = (double)Download.m_Duration / time_freq();
+	log_info(TOOL_NAME, "Downloaded %d bytes in %.2fs (%.1f KiB/s) with %d requests and window %d, %" PRIu64 " chunks resent",
+		Download.MapSize(), Seconds, Download.MapSize() / Seconds / 1024.0, Download.m_NumRequests, Window, ResentChunks);
+	return 0;
+}
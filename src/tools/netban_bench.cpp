@@ -0,0 +1,126 @@
+#include <base/logger.h>
+#include <base/net.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+#include <game/prng.h>
+
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "netban_bench";
+
+static CPrng s_Prng;
+
+static unsigned Random()
+{
+	return s_Prng.RandomBits();
+}
+
+static NETADDR RandomAddr()
+{
+	NETADDR Addr = NETADDR_ZEROED;
+	Addr.type = NETTYPE_IPV4;
+	// avoid 127.0.0.0/8, localhost can't be banned
+	Addr.ip[0] = 128 + Random() % 128;
+	Addr.ip[1] = Random() % 256;
+	Addr.ip[2] = Random() % 256;
+	Addr.ip[3] = Random() % 256;
+	Addr.port = 8303;
+	return Addr;
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 4)
+	{
+		log_error(TOOL_NAME, "Usage: %s [address bans=50000] [range bans=5000] [connection attempts=1000000]", TOOL_NAME);
+		return -1;
+	}
+	const int NumAddrBans = argc > 1 ? str_toint(argv[1]) : 50000;
+	const int NumRangeBans = argc > 2 ? str_toint(argv[2]) : 5000;
+	const int NumAttempts = argc > 3 ? str_toint(argv[3]) : 1000000;
+	if(NumAddrBans < 0 || NumRangeBans < 0 || NumAttempts <= 0)
+	{
+		log_error(TOOL_NAME, "Invalid arguments");
+		return -1;
+	}
+
+	uint64_t aSeed[2] = {1, 2};
+	s_Prng.Seed(aSeed);
+
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan NetBan;
+	NetBan.Init(pConsole.get(), nullptr);
+
+	std::vector<NETADDR> vBannedAddrs;
+	vBannedAddrs.reserve(NumAddrBans);
+	const int64_t BanStart = time_get();
+	{
+		// every ban is printed
+		std::unique_ptr<ILogger> pNoopLogger = log_logger_noop();
+		CLogScope LogScope(pNoopLogger.get());
+		for(int i = 0; i < NumAddrBans; i++)
+		{
+			vBannedAddrs.push_back(RandomAddr());
+			NetBan.BanAddr(&vBannedAddrs.back(), (1 + Random() % 600) * 60, "bench", false);
+		}
+		for(int i = 0; i < NumRangeBans; i++)
+		{
+			// mostly /24 sized ranges, some arbitrary ones
+			CNetRange Range;
+			Range.m_LB = RandomAddr();
+			Range.m_UB = Range.m_LB;
+			if(i % 4)
+			{
+				Range.m_LB.ip[3] = 0;
+				Range.m_UB.ip[3] = 255;
+			}
+			else
+			{
+				Range.m_UB.ip[2] = Range.m_LB.ip[2] + (255 - Range.m_LB.ip[2]) / 2;
+				Range.m_UB.ip[3] = Random() % 256;
+				if(!Range.IsValid())
+					Range.m_UB.ip[3] = 255;
+			}
+			NetBan.BanRange(&Range, 0, "bench");
+		}
+	}
+	const int64_t BanTime = time_get() - BanStart;
+
+	// a flood of connection attempts from random addresses, some of them banned
+	std::vector<NETADDR> vAttempts;
+	vAttempts.reserve(NumAttempts);
+	for(int i = 0; i < NumAttempts; i++)
+	{
+		if(!vBannedAddrs.empty() && i % 10 == 0)
+			vAttempts.push_back(vBannedAddrs[Random() % vBannedAddrs.size()]);
+		else
+			vAttempts.push_back(RandomAddr());
+	}
+
+	int NumBanned = 0;
+	char aReason[256];
+	const int64_t LookupStart = time_get();
+	for(const NETADDR &Addr : vAttempts)
+	{
+		if(NetBan.IsBanned(&Addr, aReason, sizeof(aReason)))
+			NumBanned++;
+	}
+	const int64_t LookupTime = time_get() - LookupStart;
+
+	const double Seconds = (double)LookupTime / time_freq();
+	log_info(TOOL_NAME, "%d address bans, %d range bans added in %.2fms",
+		NumAddrBans, NumRangeBans, BanTime * 1000.0 / time_freq());
+	log_info(TOOL_NAME, "%d connection attempts, %d banned: %.3fus per attempt, %.0f attempts per second",
+		NumAttempts, NumBanned, Seconds * 1000000.0 / NumAttempts, NumAttempts / Seconds);
+	return 0;
+}
@@ -0,0 +1,249 @@
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapbugs.h>
+#include <game/mapitems.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "prediction_bench";
+
+// Mirrors the work `CGameClient::OnPredict` does each rendered frame: copy the
+// game world into the predicted world and tick it forward by the prediction
+// margin, copying it once more into the previous predicted world on the way.
+class CPredictionBench
+{
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CMapBugs m_MapBugs;
+	CTuningParams m_aTuningList[TuneZone::NUM];
+
+	CGameWorld m_GameWorld;
+	CGameWorld m_PredictedWorld;
+	CGameWorld m_PrevPredictedWorld;
+
+	int m_NumCharacters;
+	unsigned m_Seed = 1;
+
+	unsigned Random()
+	{
+		m_Seed = m_Seed * 1103515245 + 12345;
+		return (m_Seed >> 16) & 0x7fff;
+	}
+
+	void SpawnPositions(std::vector<vec2> &vSpawns) const
+	{
+		const int Width = m_Collision.GetWidth();
+		const int Height = m_Collision.GetHeight();
+		for(int y = 0; y < Height; y++)
+		{
+			for(int x = 0; x < Width; x++)
+			{
+				const int Entity = m_Collision.GetTileIndex(y * Width + x) - ENTITY_OFFSET;
+				if(Entity == ENTITY_SPAWN || Entity == ENTITY_SPAWN_RED || Entity == ENTITY_SPAWN_BLUE)
+					vSpawns.emplace_back(x * 32.0f + 16.0f, y * 32.0f + 16.0f);
+			}
+		}
+		if(vSpawns.empty())
+			vSpawns.emplace_back(Width * 16.0f, Height * 16.0f);
+	}
+
+	void ConfigureWorld(CGameWorld &World)
+	{
+		World.m_WorldConfig.m_IsVanilla = false;
+		World.m_WorldConfig.m_IsDDRace = true;
+		World.m_WorldConfig.m_IsFNG = false;
+		World.m_WorldConfig.m_InfiniteAmmo = true;
+		World.m_WorldConfig.m_PredictTiles = true;
+		World.m_WorldConfig.m_PredictFreeze = 1;
+		World.m_WorldConfig.m_PredictWeapons = true;
+		World.m_WorldConfig.m_PredictDDRace = true;
+		World.m_WorldConfig.m_IsSolo = false;
+		World.m_WorldConfig.m_UseTuneZones = true;
+		World.m_WorldConfig.m_BugDDRaceInput = false;
+		World.m_WorldConfig.m_NoWeakHookAndBounce = false;
+		World.m_WorldConfig.m_PredictEvents = false;
+	}
+
+	void RandomInput(CNetObj_PlayerInput *pInput)
+	{
+		mem_zero(pInput, sizeof(*pInput));
+		pInput->m_Direction = (int)(Random() % 3) - 1;
+		pInput->m_TargetX = (int)(Random() % 400) - 200;
+		pInput->m_TargetY = (int)(Random() % 400) - 200;
+		if(pInput->m_TargetX == 0 && pInput->m_TargetY == 0)
+			pInput->m_TargetY = -1;
+		pInput->m_Jump = Random() % 8 == 0;
+		pInput->m_Hook = Random() % 4 == 0;
+		pInput->m_Fire = Random() % 2;
+		pInput->m_WantedWeapon = WEAPON_GRENADE + 1;
+	}
+
+	void TickWorld(CGameWorld &World, int Tick)
+	{
+		for(int i = 0; i < m_NumCharacters; i++)
+		{
+			if(CCharacter *pChar = World.GetCharacterById(i))
+			{
+				CNetObj_PlayerInput Input;
+				RandomInput(&Input);
+				pChar->OnDirectInput(&Input);
+				pChar->OnPredictedInput(&Input);
+			}
+		}
+		World.m_GameTick = Tick;
+		World.Tick();
+	}
+
+public:
+	bool Init(IMap *pMap, int NumCharacters)
+	{
+		m_Layers.Init(pMap, true, false);
+		if(!m_Layers.GameLayer())
+		{
+			log_error(TOOL_NAME, "Map has no game layer");
+			return false;
+		}
+		m_Collision.Init(&m_Layers);
+		m_MapBugs = CMapBugs::Create(pMap->BaseName(), pMap->Size(), pMap->Sha256());
+
+		m_GameWorld.Init(&m_Collision, m_aTuningList, &m_MapBugs);
+		ConfigureWorld(m_GameWorld);
+		m_NumCharacters = std::clamp(NumCharacters, 1, (int)MAX_CLIENTS);
+
+		std::vector<vec2> vSpawns;
+		SpawnPositions(vSpawns);
+
+		CTeamsCore Teams;
+		Teams.Reset();
+		m_GameWorld.NetObjBegin(Teams, 0);
+		for(int i = 0; i < m_NumCharacters; i++)
+		{
+			const vec2 Pos = vSpawns[i % vSpawns.size()];
+			CNetObj_Character Char;
+			mem_zero(&Char, sizeof(Char));
+			Char.m_X = round_to_int(Pos.x);
+			Char.m_Y = round_to_int(Pos.y);
+			Char.m_Weapon = WEAPON_GRENADE;
+			Char.m_HookState = HOOK_IDLE;
+			Char.m_HookedPlayer = -1;
+			Char.m_Health = 10;
+			m_GameWorld.NetCharAdd(i, &Char, nullptr, 0, i == 0);
+		}
+		m_GameWorld.NetObjEnd();
+		return true;
+	}
+
+	int NumEntities()
+	{
+		int Num = 0;
+		for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+			for(CEntity *pEnt = m_PredictedWorld.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+				Num++;
+		return Num;
+	}
+
+	void Run(int NumFrames, int PredictionTicks)
+	{
+		std::vector<int64_t> vFrameTimes;
+		vFrameTimes.reserve(NumFrames);
+		int64_t CopyTime = 0;
+		int64_t MaxEntities = 0;
+		int64_t SumEntities = 0;
+
+		for(int Frame = 0; Frame < NumFrames; Frame++)
+		{
+			// advance the authoritative world by one tick, as a new snapshot would
+			TickWorld(m_GameWorld, Frame + 1);
+
+			const int64_t Start = time_get();
+			m_PredictedWorld.CopyWorld(&m_GameWorld);
+			CopyTime += time_get() - Start;
+			for(int Tick = m_GameWorld.GameTick() + 1; Tick <= m_GameWorld.GameTick() + PredictionTicks; Tick++)
+			{
+				TickWorld(m_PredictedWorld, Tick);
+				if(Tick == m_GameWorld.GameTick() + PredictionTicks - 1)
+				{
+					const int64_t CopyStart = time_get();
+					m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
+					CopyTime += time_get() - CopyStart;
+				}
+			}
+			vFrameTimes.push_back(time_get() - Start);
+
+			const int Entities = NumEntities();
+			MaxEntities = std::max<int64_t>(MaxEntities, Entities);
+			SumEntities += Entities;
+		}
+
+		std::sort(vFrameTimes.begin(), vFrameTimes.end());
+		int64_t Total = 0;
+		for(int64_t Time : vFrameTimes)
+			Total += Time;
+		const double UsPerTick = 1000000.0 / time_freq();
+		log_info(TOOL_NAME, "%d frames, %d characters, %d prediction ticks, %.1f entities on average (max %d)",
+			NumFrames, m_NumCharacters, PredictionTicks, (double)SumEntities / NumFrames, (int)MaxEntities);
+		log_info(TOOL_NAME, "per frame: mean %.2fus, median %.2fus, p99 %.2fus, max %.2fus",
+			Total * UsPerTick / NumFrames,
+			vFrameTimes[NumFrames / 2] * UsPerTick,
+			vFrameTimes[std::min(NumFrames - 1, NumFrames * 99 / 100)] * UsPerTick,
+			vFrameTimes.back() * UsPerTick);
+		log_info(TOOL_NAME, "world copies: mean %.2fus per frame", CopyTime * UsPerTick / NumFrames);
+	}
+};
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc < 2 || argc > 5)
+	{
+		log_error(TOOL_NAME, "Usage: %s <map> [characters=32] [frames=2000] [prediction ticks=10]", TOOL_NAME);
+		return -1;
+	}
+	const char *pMapPath = argv[1];
+	const int NumCharacters = argc > 2 ? str_toint(argv[2]) : 32;
+	const int NumFrames = argc > 3 ? str_toint(argv[3]) : 2000;
+	const int PredictionTicks = argc > 4 ? str_toint(argv[4]) : 10;
+	if(NumFrames <= 0 || PredictionTicks <= 0)
+	{
+		log_error(TOOL_NAME, "Frames and prediction ticks must be positive");
+		return -1;
+	}
+
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+
+	std::unique_ptr<IMap> pMap = CreateMap();
+	if(!pMap->Load(pStorage.get(), pMapPath, IStorage::TYPE_ABSOLUTE))
+	{
+		log_error(TOOL_NAME, "Failed to open map '%s' for reading", pMapPath);
+		return -1;
+	}
+
+	// too large for the stack because of the tune zones
+	std::unique_ptr<CPredictionBench> pBench = std::make_unique<CPredictionBench>();
+	if(!pBench->Init(pMap.get(), NumCharacters))
+		return -1;
+	pBench->Run(NumFrames, PredictionTicks);
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/client/sound_mix.h>
+
+#include <game/prng.h>
+
+#include <algorithm>
+#include <vector>
+
+static const char *TOOL_NAME = "sound_mix_bench";
+
+static const unsigned MIX_FRAMES = 1024;
+static const unsigned SAMPLE_FRAMES = 48000;
+
+class CBenchVoice
+{
+public:
+	int m_Channels;
+	unsigned m_Tick;
+	int m_VolumeL;
+	int m_VolumeR;
+};
+
+typedef void (*FMixVoice)(int *pOut, const short *pIn, int Channels, unsigned Frames, int VolumeL, int VolumeR);
+
+// mixes all voices like CSound::Mix, without the volume calculation
+static int64_t MixAll(FMixVoice pfnMixVoice, const std::vector<short> &vSamples, std::vector<CBenchVoice> vVoices, std::vector<int> &vMixBuffer, std::vector<short> &vOut)
+{
+	const int64_t Start = time_get_impl();
+	std::fill(vMixBuffer.begin(), vMixBuffer.end(), 0);
+	for(CBenchVoice &Voice : vVoices)
+	{
+		const unsigned Frames = std::min(MIX_FRAMES, SAMPLE_FRAMES - Voice.m_Tick);
+		pfnMixVoice(vMixBuffer.data(), vSamples.data() + Voice.m_Tick * Voice.m_Channels, Voice.m_Channels, Frames, Voice.m_VolumeL, Voice.m_VolumeR);
+		Voice.m_Tick += Frames;
+	}
+	MixToOutput(vOut.data(), vMixBuffer.data(), MIX_FRAMES * 2, 100);
+	return time_get_impl() - Start;
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s [voices=256] [repetitions=1000]", TOOL_NAME);
+		return -1;
+	}
+	const int NumVoices = argc > 1 ? str_toint(argv[1]) : 256;
+	const int Repetitions = argc > 2 ? str_toint(argv[2]) : 1000;
+	if(NumVoices <= 0 || Repetitions <= 0)
+	{
+		log_error(TOOL_NAME, "Voices and repetitions must be positive");
+		return -1;
+	}
+
+	// the same samples and voices in every run, to compare versions
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+	std::vector<short> vSamples(SAMPLE_FRAMES * 2);
+	for(short &Sample : vSamples)
+		Sample = (short)(Prng.RandomBits() % 65536 - 32768);
+	std::vector<CBenchVoice> vVoices(NumVoices);
+	for(CBenchVoice &Voice : vVoices)
+	{
+		Voice.m_Channels = 1 + Prng.RandomBits() % 2;
+		Voice.m_Tick = Prng.RandomBits() % (SAMPLE_FRAMES - MIX_FRAMES);
+		Voice.m_VolumeL = Prng.RandomBits() % 256;
+		Voice.m_VolumeR = Prng.RandomBits() % 256;
+	}
+
+	std::vector<int> vMixBuffer(MIX_FRAMES * 2);
+	std::vector<short> vScalarOut(MIX_FRAMES * 2);
+	std::vector<short> vOut(MIX_FRAMES * 2);
+	std::vector<int64_t> vScalarTimes;
+	std::vector<int64_t> vTimes;
+	for(int i = 0; i < Repetitions; i++)
+	{
+		vScalarTimes.push_back(MixAll(MixVoiceScalar, vSamples, vVoices, vMixBuffer, vScalarOut));
+		vTimes.push_back(MixAll(MixVoice, vSamples, vVoices, vMixBuffer, vOut));
+	}
+	if(vOut != vScalarOut)
+	{
+		log_error(TOOL_NAME, "Mixed output differs from the scalar mix");
+		return -1;
+	}
+
+	std::sort(vScalarTimes.begin(), vScalarTimes.end());
+	std::sort(vTimes.begin(), vTimes.end());
+	const double UsPerTick = 1000000.0 / time_freq();
+	const double ScalarMedian = vScalarTimes[Repetitions / 2] * UsPerTick;
+	const double Median = vTimes[Repetitions / 2] * UsPerTick;
+	log_info(TOOL_NAME, "%d voices, %u frames per mix, %d repetitions", NumVoices, MIX_FRAMES, Repetitions);
+	log_info(TOOL_NAME, "scalar: median %.2fus per mix, %.3fns per voice frame", ScalarMedian, ScalarMedian * 1000.0 / NumVoices / MIX_FRAMES);
+	log_info(TOOL_NAME, "vectorized: median %.2fus per mix, %.3fns per voice frame (%.2fx)", Median, Median * 1000.0 / NumVoices / MIX_FRAMES, ScalarMedian / Median);
+	return 0;
+}